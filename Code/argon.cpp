@@ -1,25 +1,147 @@
 #define _USE_MATH_DEFINES
 #include "argon.h"
+#include "profile.h"
+#include "stats.h"
 #include <cmath>
 #include <ctime>
 #include <iostream>
 #include <string>
 #include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <numeric>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
 
 /**************************************************************************************
  * Default constructor initializes example parameters and memory to store informations
  * about the system. It also prints appropriate messages.
  * @return Nothing to return.
  *************************************************************************************/
-Argon::Argon() noexcept : n(6), So(5000), Sd(50000), Sout(500), Sxyz(500), m(40.), e(1.),
-                          R(0.38), k(8.31e-3), f(1e4), L(6.), a(0.38), T0(1e4), tau(1e-3),
-                          initialStateCheck(false), mt(std::mt19937(time(nullptr)))
+Argon::Argon() noexcept : Argon(std::cout, std::cerr)
 {
-    N = n * n * n; // System is defined as 3D
+}
+
+/**************************************************************************************
+ * Constructor which prints all messages to the given streams instead of the standard
+ * output and error (e.g. log file of the replica in the batch mode).
+ * @param ostream stream of messages,
+ * @param ostream stream of errors.
+ * @return Nothing to return.
+ *************************************************************************************/
+Argon::Argon(std::ostream &outStream, std::ostream &errStream) noexcept : out(&outStream), err(&errStream), n(6), nx(6), ny(6), nz(6), So(5000), Sd(50000), Sout(500), Sxyz(500), m(40.), e(1.),
+                          R(0.38), k(8.31e-3), f(1e4), L(6.), L0(6.), a(0.38), T0(1e4), tau(1e-3), respa(1),
+                          adaptive(false), tauMin(1e-4), tauMax(1e-2), dxMax(0.02), dHMax(1e-4), Sadapt(1000),
+                          thermostatEq(ThermostatKind::None), thermostatProd(ThermostatKind::None), Ttarget(0.), tauT(0.1),
+                          chain(3), barostatEq(BarostatKind::Off), barostatProd(BarostatKind::Off), Ptarget(0.), tauP(1.),
+                          boundary(Boundary::Sphere), box{0., 0., 0.}, tail(true),
+                          engine(Engine::Exact), rc(0.85), skin(0.1), isa(Isa::Auto), precision(Precision::Double),
+                          potential(Potential::Analytic), tableSize(4096), threads(1), Ssort(0), curve(Curve::Hilbert),
+                          trajectory(TrajectoryFormat::Text), asyncOutput(false), outputSlots(4),
+                          Schk(0), checkpoint("checkpoint.bin"), Sgr(0), grMax(0.85), grBins(200),
+                          rdfFile("rdf.txt"), structure(false), Scorr(0), corrPoints(16), corrFile("msd.txt"),
+                          initialStateCheck(false), seed(time(nullptr))
+{
+#ifdef ARGON_MPI
+    // Ranks of the MPI run share the system by the domain decomposition
+    int initialized = 0, size = 1;
+    MPI_Initialized(&initialized);
+
+    if (initialized)
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    distributed = (size > 1);
+
+    if (distributed)
+        domain.attach(MPI_COMM_WORLD);
+
+    // Only rank 0 prints messages and errors, all ranks validate the same parameters
+    if (distributed && domain.getRank() > 0)
+        out = err = &quiet;
+#endif
+
+    *out << "`Argon()` :> Initialized parameters to default values." << '\n';
+    *out << "`Argon()` :> Set counter-based pseudo-random number generator Philox4x32-10." << '\n';
+
+    b0 = b1 = b2 = p = pAbs = nullptr;
+    stats = nullptr;
+    allocate();
+
+    *out << "`Argon()` :> Allocated memory for buffer.\n\n";
+}
+
+/**************************************************************************************
+ * Estimates memory of the run with the current parameters: arrays of atoms, force
+ * buffers of threads, the Verlet list (about 46 neighbours of every atom) and slots
+ * of the background writer.
+ * @return Number of bytes.
+ *************************************************************************************/
+uint64_t Argon::requiredMemory() const noexcept
+{
+    uint64_t atoms = static_cast<uint64_t>(nx) * ny * nz;
+    uint64_t gathered = 0;
+    const uint64_t vector = 3 * sizeof(double);
+    const uint64_t workers = (threads == 0) ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+
+#ifdef ARGON_MPI
+    // Ranks keep their domains with ghosts (at most about as many as atoms), rank 0 also
+    // positions and momenta of the whole system gathered for the output
+    if (distributed)
+    {
+        gathered = (domain.getRank() == 0) ? atoms * (3 * vector + sizeof(double)) : 0;
+        atoms = 2 * atoms / domain.getRanks() + 1;
+    }
+#endif
+
+    // Positions, momenta, forces, absolute momenta and buffers of other threads
+    uint64_t bytes = atoms * (3 * vector + sizeof(double) + (workers - 1) * vector);
+
+    if (respa > 1)
+        bytes += atoms * vector;
+    if (precision == Precision::Mixed)
+        bytes += atoms * 3 * sizeof(float);
+    if (engine == Engine::Verlet)
+        bytes += atoms * (46 * sizeof(uint) + vector + 3 * sizeof(uint));
+    if (boundary == Boundary::Periodic)
+        bytes += atoms * 5 * vector;
+    if (asyncOutput)
+        bytes += atoms * outputSlots * vector;
+    if (Ssort > 0)
+        bytes += atoms * (vector + sizeof(uint64_t) + 2 * sizeof(uint));
+    if (Sgr > 0)
+        bytes += atoms * 10 * sizeof(uint) + grBins * sizeof(uint64_t);
+    if (Scorr > 0)
+        bytes += MultiTauCorrelator::bytes(atoms, corrPoints, MultiTauCorrelator::levelsFor(Sd / Scorr, corrPoints));
+
+    return bytes + gathered;
+}
+
+/**************************************************************************************
+ * Releases buffers and allocates them again for N = nx ny nz atoms (the system is
+ * defined as 3D).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::allocate()
+{
+    delete[] b0;
+    delete[] b1;
+    delete[] b2;
+
+    delete[] p;
+    delete[] pAbs;
+
+    b0 = b1 = b2 = p = pAbs = nullptr;
+
+    N = nx * ny * nz;
     K = 3;
 
-    std::cout << "`Argon()` :> Initialized parameters to default values." << '\n';
-    std::cout << "`Argon()` :> Set pseudo-random number generator std::mt19937." << '\n';
+#ifdef ARGON_MPI
+    // Other ranks keep only atoms of their domains, the whole system is gathered on rank 0
+    const uint rows = (distributed && domain.getRank() > 0) ? 0 : N;
+#else
+    const uint rows = N;
+#endif
 
     // Allocate memory and immediately set the values
     b0 = new double[K]{a, 0., 0.};
@@ -29,32 +151,15 @@ Argon::Argon() noexcept : n(6), So(5000), Sd(50000), Sout(500), Sxyz(500), m(40.
     // Note the parenthesis at the end of new. These caused the allocated memory's
     // value to be set to zero (value-initialize)
     p = new double[K]();
-    pAbs = new double[N]();
-    Vs = new double[N]();
-
-    r0 = new double *[N]();
-    p0 = new double *[N]();
-    Vp = new double *[N]();
-    Fs = new double *[N]();
-    Fi = new double *[N]();
-
-    Fp = new double **[N]();
+    pAbs = new double[rows]();
 
-    for (usint i = 0; i < N; i++)
-    {
-        r0[i] = new double[K]();
-        p0[i] = new double[K]();
-        Vp[i] = new double[N]();
-        Fs[i] = new double[K]();
-        Fi[i] = new double[K]();
-
-        Fp[i] = new double *[N]();
-
-        for (usint j = 0; j < N; j++)
-            Fp[i][j] = new double[K]();
-    }
+    // Contiguous and aligned arrays of vectors (structure of arrays)
+    r0.resize(rows);
+    p0.resize(rows);
+    Fi.resize(rows);
 
-    std::cout << "`Argon()` :> Allocated memory for buffer.\n\n";
+    ids.resize(rows);
+    std::iota(ids.begin(), ids.end(), 0u);
 }
 
 /**************************************************************************************
@@ -69,31 +174,8 @@ Argon::~Argon() noexcept
 
     delete[] p;
     delete[] pAbs;
-    delete[] Vs;
 
-    for (usint i = 0; i < N; i++)
-    {
-        delete[] r0[i];
-        delete[] p0[i];
-        delete[] Vp[i];
-        delete[] Fs[i];
-        delete[] Fi[i];
-
-        for (usint j = 0; j < N; j++)
-            delete[] Fp[i][j];
-
-        delete[] Fp[i];
-    }
-
-    delete[] r0;
-    delete[] p0;
-    delete[] Vp;
-    delete[] Fs;
-    delete[] Fi;
-
-    delete[] Fp;
-
-    std::cout << "`~Argon()` :> Memory released.\n\n";
+    *out << "`~Argon()` :> Memory released.\n\n";
 }
 
 /**************************************************************************************
@@ -102,28 +184,289 @@ Argon::~Argon() noexcept
  * handling for invalid parameters and files. If something has gone wrong, then
  * the function set default parameters and print appropriate message.
  * @param char* filename with parameters to set.
- * @return Nothing to return.
+ * @return True if parameters are set from the file, false if defaults are restored.
  *************************************************************************************/
-void Argon::setParameters(const char *filename)
+bool Argon::setParameters(const char *filename)
+{
+    std::ifstream input("../Config/" + std::string(filename), std::ios::in);
+    return setParameters(input, "../Config/" + std::string(filename));
+}
+
+/**************************************************************************************
+ * This function reads parameters from the given stream, in the same format as the
+ * input file (e.g. prepared in memory by benchmarks).
+ * @param istream stream with parameters to set,
+ * @param string name of the source to print in messages.
+ * @return True if parameters are set from the stream, false if defaults are restored.
+ *************************************************************************************/
+bool Argon::setParameters(std::istream &input, const std::string &source)
 {
-    std::ifstream input;
     std::string tmp;
 
     try
     {
-        input.open("../Config/" + std::string(filename), std::ios::in);
-
         if (input.fail())
             throw std::ifstream::failure("Exception opening/reading parameters input file.");
 
         if (fileIsEmpty(input))
             throw std::ifstream::failure("Exception parameters input file is empty.");
 
+        // Edges of the crystal are optional, 0 means n
+        nx = ny = nz = 0;
+
+        // Edges of the periodic box are optional, 0 means the period of the crystal
+        box[0] = box[1] = box[2] = 0.;
+
+        // Thermostats and barostats of both phases are chosen by the same names
+        auto readThermostat = [&input, &tmp](const std::string &name)
+        {
+            input >> tmp;
+
+            if (tmp == "none")
+                return ThermostatKind::None;
+            if (tmp == "rescale")
+                return ThermostatKind::Rescale;
+            if (tmp == "berendsen")
+                return ThermostatKind::Berendsen;
+            if (tmp == "nosehoover")
+                return ThermostatKind::NoseHoover;
+            if (tmp == "langevin")
+                return ThermostatKind::Langevin;
+
+            throw std::invalid_argument("Invalid argument: " + name + ". Must be none, rescale, berendsen, nosehoover or langevin.");
+        };
+
+        auto readBarostat = [&input, &tmp](const std::string &name)
+        {
+            input >> tmp;
+
+            if (tmp == "off")
+                return BarostatKind::Off;
+            if (tmp == "berendsen")
+                return BarostatKind::Berendsen;
+
+            throw std::invalid_argument("Invalid argument: " + name + ". Must be off or berendsen.");
+        };
+
         input >> tmp >> n >> tmp >> m >> tmp >> e >> tmp >> R >> tmp >> k >> tmp >> f >> tmp >> L >> tmp >> a;
         input >> tmp >> T0 >> tmp >> tau >> tmp >> So >> tmp >> Sd >> tmp >> Sout >> tmp >> Sxyz;
 
-        if (n < 1 || n > 25)
-            throw std::invalid_argument("Invalid argument: n. Must be between 1 and 25.");
+        // Optional parameters written as `name value` pairs after the basic ones
+        while (input >> tmp)
+        {
+            if (tmp == "nx")
+                input >> nx;
+            else if (tmp == "ny")
+                input >> ny;
+            else if (tmp == "nz")
+                input >> nz;
+            else if (tmp == "engine")
+            {
+                input >> tmp;
+
+                if (tmp == "exact")
+                    engine = Engine::Exact;
+                else if (tmp == "verlet")
+                    engine = Engine::Verlet;
+                else
+                    throw std::invalid_argument("Invalid argument: engine. Must be exact or verlet.");
+            }
+            else if (tmp == "rc")
+                input >> rc;
+            else if (tmp == "skin")
+                input >> skin;
+            else if (tmp == "simd")
+            {
+                input >> tmp;
+
+                if (tmp == "auto")
+                    isa = Isa::Auto;
+                else if (tmp == "scalar")
+                    isa = Isa::Scalar;
+                else if (tmp == "avx2")
+                    isa = Isa::AVX2;
+                else if (tmp == "avx512")
+                    isa = Isa::AVX512;
+                else
+                    throw std::invalid_argument("Invalid argument: simd. Must be auto, scalar, avx2 or avx512.");
+            }
+            else if (tmp == "threads")
+                input >> threads;
+            else if (tmp == "Ssort")
+                input >> Ssort;
+            else if (tmp == "curve")
+            {
+                input >> tmp;
+
+                if (tmp == "morton")
+                    curve = Curve::Morton;
+                else if (tmp == "hilbert")
+                    curve = Curve::Hilbert;
+                else
+                    throw std::invalid_argument("Invalid argument: curve. Must be morton or hilbert.");
+            }
+            else if (tmp == "precision")
+            {
+                input >> tmp;
+
+                if (tmp == "double")
+                    precision = Precision::Double;
+                else if (tmp == "mixed")
+                    precision = Precision::Mixed;
+                else
+                    throw std::invalid_argument("Invalid argument: precision. Must be double or mixed.");
+            }
+            else if (tmp == "potential")
+            {
+                input >> tmp;
+
+                if (tmp == "analytic")
+                    potential = Potential::Analytic;
+                else if (tmp == "table")
+                    potential = Potential::Table;
+                else
+                    throw std::invalid_argument("Invalid argument: potential. Must be analytic or table.");
+            }
+            else if (tmp == "tableSize")
+                input >> tableSize;
+            else if (tmp == "trajectory")
+            {
+                input >> tmp;
+
+                if (tmp == "text")
+                    trajectory = TrajectoryFormat::Text;
+                else if (tmp == "float32")
+                    trajectory = TrajectoryFormat::Float32;
+                else if (tmp == "int16")
+                    trajectory = TrajectoryFormat::Int16;
+                else
+                    throw std::invalid_argument("Invalid argument: trajectory. Must be text, float32 or int16.");
+            }
+            else if (tmp == "output")
+            {
+                input >> tmp;
+
+                if (tmp == "sync")
+                    asyncOutput = false;
+                else if (tmp == "async")
+                    asyncOutput = true;
+                else
+                    throw std::invalid_argument("Invalid argument: output. Must be sync or async.");
+            }
+            else if (tmp == "outputSlots")
+                input >> outputSlots;
+            else if (tmp == "Schk")
+                input >> Schk;
+            else if (tmp == "checkpoint")
+                input >> checkpoint;
+            else if (tmp == "respa")
+                input >> respa;
+            else if (tmp == "adaptive")
+            {
+                input >> tmp;
+
+                if (tmp == "off")
+                    adaptive = false;
+                else if (tmp == "on")
+                    adaptive = true;
+                else
+                    throw std::invalid_argument("Invalid argument: adaptive. Must be off or on.");
+            }
+            else if (tmp == "tauMin")
+                input >> tauMin;
+            else if (tmp == "tauMax")
+                input >> tauMax;
+            else if (tmp == "dxMax")
+                input >> dxMax;
+            else if (tmp == "dHMax")
+                input >> dHMax;
+            else if (tmp == "Sadapt")
+                input >> Sadapt;
+            else if (tmp == "seed")
+                input >> seed;
+            else if (tmp == "thermostatEq")
+                thermostatEq = readThermostat("thermostatEq");
+            else if (tmp == "thermostatProd")
+                thermostatProd = readThermostat("thermostatProd");
+            else if (tmp == "Ttarget")
+                input >> Ttarget;
+            else if (tmp == "tauT")
+                input >> tauT;
+            else if (tmp == "chain")
+                input >> chain;
+            else if (tmp == "barostatEq")
+                barostatEq = readBarostat("barostatEq");
+            else if (tmp == "barostatProd")
+                barostatProd = readBarostat("barostatProd");
+            else if (tmp == "Ptarget")
+                input >> Ptarget;
+            else if (tmp == "tauP")
+                input >> tauP;
+            else if (tmp == "boundary")
+            {
+                input >> tmp;
+
+                if (tmp == "sphere")
+                    boundary = Boundary::Sphere;
+                else if (tmp == "periodic")
+                    boundary = Boundary::Periodic;
+                else
+                    throw std::invalid_argument("Invalid argument: boundary. Must be sphere or periodic.");
+            }
+            else if (tmp == "Lx")
+                input >> box[0];
+            else if (tmp == "Ly")
+                input >> box[1];
+            else if (tmp == "Lz")
+                input >> box[2];
+            else if (tmp == "tail")
+            {
+                input >> tmp;
+
+                if (tmp == "off")
+                    tail = false;
+                else if (tmp == "on")
+                    tail = true;
+                else
+                    throw std::invalid_argument("Invalid argument: tail. Must be off or on.");
+            }
+            else if (tmp == "Sgr")
+                input >> Sgr;
+            else if (tmp == "grMax")
+                input >> grMax;
+            else if (tmp == "grBins")
+                input >> grBins;
+            else if (tmp == "rdf")
+                input >> rdfFile;
+            else if (tmp == "Scorr")
+                input >> Scorr;
+            else if (tmp == "corrPoints")
+                input >> corrPoints;
+            else if (tmp == "corr")
+                input >> corrFile;
+            else if (tmp == "structure")
+            {
+                input >> tmp;
+
+                if (tmp == "off")
+                    structure = false;
+                else if (tmp == "on")
+                    structure = true;
+                else
+                    throw std::invalid_argument("Invalid argument: structure. Must be off or on.");
+            }
+            else
+                throw std::invalid_argument("Invalid argument: " + tmp + ". Unknown parameter.");
+        }
+
+        nx = (nx == 0) ? n : nx;
+        ny = (ny == 0) ? n : ny;
+        nz = (nz == 0) ? n : nz;
+
+        if (n < 1)
+            throw std::invalid_argument("Invalid argument: n. Must be at least 1.");
+        if (static_cast<uint64_t>(nx) * ny * nz > MaxAtoms)
+            throw std::invalid_argument("Invalid argument: n. Number of atoms nx ny nz must not exceed 2^26.");
         if (m < 0.)
             throw std::invalid_argument("Invalid argument: m. Must be positive.");
         if (e < 0.)
@@ -134,8 +477,8 @@ void Argon::setParameters(const char *filename)
             throw std::invalid_argument("Invalid argument: k. Must be between 0 and 1.");
         if (f < 0.)
             throw std::invalid_argument("Invalid argument: f. Must be positive.");
-        if (L < 1.22 * (n - 1) * a)
-            throw std::invalid_argument("Invalid argument: L. Must be greater than 1.22(n-1)a.");
+        if (boundary == Boundary::Sphere && L < 1.22 * (std::max({nx, ny, nz}) - 1) * a)
+            throw std::invalid_argument("Invalid argument: L. Must be greater than 1.22(n-1)a (n of the longest edge).");
         if (a < 0.)
             throw std::invalid_argument("Invalid argument: a. Must be positive.");
         if (T0 < 0.)
@@ -150,131 +493,258 @@ void Argon::setParameters(const char *filename)
             throw std::invalid_argument("Invalid argument: Sout. Must be between 0 and Sd.");
         if (Sxyz < 0 || Sxyz > Sd)
             throw std::invalid_argument("Invalid argument: Sxyz. Must be between 0 and Sd.");
-
-        std::cout << "`setParameters()` :> Successfully set parameters from ../Config/" << filename << '\n';
-
-        // N and K are still the same so I can carefully release the memory
-        delete[] b0;
-        delete[] b1;
-        delete[] b2;
-
-        delete[] p;
-        delete[] pAbs;
-        delete[] Vs;
-
-        for (usint i = 0; i < N; i++)
+        if (rc <= 0.)
+            throw std::invalid_argument("Invalid argument: rc. Must be positive.");
+        if (skin < 0.)
+            throw std::invalid_argument("Invalid argument: skin. Must be non-negative.");
+        if (outputSlots < 2)
+            throw std::invalid_argument("Invalid argument: outputSlots. Must be at least 2.");
+        if (respa < 1)
+            throw std::invalid_argument("Invalid argument: respa. Must be at least 1.");
+        if (adaptive && (tauMin <= 0. || tauMin > tau))
+            throw std::invalid_argument("Invalid argument: tauMin. Must be between 0 and tau.");
+        if (adaptive && (tauMax < tau || tauMax > 1e-1))
+            throw std::invalid_argument("Invalid argument: tauMax. Must be between tau and 1e-1.");
+        if (dxMax <= 0.)
+            throw std::invalid_argument("Invalid argument: dxMax. Must be positive.");
+        if (dHMax <= 0.)
+            throw std::invalid_argument("Invalid argument: dHMax. Must be positive.");
+        if (Sadapt < 1)
+            throw std::invalid_argument("Invalid argument: Sadapt. Must be at least 1.");
+        if (potential == Potential::Table && (engine != Engine::Verlet || precision != Precision::Double))
+            throw std::invalid_argument("Invalid argument: potential. Table requires engine verlet and precision double.");
+        if (tableSize < 16 || tableSize > (1u << 24))
+            throw std::invalid_argument("Invalid argument: tableSize. Must be between 16 and 2^24.");
+        if (Ssort > 0 && engine != Engine::Verlet)
+            throw std::invalid_argument("Invalid argument: Ssort. Sorting of atoms requires engine verlet.");
+        if (grMax <= 0. || (boundary == Boundary::Sphere && grMax > 2. * L))
+            throw std::invalid_argument("Invalid argument: grMax. Must be between 0 and 2L.");
+        if (grBins < 1 || grBins > (1u << 20))
+            throw std::invalid_argument("Invalid argument: grBins. Must be between 1 and 2^20.");
+        if (corrPoints < 4 || corrPoints > 1024 || corrPoints % 2 != 0)
+            throw std::invalid_argument("Invalid argument: corrPoints. Must be even and between 4 and 1024.");
+        if (Ttarget < 0.)
+            throw std::invalid_argument("Invalid argument: Ttarget. Must be positive.");
+        if (tauT <= 0.)
+            throw std::invalid_argument("Invalid argument: tauT. Must be positive.");
+        if (chain < 1 || chain > 16)
+            throw std::invalid_argument("Invalid argument: chain. Must be between 1 and 16.");
+        if ((barostatEq != BarostatKind::Off || barostatProd != BarostatKind::Off) && Ptarget <= 0.)
+            throw std::invalid_argument("Invalid argument: Ptarget. Must be positive with the barostat.");
+        if (tauP <= 0.)
+            throw std::invalid_argument("Invalid argument: tauP. Must be positive.");
+        if (adaptive && (thermostatEq != ThermostatKind::None || thermostatProd != ThermostatKind::None ||
+                         barostatEq != BarostatKind::Off || barostatProd != BarostatKind::Off))
+            throw std::invalid_argument("Invalid argument: adaptive. Must be off with a thermostat or barostat (H is not conserved).");
+        if (barostatProd != BarostatKind::Off && Sgr > 0)
+            throw std::invalid_argument("Invalid argument: barostatProd. Must be off with Sgr (g(r) is normalised by the constant sphere).");
+
+        if (boundary == Boundary::Periodic)
         {
-            delete[] r0[i];
-            delete[] p0[i];
-            delete[] Vp[i];
-            delete[] Fs[i];
-            delete[] Fi[i];
-
-            for (usint j = 0; j < N; j++)
-                delete[] Fp[i][j];
+            // Layers of the crystal (5) repeat after 2 rows along b1 and 3 layers along b2,
+            // so the crystal of these edges fills the box of its period without defects
+            const double period[3] = {nx * a, ny * a * sqrt(3.) * 0.5, nz * a * sqrt(6.) / 3.};
+            const char *names[3] = {"Lx", "Ly", "Lz"};
+
+            if (engine != Engine::Verlet)
+                throw std::invalid_argument("Invalid argument: boundary. Periodic box requires engine verlet.");
+            if (respa > 1)
+                throw std::invalid_argument("Invalid argument: respa. Must be 1 in the periodic box (no walls).");
+            if (barostatEq != BarostatKind::Off || barostatProd != BarostatKind::Off)
+                throw std::invalid_argument("Invalid argument: boundary. Barostat moves the sphere walls, periodic box requires it off.");
+            if (ny % 2 != 0 || nz % 3 != 0)
+                throw std::invalid_argument("Invalid argument: ny. Must be even and nz a multiple of 3 in the periodic box.");
+            if (Sgr > 0 && grMax > rc)
+                throw std::invalid_argument("Invalid argument: grMax. Must not exceed rc in the periodic box.");
+
+            for (uint j = 0; j < 3; j++)
+            {
+                box[j] = (box[j] == 0.) ? period[j] : box[j];
 
-            delete[] Fp[i];
+                if (box[j] < period[j])
+                    throw std::invalid_argument("Invalid argument: " + std::string(names[j]) + ". Must not be smaller than the period of the crystal.");
+                if (box[j] < 2. * rc || box[j] < rc + skin)
+                    throw std::invalid_argument("Invalid argument: " + std::string(names[j]) + ". Must be at least 2 rc and rc + skin (minimum image).");
+            }
         }
 
-        delete[] r0;
-        delete[] p0;
-        delete[] Vp;
-        delete[] Fs;
-        delete[] Fi;
-
-        delete[] Fp;
-
-        // Here I can set the new values
-        N = n * n * n;
-        K = 3;
-
-        b0 = new double[K]{a, 0., 0.};
-        b1 = new double[K]{a * 0.5, a * sqrt(3.) * 0.5, 0.};
-        b2 = new double[K]{a * 0.5, a * sqrt(3.) / 6., a * sqrt(6.) / 3.};
+#ifdef ARGON_MPI
+        if (distributed)
+        {
+            // Domains exchange only positions, forces and migrating atoms (NVE)
+            const std::pair<const char *, bool> unsupported[] = {
+                {"thermostatEq", thermostatEq != ThermostatKind::None}, {"thermostatProd", thermostatProd != ThermostatKind::None},
+                {"adaptive", adaptive}, {"Ssort", Ssort > 0}, {"output", asyncOutput}, {"Schk", Schk > 0}, {"Sgr", Sgr > 0},
+                {"Scorr", Scorr > 0}};
+
+            if (boundary != Boundary::Periodic)
+                throw std::invalid_argument("Invalid argument: boundary. Must be periodic with several MPI ranks (domain decomposition).");
+
+            for (const auto &[name, used] : unsupported)
+                if (used)
+                    throw std::invalid_argument("Invalid argument: " + std::string(name) + ". Not available with several MPI ranks (domain decomposition).");
+
+            int dims[3];
+            Domain::grid(domain.getRanks(), dims);
+
+            for (uint j = 0; j < 3; j++)
+                if (box[j] / dims[j] < rc + skin)
+                    throw std::invalid_argument("Invalid argument: n. Domains of " + std::to_string(domain.getRanks()) +
+                                                " ranks must be at least rc + skin along every edge (fewer ranks or larger box).");
+        }
+#endif
 
-        p = new double[K]();
-        pAbs = new double[N]();
-        Vs = new double[N]();
+        L0 = L;
 
-        r0 = new double *[N]();
-        p0 = new double *[N]();
-        Vp = new double *[N]();
-        Fs = new double *[N]();
-        Fi = new double *[N]();
+        const uint64_t required = requiredMemory();
+        const uint64_t physical = static_cast<uint64_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGE_SIZE);
 
-        Fp = new double **[N]();
+        if (physical > 0 && required > physical)
+            throw std::invalid_argument("Invalid argument: n. The run needs about " + std::to_string(required >> 20) +
+                                        " MB, more than " + std::to_string(physical >> 20) + " MB of memory.");
 
-        for (usint i = 0; i < N; i++)
-        {
-            r0[i] = new double[K]();
-            p0[i] = new double[K]();
-            Vp[i] = new double[N]();
-            Fs[i] = new double[K]();
-            Fi[i] = new double[K]();
+        *out << "`setParameters()` :> Successfully set parameters from " << source << '\n';
 
-            Fp[i] = new double *[N]();
+        allocate();
 
-            for (usint j = 0; j < N; j++)
-                Fp[i][j] = new double[K]();
-        }
+        *out << "`setParameters()` :> Successfully reallocated memory for new parameters.\n\n";
 
-        input.close();
-        std::cout << "`setParameters()` :> Successfully reallocated memory for new parameters.\n\n";
+        return true;
     }
     catch (const std::invalid_argument &error)
     {
-        // Notice I do not need to reallocate memory because of default parameters
-        // and buffer have the same sizes
-        n = 6;
-        So = 5000;
-        Sd = 50000;
-        Sout = 500;
-        Sxyz = 500;
-        m = 40.;
-        R = 0.38;
-        e = 1.;
-        k = 8.31e-3;
-        f = 1e4;
-        L = 6.;
-        a = 0.38;
-        T0 = 1e4;
-        tau = 1e-3;
-
-        input.close();
-        std::cerr << "`setParameters()` :> Exception while setting parameters from ../Config/" << filename << '\n';
-        std::cerr << "`setParameters()` :> " << error.what() << '\n';
-        std::cerr << "`setParameters()` :> Values are set to default now.\n\n";
+        // Buffers are allocated again, previous parameters might have had another number of atoms
+        setDefaultParameters();
+        allocate();
+
+        *err << "`setParameters()` :> Exception while setting parameters from " << source << '\n';
+        *err << "`setParameters()` :> " << error.what() << '\n';
+        *err << "`setParameters()` :> Values are set to default now.\n\n";
+    }
+    catch (const std::bad_alloc &error)
+    {
+        *err << "`setParameters()` :> Cannot allocate memory for " << N << " atoms from " << source << '\n';
+
+        setDefaultParameters();
+        allocate();
+
+        *err << "`setParameters()` :> Values are set to default now.\n\n";
     }
     catch (const std::ifstream::failure &error)
     {
-        n = 6;
-        So = 5000;
-        Sd = 50000;
-        Sout = 500;
-        Sxyz = 500;
-        m = 40.;
-        R = 0.38;
-        e = 1.;
-        k = 8.31e-3;
-        f = 1e4;
-        L = 6.;
-        a = 0.38;
-        T0 = 1e4;
-        tau = 1e-3;
+        setDefaultParameters();
+        allocate();
 
-        std::cerr << "`setParameters()` :> " << error.what() << '\n';
-        std::cerr << "`setParameters()` :> Values are set to default now.\n\n";
+        *err << "`setParameters()` :> " << error.what() << '\n';
+        *err << "`setParameters()` :> Values are set to default now.\n\n";
     }
+
+    return false;
+}
+
+/**************************************************************************************
+ * Sets the seed of the pseudo-random number generator (by default it is the current
+ * time), so the initial momenta are reproducible. It may be also set by the optional
+ * parameter `seed`.
+ * @param uint64_t seed.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::setSeed(const uint64_t &newSeed) noexcept
+{
+    seed = newSeed;
+}
+
+/**************************************************************************************
+ * Attaches statistics updated with absolute values of momenta every `Sout` steps of
+ * the production, so the histogram is averaged over the whole run. The object is not
+ * owned and has to live until the end of `simulateDynamics()` or `restart()` (which
+ * continues the histogram saved in the checkpoint).
+ * @param Stats* accumulator of statistics (nullptr detaches it).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::attachStats(Stats *S) noexcept
+{
+    stats = S;
+}
+
+/**************************************************************************************
+ * This function restores default values of all parameters. Buffer sizes of default
+ * parameters are the same as allocated by the constructor.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::setDefaultParameters() noexcept
+{
+    n = 6;
+    nx = 6;
+    ny = 6;
+    nz = 6;
+    So = 5000;
+    Sd = 50000;
+    Sout = 500;
+    Sxyz = 500;
+    m = 40.;
+    R = 0.38;
+    e = 1.;
+    k = 8.31e-3;
+    f = 1e4;
+    L = 6.;
+    L0 = 6.;
+    a = 0.38;
+    T0 = 1e4;
+    tau = 1e-3;
+    respa = 1;
+    adaptive = false;
+    tauMin = 1e-4;
+    tauMax = 1e-2;
+    dxMax = 0.02;
+    dHMax = 1e-4;
+    Sadapt = 1000;
+    thermostatEq = ThermostatKind::None;
+    thermostatProd = ThermostatKind::None;
+    Ttarget = 0.;
+    tauT = 0.1;
+    chain = 3;
+    barostatEq = BarostatKind::Off;
+    barostatProd = BarostatKind::Off;
+    Ptarget = 0.;
+    tauP = 1.;
+    boundary = Boundary::Sphere;
+    box[0] = box[1] = box[2] = 0.;
+    tail = true;
+    engine = Engine::Exact;
+    rc = 0.85;
+    skin = 0.1;
+    isa = Isa::Auto;
+    precision = Precision::Double;
+    potential = Potential::Analytic;
+    tableSize = 4096;
+    threads = 1;
+    Ssort = 0;
+    curve = Curve::Hilbert;
+    trajectory = TrajectoryFormat::Text;
+    asyncOutput = false;
+    outputSlots = 4;
+    Schk = 0;
+    checkpoint = "checkpoint.bin";
+    Sgr = 0;
+    grMax = 0.85;
+    grBins = 200;
+    rdfFile = "rdf.txt";
+    structure = false;
+    Scorr = 0;
+    corrPoints = 16;
+    corrFile = "msd.txt";
 }
 
 /**************************************************************************************
  * This function prints all currently set parameters. Notice that the section
  * parameters is only for the information of printed parameters.
  * This function DOES NOT accept parameters.
- * @param usint n     // Number of atoms along the crystal edge
- * @param usint So    // Thermalisation steps
- * @param usint Sout  // Save informations about the system every \p`Sout` steps
- * @param usint Sxyz  // Save positions of atoms every `Sxyz` steps
+ * @param uint n      // Number of atoms along the crystal edge
+ * @param uint nx, ny, nz // Numbers of atoms along the edges of non-cubic crystal
+ * @param uint So     // Thermalisation steps
+ * @param uint Sout   // Save informations about the system every \p`Sout` steps
+ * @param uint Sxyz   // Save positions of atoms every `Sxyz` steps
  * @param double m    // Mass of the single atom
  * @param double e    // Minimum of the potential
  * @param double R    // Interatomic distance for which occurs minimum of the potential
@@ -284,26 +754,160 @@ void Argon::setParameters(const char *filename)
  * @param double a    // Interatomic distance
  * @param double T0   // Initial temperature
  * @param double tau  // Integration step
+ * @param uint respa  // Inner sub-steps of the sphere walls in the r-RESPA step
+ * @param bool adaptive // Adapt the integration step
+ * @param double tauMin // Lower limit of the adaptive step
+ * @param double tauMax // Upper limit of the adaptive step
+ * @param double dxMax  // Largest displacement of an atom in the adaptive step
+ * @param double dHMax  // Largest relative fluctuation of H over `Sadapt` steps
+ * @param uint Sadapt   // Adapt the step every `Sadapt` steps
+ * @param ThermostatKind thermostatEq, thermostatProd // Thermostats of both phases
+ * @param double Ttarget // Target temperature of thermostats
+ * @param double tauT   // Coupling time of thermostats
+ * @param uint chain    // Length of the Nose-Hoover chain
+ * @param BarostatKind barostatEq, barostatProd // Barostats of both phases
+ * @param double Ptarget // Target pressure
+ * @param double tauP   // Coupling time of the barostat
+ * @param Boundary boundary // Sphere walls or periodic box
+ * @param double Lx, Ly, Lz // Edges of the periodic box
+ * @param bool tail   // Long-range corrections of the truncated potential
+ * @param Engine engine // Method of pair forces evaluation
+ * @param double rc   // Cutoff radius of the pair potential
+ * @param double skin // Thickness of the Verlet skin
+ * @param Isa isa     // Instruction set of the pair kernels
+ * @param Precision precision // Precision of the pair kernels
+ * @param Potential potential // Evaluation of the pair potential
+ * @param uint tableSize // Number of intervals of the tabulated potential
+ * @param uint threads // Number of threads of the pair forces evaluation
+ * @param uint Ssort  // Sort atoms along the space-filling curve every `Ssort` steps
+ * @param Curve curve // Space-filling curve of the sorting
+ * @param TrajectoryFormat trajectory // Format of the file with positions
+ * @param bool asyncOutput // Write output on the background thread
+ * @param uint outputSlots // Number of snapshots buffered by the background writer
+ * @param uint Schk   // Save checkpoint every `Schk` steps
+ * @param string checkpoint // Name of the checkpoint file
  * @return Nothing to return.
  **************************************************************************************/
 void Argon::checkParameters() const noexcept
 {
-    std::cout << "`checkParameters()` :> Currently set parameters." << '\n';
-    std::cout << "`checkParameters()` :> n:        " << n << '\n';
-    std::cout << "`checkParameters()` :> m:        " << m << '\n';
-    std::cout << "`checkParameters()` :> e:        " << e << '\n';
-    std::cout << "`checkParameters()` :> R:        " << R << '\n';
-    std::cout << "`checkParameters()` :> k:        " << k << '\n';
-    std::cout << "`checkParameters()` :> f:        " << f << '\n';
-    std::cout << "`checkParameters()` :> L:        " << L << '\n';
-    std::cout << "`checkParameters()` :> a:        " << a << '\n';
-    std::cout << "`checkParameters()` :> T0:       " << T0 << '\n';
-    std::cout << "`checkParameters()` :> tau:      " << tau << '\n';
-    std::cout << "`checkParameters()` :> So:       " << So << '\n';
-    std::cout << "`checkParameters()` :> Sd:       " << Sd << '\n';
-    std::cout << "`checkParameters()` :> Sout:     " << Sout << '\n';
-    std::cout << "`checkParameters()` :> Sxyz:     " << Sxyz << '\n';
-    std::cout << "`checkParameters()` :> End of parameters.\n\n";
+    *out << "`checkParameters()` :> Currently set parameters." << '\n';
+    *out << "`checkParameters()` :> n:        " << n << '\n';
+
+    if (nx != n || ny != n || nz != n)
+        *out << "`checkParameters()` :> nx ny nz: " << nx << ' ' << ny << ' ' << nz << '\n';
+
+    *out << "`checkParameters()` :> m:        " << m << '\n';
+    *out << "`checkParameters()` :> e:        " << e << '\n';
+    *out << "`checkParameters()` :> R:        " << R << '\n';
+    *out << "`checkParameters()` :> k:        " << k << '\n';
+    *out << "`checkParameters()` :> f:        " << f << '\n';
+    *out << "`checkParameters()` :> L:        " << L << '\n';
+    *out << "`checkParameters()` :> a:        " << a << '\n';
+    *out << "`checkParameters()` :> T0:       " << T0 << '\n';
+    *out << "`checkParameters()` :> tau:      " << tau << '\n';
+    *out << "`checkParameters()` :> respa:    " << respa << '\n';
+    *out << "`checkParameters()` :> adaptive: " << (adaptive ? "on" : "off") << '\n';
+
+    if (adaptive)
+    {
+        *out << "`checkParameters()` :> tauMin:   " << tauMin << '\n';
+        *out << "`checkParameters()` :> tauMax:   " << tauMax << '\n';
+        *out << "`checkParameters()` :> dxMax:    " << dxMax << '\n';
+        *out << "`checkParameters()` :> dHMax:    " << dHMax << '\n';
+        *out << "`checkParameters()` :> Sadapt:   " << Sadapt << '\n';
+    }
+    *out << "`checkParameters()` :> thermostatEq:   " << thermostatName(thermostatEq) << '\n';
+    *out << "`checkParameters()` :> thermostatProd: " << thermostatName(thermostatProd) << '\n';
+
+    if (thermostatEq != ThermostatKind::None || thermostatProd != ThermostatKind::None)
+    {
+        *out << "`checkParameters()` :> Ttarget:  " << (Ttarget > 0. ? Ttarget : T0) << '\n';
+        *out << "`checkParameters()` :> tauT:     " << tauT << '\n';
+
+        if (thermostatEq == ThermostatKind::NoseHoover || thermostatProd == ThermostatKind::NoseHoover)
+            *out << "`checkParameters()` :> chain:    " << chain << '\n';
+    }
+
+    *out << "`checkParameters()` :> barostatEq:   " << (barostatEq == BarostatKind::Off ? "off" : "berendsen") << '\n';
+    *out << "`checkParameters()` :> barostatProd: " << (barostatProd == BarostatKind::Off ? "off" : "berendsen") << '\n';
+
+    if (barostatEq != BarostatKind::Off || barostatProd != BarostatKind::Off)
+    {
+        *out << "`checkParameters()` :> Ptarget:  " << Ptarget << '\n';
+        *out << "`checkParameters()` :> tauP:     " << tauP << '\n';
+    }
+
+    *out << "`checkParameters()` :> boundary: " << (boundary == Boundary::Sphere ? "sphere" : "periodic") << '\n';
+
+    if (boundary == Boundary::Periodic)
+    {
+        *out << "`checkParameters()` :> Lx Ly Lz: " << box[0] << ' ' << box[1] << ' ' << box[2] << '\n';
+        *out << "`checkParameters()` :> tail:     " << (tail ? "on" : "off") << '\n';
+    }
+
+#ifdef ARGON_MPI
+    if (distributed)
+        *out << "`checkParameters()` :> ranks:    " << domain.getRanks() << '\n';
+#endif
+
+    *out << "`checkParameters()` :> So:       " << So << '\n';
+    *out << "`checkParameters()` :> Sd:       " << Sd << '\n';
+    *out << "`checkParameters()` :> Sout:     " << Sout << '\n';
+    *out << "`checkParameters()` :> Sxyz:     " << Sxyz << '\n';
+    *out << "`checkParameters()` :> engine:   " << (engine == Engine::Exact ? "exact" : "verlet") << '\n';
+
+    if (engine == Engine::Verlet)
+    {
+        *out << "`checkParameters()` :> rc:       " << rc << '\n';
+        *out << "`checkParameters()` :> skin:     " << skin << '\n';
+    }
+
+    *out << "`checkParameters()` :> simd:     " << isaName(isa) << '\n';
+    *out << "`checkParameters()` :> precision: " << (precision == Precision::Double ? "double" : "mixed") << '\n';
+    *out << "`checkParameters()` :> potential: " << (potential == Potential::Analytic ? "analytic" : "table") << '\n';
+
+    if (potential == Potential::Table)
+        *out << "`checkParameters()` :> tableSize: " << tableSize << '\n';
+
+    *out << "`checkParameters()` :> threads:  " << threads << '\n';
+    *out << "`checkParameters()` :> Ssort:    " << Ssort << '\n';
+
+    if (Ssort > 0)
+        *out << "`checkParameters()` :> curve:    " << (curve == Curve::Morton ? "morton" : "hilbert") << '\n';
+
+    *out << "`checkParameters()` :> seed:     " << seed << '\n';
+    *out << "`checkParameters()` :> trajectory: "
+              << (trajectory == TrajectoryFormat::Text ? "text" : (trajectory == TrajectoryFormat::Float32 ? "float32" : "int16"))
+              << '\n';
+    *out << "`checkParameters()` :> output:   " << (asyncOutput ? "async" : "sync") << '\n';
+
+    if (asyncOutput)
+        *out << "`checkParameters()` :> outputSlots: " << outputSlots << '\n';
+
+    *out << "`checkParameters()` :> Schk:     " << Schk << '\n';
+
+    if (Schk > 0)
+        *out << "`checkParameters()` :> checkpoint: " << checkpoint << '\n';
+
+    *out << "`checkParameters()` :> Sgr:      " << Sgr << '\n';
+
+    if (Sgr > 0)
+    {
+        *out << "`checkParameters()` :> grMax:    " << grMax << '\n';
+        *out << "`checkParameters()` :> grBins:   " << grBins << '\n';
+        *out << "`checkParameters()` :> rdf:      " << rdfFile << '\n';
+        *out << "`checkParameters()` :> structure: " << (structure ? "on" : "off") << '\n';
+    }
+
+    *out << "`checkParameters()` :> Scorr:    " << Scorr << '\n';
+
+    if (Scorr > 0)
+    {
+        *out << "`checkParameters()` :> corrPoints: " << corrPoints << '\n';
+        *out << "`checkParameters()` :> corr:     " << corrFile << '\n';
+    }
+
+    *out << "`checkParameters()` :> End of parameters.\n\n";
 }
 
 /**************************************************************************************
@@ -314,141 +918,236 @@ void Argon::checkParameters() const noexcept
  * function calculates total energy (Hamiltonian), initial real temperature (T) and
  * initial pressure related to sphere walls. Finally it saves all needed informations
  * to the given files.
- * @param char* filename where to save initial positions,
+ * @param char* filename where to save initial positions (nullptr means no files),
  * @param char* filename where to save initial momenta,
  * @param char* filename where to save initial H, T and P.
  * @return Nothing to return.
  **************************************************************************************/
 void Argon::initialState(const char *rFilename, const char *pFilename, const char *htpFilename) noexcept
 {
-    // Calculate initial positions of atoms (5)
-    for (usint i_0 = 0; i_0 < n; i_0++)
+    // The new run starts in the sphere from parameters (the barostat may have moved it)
+    L = L0;
+
+#ifdef ARGON_MPI
+    if (distributed)
+    {
+        initialDistributed(rFilename, pFilename, htpFilename);
+        return;
+    }
+#endif
+
+    // Threads of the initialisation are the same as of the pair forces
+    setupForces();
+
+    // Atom of the given ID starts at the site of the crystal of the same index
+    std::iota(ids.begin(), ids.end(), 0u);
+
+    // Calculate initial positions of atoms (5), atom i = i_0 + i_1 nx + i_2 nx ny
+#pragma omp parallel for num_threads(forces.getThreads()) if (forces.getThreads() > 1)
+    for (uint i = 0; i < N; i++)
+    {
+        const uint i_0 = i % nx;
+        const uint i_1 = i / nx % ny;
+        const uint i_2 = i / nx / ny;
+
+        for (usint j = 0; j < K; j++)
+            r0[j][i] = (i_0 - 0.5 * (nx - 1)) * b0[j] + (i_1 - 0.5 * (ny - 1)) * b1[j] + (i_2 - 0.5 * (nz - 1)) * b2[j];
+    }
+
+    // The crystal is wrapped into its orthorhombic period, which lies in the middle of
+    // the periodic box (the rest of the larger box is empty)
+    if (boundary == Boundary::Periodic)
+    {
+        const double period[3] = {nx * a, ny * a * sqrt(3.) * 0.5, nz * a * sqrt(6.) / 3.};
+
+        for (usint j = 0; j < K; j++)
+            for (uint i = 0; i < N; i++)
+                r0[j][i] -= std::floor(r0[j][i] / period[j] + 0.5) * period[j];
+    }
+
+    // Calculate initial momenta of atoms from Maxwell-Boltzmann distribution, every component
+    // is normal with variance m k T0. The random number depends only on the seed, atom and
+    // component, and momenta are summed in fixed blocks, so results do not depend on threads.
+    const Philox philox(seed);
+    const double sigma = std::sqrt(m * k * T0);
+    const uint blocks = (N + InitBlock - 1) / InitBlock;
+    std::vector<double> sums(3 * blocks, 0.);
+
+#pragma omp parallel for num_threads(forces.getThreads()) if (forces.getThreads() > 1)
+    for (uint b = 0; b < blocks; b++)
     {
-        for (usint i_1 = 0; i_1 < n; i_1++)
+        for (uint i = b * InitBlock; i < std::min(N, (b + 1) * InitBlock); i++)
         {
-            for (usint i_2 = 0; i_2 < n; i_2++)
+            for (usint j = 0; j < K; j++)
             {
-                for (usint j = 0; j < K; j++)
-                {
-                    usint i = i_0 + i_1 * n + i_2 * n * n;
-                    r0[i][j] = (i_0 - 0.5 * (n - 1)) * b0[j] + (i_1 - 0.5 * (n - 1)) * b1[j] + (i_2 - 0.5 * (n - 1)) * b2[j];
-                }
+                p0[j][i] = sigma * philox.gaussian(i, j, static_cast<uint32_t>(RandomStream::Momenta), 0);
+                sums[3 * b + j] += p0[j][i];
             }
         }
     }
 
-    // Calculate initial momenta of atoms (7)
-    for (usint i = 0; i < N; i++)
+    for (usint j = 0; j < K; j++)
     {
-        for (usint j = 0; j < K; j++)
-        {
-            // Random number between 0 and 1
-            double number = static_cast<double>(mt()) / static_cast<double>(mt.max());
-            // Random sign of momentum variable
-            char sign = mt() % 2;
-
-            // Calculate momentum
-            if (sign == 0)
-                p0[i][j] = -sqrt(-0.5 * k * T0 * log(number) * 2. * m); // (7)
-            else if (sign == 1)
-                p0[i][j] = +sqrt(-0.5 * k * T0 * log(number) * 2. * m); // (7)
+        p[j] = 0.;
 
-            // Accumulate momenta
-            p[j] += p0[i][j];
-        }
+        for (uint b = 0; b < blocks; b++)
+            p[j] += sums[3 * b + j];
     }
 
-    // Eliminate the centre of mass movement (8) and immediately calculate absolute values
-    for (usint i = 0; i < N; i++)
+    // Eliminate the centre of mass movement (8)
+#pragma omp parallel for num_threads(forces.getThreads()) if (forces.getThreads() > 1)
+    for (uint i = 0; i < N; i++)
     {
         for (usint j = 0; j < K; j++)
         {
-            p0[i][j] = p0[i][j] - (p[j] / N);
-            pAbs[i] += p0[i][j] * p0[i][j];
+            p0[j][i] = p0[j][i] - (p[j] / N);
         }
-
-        pAbs[i] = sqrt(pAbs[i]);
     }
 
-    // Calculate initial forces and potentials affecting to atoms
-    V = 0.; // Total potential energy
-    // Forces and potentials loop
-    for (usint i = 0; i < N; i++)
+    calculateMomentumAbs();
+
+    // Kinetic energy from absolute values of momenta
+    Ek = 0.;
+
+    for (uint i = 0; i < N; i++)
     {
-        // Absolute value of r_i -> |r_i|
-        double r_i = sqrt(r0[i][0] * r0[i][0] + r0[i][1] * r0[i][1] + r0[i][2] * r0[i][2]);
+        Ek += pAbs[i] * pAbs[i] / (2. * m);
+    }
 
-        // (10)
-        if (r_i < L)
-            Vs[i] = 0.;
-        else if (r_i >= L)
-            Vs[i] = 0.5 * f * (r_i - L) * (r_i - L);
+    dt = tau;
+    currentTime = 0.;
+    steps = 0;
+    window = 0;
+    Vol = (boundary == Boundary::Periodic) ? periodicBox.volume() : 4. / 3. * M_PI * L * L * L;
 
-        // Accumulate potential related to sphere walls to total potential
-        V += Vs[i];
+    // Initial forces, potential and pressure
+    calculateForces();
+    calculateHTP();
 
-        // (14)
-        for (usint j = 0; j < K; j++)
-        {
-            if (r_i < L)
-                Fs[i][j] = 0.;
-            else if (r_i >= L)
-                Fs[i][j] = f * (L - r_i) * r0[i][j] / r_i;
+    Hlow = H;
+    Hhigh = H;
 
-            // Accumulate repulsive forces related to sphere walls to total forces
-            Fi[i][j] = Fs[i][j];
-        }
+    initialStateCheck = true;
 
-        // (9) and (13)
-        for (usint j = 0; j < i; j++)
-        {
-            // Absolute value of r_i - r_j -> |r_i - r_j|
-            double r_ij = sqrt((r0[i][0] - r0[j][0]) * (r0[i][0] - r0[j][0]) + (r0[i][1] - r0[j][1]) * (r0[i][1] - r0[j][1]) +
-                               (r0[i][2] - r0[j][2]) * (r0[i][2] - r0[j][2]));
+    if (rFilename == nullptr)
+    {
+        *out << "`initialState()` :> Successfully calculated initial state.\n\n";
+        return;
+    }
 
-            // Local variables to evaluate powers -> huge increase of performance (instead of calculate with common pow())
-            double z = R / r_ij;
-            double y = z * z;
-            double x = y * y * y;
-            // (9)
-            Vp[i][j] = e * x * (x - 2.);
+    saveInitialState(rFilename, pFilename, htpFilename);
+    *out << "`initialState()` :> Successfully calculated and saved initial state.\n\n";
+}
 
-            for (usint k = 0; k < K; k++)
-            {
-                // Fp is not required as 3D array, we may use just ordinary variable but with Fp is more evident
-                // what is happens here
-                Fp[i][j][k] = 12. * e * x * (x - 1.) * (r0[i][k] - r0[j][k]) / (r_ij * r_ij);
+/**************************************************************************************
+ * Selects pair kernels for this CPU, prepares buffers of threads and the empty
+ * neighbor list.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::setupForces()
+{
+#ifdef ARGON_MPI
+    // Every rank evaluates its domain, buffers grow with atoms and ghosts
+    const uint atoms = distributed ? N / domain.getRanks() + 1 : N;
+#else
+    const uint atoms = N;
+#endif
 
-                // Symmetry of forces matrix (only one triangular matrix needs to be calculated) -> increase performance
-                Fi[i][k] += Fp[i][j][k];
-                Fi[j][k] -= Fp[i][j][k];
-            }
+    forces.setup(atoms, e, R, rc, isa, threads, precision);
 
-            // Accumulate van der Waals potentials
-            V += Vp[i][j];
-        }
+    if (isa != Isa::Auto && forces.getIsa() != isa)
+        *err << "`setupForces()` :> Instruction set " << isaName(isa) << " is not supported by the CPU.\n";
+
+    *out << "`setupForces()` :> Pair kernels use instruction set " << isaName(forces.getIsa()) << " on "
+              << forces.getThreads() << " thread(s)"
+              << (precision == Precision::Mixed ? " in mixed precision.\n" : ".\n");
+
+    if (potential == Potential::Table)
+    {
+        const TableError error = forces.tabulate(tableSize);
+        const PairTable &table = forces.getTable();
+
+        *out << "`setupForces()` :> Potential tabulated on " << table.getSize() << " intervals of r^2 from "
+             << table.getS0() << " to " << table.getS1() << ", largest relative error of V " << error.V << " and F "
+             << error.F << ".\n";
     }
 
-    // Prepare to accumulate physical parameters at initial time
-    H = V; // At this moment Hamiltonian is just total potential
-    T = 0.;
-    P = 0.;
-    Ek = 0.;
+    if (boundary == Boundary::Periodic)
+        setupBox();
+    else if (engine == Engine::Verlet)
+        neighbors.setup(N, rc, skin, L);
+
+    kinetic.assign(forces.getThreads(), 0.);
 
-    for (usint i = 0; i < N; i++)
+    if (respa > 1)
+        Fw.resize(N);
+
+    // Output of sorted atoms is gathered in the order of IDs (the periodic box has it already)
+    if (Ssort > 0 && boundary == Boundary::Sphere)
+        rw.resize(N);
+
+    if (Sgr > 0)
+        rdf.setup(N, grMax, grBins, L);
+
+    if (Sgr > 0 && boundary == Boundary::Periodic)
+        rdf.setPeriodic(periodicBox.volume());
+
+    if (Scorr > 0)
+        correlator.setup(N, corrPoints, MultiTauCorrelator::levelsFor(Sd / Scorr, corrPoints), Scorr * tau);
+
+    setupThermostats();
+}
+
+/**************************************************************************************
+ * Prepares the periodic box, the cell grid over the box with layers of ghosts and
+ * long-range corrections of the potential truncated at rc (g(r) = 1 beyond rc):
+ *     Vtail = 2 pi N rho e (R^12 / (9 rc^9) - 2 R^6 / (3 rc^3)),
+ *     Ptail = 8/3 pi rho^2 e (R^12 / (3 rc^9) - R^6 / rc^3),
+ * with rho = N / Vol. The shift of the potential at rc is a part of the model and is
+ * not corrected.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::setupBox()
+{
+#ifdef ARGON_MPI
+    if (distributed)
+        setupDomain();
+    else
+#endif
     {
-        // Local variable to increase performance;
-        Ek = (p0[i][0] * p0[i][0] + p0[i][1] * p0[i][1] + p0[i][2] * p0[i][2]) / (2. * m);
+        const double halo = rc + skin;
+        const double low[3] = {-0.5 * box[0] - halo, -0.5 * box[1] - halo, -0.5 * box[2] - halo};
+        const double high[3] = {0.5 * box[0] + halo, 0.5 * box[1] + halo, 0.5 * box[2] + halo};
 
-        // Accumulate physical parameters
-        H += Ek;
-        T += 2. / (3. * N * k) * Ek;
-        P += sqrt(Fs[i][0] * Fs[i][0] + Fs[i][1] * Fs[i][1] + Fs[i][2] * Fs[i][2]) / (4. * M_PI * L * L);
+        periodicBox.setup(N, box, halo);
+        neighbors.setup(N, rc, skin, low, high);
+        rw.resize(N);
     }
 
-    initialStateCheck = true;
-    saveInitialState(rFilename, pFilename, htpFilename);
-    std::cout << "`initialState()` :> Successfully calculated and saved initial state.\n\n";
+    const double rho = N / (box[0] * box[1] * box[2]);
+    const double R6 = R * R * R * R * R * R;
+    const double rc3 = rc * rc * rc;
+
+    W = 0.;
+    Vtail = tail ? 2. * M_PI * N * rho * e * (R6 * R6 / (9. * rc3 * rc3 * rc3) - 2. * R6 / (3. * rc3)) : 0.;
+    Ptail = tail ? 8. / 3. * M_PI * rho * rho * e * (R6 * R6 / (3. * rc3 * rc3 * rc3) - R6 / rc3) : 0.;
+
+    *out << "`setupBox()` :> Periodic box " << box[0] << " x " << box[1] << " x " << box[2] << " with tail corrections V "
+         << Vtail << " and P " << Ptail << ".\n";
+}
+
+/**************************************************************************************
+ * Prepares thermostats of the thermalisation and of the production with the current
+ * seed (random kicks of Langevin depend on it).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::setupThermostats()
+{
+    const double target = (Ttarget > 0.) ? Ttarget : T0;
+    const uint32_t stream = static_cast<uint32_t>(RandomStream::Langevin);
+
+    bathEq.setup(thermostatEq, target, k, tauT, chain, N, m, seed, stream, forces.getThreads());
+    bathProd.setup(thermostatProd, target, k, tauT, chain, N, m, seed, stream, forces.getThreads());
 }
 
 /**************************************************************************************
@@ -467,181 +1166,1255 @@ void Argon::simulateDynamics(const char *rFilename, const char *htpFilename) noe
 {
     if (initialStateCheck == false)
     {
-        std::cerr << "`simulateDynamics()` :> Error - calculate initial state before!\n\n";
+        *err << "`simulateDynamics()` :> Error - calculate initial state before!\n\n";
         return;
     }
 
-    std::cout << "`simulateDynamics()` :> System is ready to simulation.\n\n";
-
-    std::ofstream ofileRt("../Out/" + std::string(rFilename), std::ios::out);
-    std::ofstream ofileHtp("../Out/" + std::string(htpFilename), std::ios::out);
-
-    ofileRt << std::fixed << std::setprecision(5);
-    ofileHtp << std::fixed << std::setprecision(5);
-
-    // Save initial positions and initial H, T and P
-    saveCurrentPositions(ofileRt);
-    saveCurrentHTP(0., ofileHtp);
-
-    // Current information to track simulation
-    printCurrentInfo(0.);
+    *out << "`simulateDynamics()` :> System is ready to simulation.\n\n";
 
     // At this point, these values are not computed
     Hmean = 0.;
     Tmean = 0.;
     Pmean = 0.;
-    Vol = 4. / 3. * M_PI * L * L * L;
-
-    // Informations print interval
-    uint infoOut = Sd / 10;
+    Volmean = 0.;
 
-    // Simulation loop
-    for (uint s = 1; s <= So + Sd; s++)
+#ifdef ARGON_MPI
+    if (distributed)
     {
-        // Print current informations
-        if (s % infoOut == 0)
-        {
-            printCurrentInfo(s * tau);
-        }
+        runDistributed(rFilename, htpFilename);
+        return;
+    }
+#endif
 
-        // Calculate auxiliary momenta (18a) and positions (18b)
-        for (usint i = 0; i < N; i++)
-        {
-            for (usint j = 0; j < K; j++)
+    runDynamics(rFilename, htpFilename, 1, nullptr);
+}
+
+/**************************************************************************************
+ * This function continues the simulation saved in the checkpoint. Parameters have to
+ * be the same as in the interrupted run (only Sd may be increased). Output written
+ * after the checkpoint is dropped and the run continues from the next step, so files
+ * are exactly the same as if the run had not been interrupted (with the same number
+ * of threads and instruction set).
+ * @param char* filename of the checkpoint in `Out` folder,
+ * @param char* filename where positions were saved,
+ * @param char* filename where H, T and P were saved.
+ * @return True if the run was continued.
+ *************************************************************************************/
+bool Argon::restart(const char *checkpointFilename, const char *rFilename, const char *htpFilename) noexcept
+{
+    uint step = 0;
+    OutputMark mark{};
+
+#ifdef ARGON_MPI
+    if (distributed)
+    {
+        *err << "`restart()` :> Checkpoints are not available with several MPI ranks.\n\n";
+        return false;
+    }
+#endif
+
+    setupForces();
+
+    if (!loadCheckpoint(checkpointFilename, step, mark))
+        return false;
+
+    // Drop output written after the checkpoint
+    std::error_code error;
+    std::filesystem::resize_file("../Out/" + std::string(rFilename), mark.rtBytes, error);
+
+    if (!error)
+        std::filesystem::resize_file("../Out/" + std::string(htpFilename), mark.htpBytes, error);
+
+    if (error)
+    {
+        *err << "`restart()` :> Cannot truncate output files: " << error.message() << "\n\n";
+        return false;
+    }
+
+    initialStateCheck = true;
+    *out << "`restart()` :> Continue simulation from step " << step << ".\n\n";
+
+    runDynamics(rFilename, htpFilename, step + 1, &mark);
+
+    return true;
+}
+
+/**************************************************************************************
+ * Simulation loop from the given step to the end. The first step 1 starts the new run
+ * and creates output files, otherwise files are continued from the given sizes.
+ * @param char* filename where to save current positions,
+ * @param char* filename where to save current H, T and P,
+ * @param uint first step,
+ * @param OutputMark* sizes of the output files to continue (nullptr for the new run).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::runDynamics(const char *rFilename, const char *htpFilename, const uint &first, const OutputMark *mark) noexcept
+{
+    const std::string rPath = "../Out/" + std::string(rFilename);
+    const std::ios::openmode mode = (mark == nullptr) ? std::ios::out : std::ios::app;
+
+    std::ofstream ofileRt;
+    std::ofstream ofileHtp("../Out/" + std::string(htpFilename), mode);
+
+    // Wrapped positions of the periodic box are within half of its longest edge
+    const double extent = (boundary == Boundary::Periodic) ? 0.5 * std::max({box[0], box[1], box[2]}) : L;
+
+    // Binary trajectory has a frame every `Sxyz` steps
+    if (trajectory == TrajectoryFormat::Text)
+        ofileRt.open(rPath, mode);
+    else if (mark == nullptr && !trajectoryW.open(rPath.c_str(), trajectory, N, Sxyz * tau, extent))
+        *err << "`simulateDynamics()` :> Cannot open binary trajectory " << rPath << '\n';
+    else if (mark != nullptr && !trajectoryW.append(rPath.c_str(), mark->frames))
+        *err << "`simulateDynamics()` :> Cannot continue binary trajectory " << rPath << '\n';
+
+    ofileRt << std::fixed << std::setprecision(5);
+    ofileHtp << std::fixed << std::setprecision(5);
+
+    // Since now files are written only by the background thread
+    if (asyncOutput)
+        writer.start(outputSlots, N, &ofileRt, (trajectory == TrajectoryFormat::Text) ? nullptr : &trajectoryW, &ofileHtp);
+
+    if (mark == nullptr)
+    {
+        // Save initial positions and initial H, T and P
+        saveCurrentPositions(ofileRt);
+        saveCurrentHTP(0., ofileHtp);
+
+        // Current information to track simulation
+        printCurrentInfo(0.);
+    }
+
+    Vol = (boundary == Boundary::Periodic) ? periodicBox.volume() : 4. / 3. * M_PI * L * L * L;
+
+    if (stats != nullptr)
+        stats->setSystem(k, m);
+
+    // Informations print interval
+    uint infoOut = std::max(Sd / 10, 1u);
+
+    // Simulation loop over steps of `tau`. The adaptive step may pass several of them or
+    // only a part of one, so events happen when the step passes a multiple of their
+    // interval and mean values are weighted by the time spent in the production.
+    uint s = first - 1;
+
+    while (s < So + Sd)
+    {
+        const uint prev = s;
+        double weight = 1.;
+
+        if (adaptive)
+        {
+            const double t0 = currentTime;
+
+            // The last step ends exactly at the end of the simulation
+            dt = std::min(dt, (So + Sd) * tau - currentTime);
+
+            integrate(true);
+
+            currentTime += dt;
+            s = std::min<uint>(So + Sd, currentTime / tau + 1e-6);
+            weight = std::max(0., currentTime - std::max(t0, So * tau)) / tau;
+
+            adaptStep();
+        }
+        else
+        {
+            s++;
+
+            // H, T and P are required only to save, average, print or checkpoint them
+            const bool observe = (s >= So) || (s % Sout == 0) || (s % infoOut == 0) || (s == So + Sd) ||
+                                 (Schk > 0 && s % Schk == 0);
+
+            // (18a), (18b) and (18c), the thermalisation ends with the step So
+            if (s <= So)
+                controlledStep(observe, bathEq, barostatEq);
+            else
+                controlledStep(observe, bathProd, barostatProd);
+
+            currentTime = s * tau;
+
+            // Steps So + 1 ... So + Sd, so the weights sum to Sd as in the adaptive mode
+            weight = (s > So) ? 1. : 0.;
+        }
+
+        steps++;
+
+        // True if the step has passed a multiple of the interval
+        auto passed = [&s, &prev](const uint &interval)
+        { return s / interval > prev / interval; };
+
+        // Print current informations
+        if (passed(infoOut) && s < So + Sd)
+        {
+            printCurrentInfo(currentTime);
+        }
+
+        // Save temporary positions at given time
+        if (passed(Sxyz))
+        {
+            saveCurrentPositions(ofileRt);
+        }
+
+        // Save temporary H, T and P at given time
+        if (passed(Sout))
+        {
+            saveCurrentHTP(currentTime, ofileHtp);
+        }
+
+        // Accumulate mean values only when thermalisation is done
+        if (weight > 0.)
+        {
+            Tmean += T * weight;
+            Pmean += P * weight;
+            Hmean += H * weight;
+            Volmean += Vol * weight;
+        }
+
+        // g(r) is normalised by the sphere after the thermalisation
+        if (Sgr > 0 && barostatEq != BarostatKind::Off && prev < So && s >= So)
+        {
+            rdf.setup(N, grMax, grBins, L);
+        }
+
+        // Momentum statistics of the production
+        if (stats != nullptr && s > So && passed(Sout))
+        {
+            calculateMomentumAbs();
+            stats->accumulate(pAbs, N, T);
+        }
+
+        if (Sgr > 0 && s > So && passed(Sgr))
+        {
+            sampleStructure();
+        }
+
+        if (Scorr > 0 && s > So && passed(Scorr))
+        {
+            correlator.add(r0, p0, m, ids.data());
+        }
+
+        // Before the checkpoint, so the restart continues with the same order of atoms
+        if (Ssort > 0 && passed(Ssort) && s < So + Sd)
+        {
+            sortAtoms();
+        }
+
+        if (Schk > 0 && passed(Schk) && s < So + Sd)
+        {
+            saveCheckpoint(s, rFilename, htpFilename, ofileRt, ofileHtp);
+        }
+    } // End of simulation loop
+
+    printCurrentInfo(currentTime); // Latest step
+    calculateMomentumAbs();
+
+    // Average the cumulative values
+    Hmean /= Sd;
+    Tmean /= Sd;
+    Pmean /= Sd;
+    Volmean /= Sd;
+
+    // The volume changes in the production only with the barostat (NPT)
+    const double volume = (barostatProd != BarostatKind::Off) ? Volmean : Vol;
+
+    // Ideal gas law -> PV = NkT Volume not potential :)
+    IdealGas = (N * k * Tmean) / (Pmean * volume);
+
+    // Chemical potential from microcanonical ensemble
+    u = k * T * log(volume / N * (4. * M_PI * m * Hmean) / (3. * N) * sqrt((4. * M_PI * m * Hmean) / (3. * N)));
+
+    *out << "Mean Total Energy:        " << Hmean << '\n';
+    *out << "Mean Temperature:         " << Tmean << '\n';
+    *out << "Mean Pressure:            " << Pmean << '\n';
+    *out << "Ideal Gas Law:            " << IdealGas << '\n';
+    *out << "Mean Chemical Potential:  " << u << '\n';
+
+    if (bathProd.active())
+        *out << "Production Thermostat:    " << thermostatName(thermostatProd) << '\n';
+
+    // H of the Nose-Hoover chain is not conserved, H with the energy of thermostats is
+    if (thermostatProd == ThermostatKind::NoseHoover)
+        *out << "Extended Hamiltonian:     " << H + bathProd.energy() << '\n';
+
+    if (barostatEq != BarostatKind::Off || barostatProd != BarostatKind::Off)
+    {
+        *out << "Radius of Sphere:         " << L << '\n';
+        *out << "Mean Volume:              " << volume << '\n';
+    }
+
+    if (asyncOutput)
+    {
+        writer.finish();
+        *out << "Output Blocked Time (s):  " << writer.getBlocked() << '\n';
+    }
+
+    if (engine == Engine::Verlet)
+        *out << "Neighbor List Rebuilds:   " << neighbors.getRebuilds() << '\n';
+
+    if (Sgr > 0)
+        saveStructure();
+
+    if (Scorr > 0)
+        saveCorrelations();
+
+    if (adaptive)
+    {
+        *out << "Integration Steps:        " << steps << '\n';
+        *out << "Mean Integration Step:    " << currentTime / steps << '\n';
+    }
+
+    *out << '\n';
+
+    ofileRt.close();
+    ofileHtp.close();
+    trajectoryW.close();
+
+#ifdef ARGON_PROFILE
+    std::error_code error;
+    const uint64_t bytes = std::filesystem::file_size(rPath, error) + std::filesystem::file_size("../Out/" + std::string(htpFilename), error);
+    ARGON_PROFILE_COUNT(Counter::BytesWritten, (error || mark == nullptr) ? bytes : bytes - mark->rtBytes - mark->htpBytes);
+    ARGON_PROFILE_COUNT(Counter::BlockedNs, asyncOutput ? 1e9 * writer.getBlocked() : 0);
+#endif
+}
+
+/**************************************************************************************
+ * Single step of the integrator with the thermostat and barostat of the current phase.
+ * The thermostat acts on momenta around the step (it needs kinetic energy, so H and T
+ * are calculated in every step) and the barostat moves the walls after it.
+ * @param bool if true, calculate H and T at the end of the step,
+ * @param Thermostat thermostat of the phase,
+ * @param BarostatKind barostat of the phase.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::controlledStep(const bool &observe, Thermostat &bath, const BarostatKind &barostat) noexcept
+{
+    if (!bath.active())
+        integrate(observe);
+    else
+    {
+        bath.before(p0, dt, Ek);
+        integrate(true);
+        bath.after(p0, dt, Ek, steps);
+        calculateHTP();
+    }
+
+    if (barostat != BarostatKind::Off)
+        scaleRadius();
+}
+
+/**************************************************************************************
+ * Berendsen barostat: the volume of the sphere relaxes to the target pressure on
+ * the walls with the time tauP,
+ *     dVol / Vol = -dt / tauP (Ptarget - P) / Ptarget,
+ * i.e. with the compressibility 1/Ptarget of the ideal gas, limited to 1% per step.
+ * Only the walls move (atoms are not scaled like in the periodic box), the new radius
+ * acts from the next force evaluation.
+ * @return Sets the radius `L` and the volume `Vol`.
+ *************************************************************************************/
+void Argon::scaleRadius() noexcept
+{
+    ARGON_PROFILE_SCOPE(Phase::Thermostat);
+
+    L *= std::cbrt(std::clamp(1. - dt / tauP * (Ptarget - P) / Ptarget, 0.99, 1.01));
+    Vol = 4. / 3. * M_PI * L * L * L;
+}
+
+/**************************************************************************************
+ * Single step of the velocity Verlet integrator (18a), (18b), (18c). Forces at the new
+ * positions are evaluated in the middle of the step. If `respa` is greater than 1,
+ * the step is done by the r-RESPA integrator.
+ * @param bool if true, calculate H and T at the end of the step.
+ * @return Updates positions, momenta, forces, potential and pressure.
+ *************************************************************************************/
+void Argon::integrate(const bool &observe) noexcept
+{
+    if (respa > 1)
+    {
+        integrateRespa(observe);
+        return;
+    }
+
+    // Calculate auxiliary momenta (18a) and positions (18b)
+    {
+        ARGON_PROFILE_SCOPE(Phase::KickDrift);
+
+#pragma omp parallel for num_threads(forces.getThreads()) if (forces.getThreads() > 1)
+        for (uint i = 0; i < N; i++)
+        {
+            p0.x[i] = p0.x[i] + 0.5 * Fi.x[i] * dt;
+            p0.y[i] = p0.y[i] + 0.5 * Fi.y[i] * dt;
+            p0.z[i] = p0.z[i] + 0.5 * Fi.z[i] * dt;
+            r0.x[i] = r0.x[i] + p0.x[i] * dt / m;
+            r0.y[i] = r0.y[i] + p0.y[i] * dt / m;
+            r0.z[i] = r0.z[i] + p0.z[i] * dt / m;
+        }
+    }
+
+    // (9), (10), (13) and (14)
+    calculateForces();
+
+    kick(observe);
+}
+
+/**************************************************************************************
+ * Step of the multiple time step integrator r-RESPA: the pair forces kick momenta with
+ * the step `dt` and the cheap forces from sphere walls move atoms with `respa` inner
+ * velocity Verlet sub-steps of `dt / respa` in between, so the pair forces are
+ * evaluated once per step. The scheme is time reversible and symplectic like (18).
+ * @param bool calculate kinetic energy, H and T in this step.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::integrateRespa(const bool &observe) noexcept
+{
+    const double inner = dt / respa;
+    double Vw = 0.;
+
+    // Outer half kick of the pair forces
+    {
+        ARGON_PROFILE_SCOPE(Phase::Kick);
+
+#pragma omp parallel for num_threads(forces.getThreads()) if (forces.getThreads() > 1)
+        for (uint i = 0; i < N; i++)
+        {
+            p0.x[i] = p0.x[i] + 0.5 * Fi.x[i] * dt;
+            p0.y[i] = p0.y[i] + 0.5 * Fi.y[i] * dt;
+            p0.z[i] = p0.z[i] + 0.5 * Fi.z[i] * dt;
+        }
+    }
+
+    // Inner velocity Verlet of the sphere walls (10), (14)
+    for (uint j = 0; j < respa; j++)
+    {
+        {
+            ARGON_PROFILE_SCOPE(Phase::KickDrift);
+
+#pragma omp parallel for num_threads(forces.getThreads()) if (forces.getThreads() > 1)
+            for (uint i = 0; i < N; i++)
             {
-                p0[i][j] = p0[i][j] + 0.5 * Fi[i][j] * tau;
-                r0[i][j] = r0[i][j] + p0[i][j] * tau / m;
+                p0.x[i] = p0.x[i] + 0.5 * Fw.x[i] * inner;
+                p0.y[i] = p0.y[i] + 0.5 * Fw.y[i] * inner;
+                p0.z[i] = p0.z[i] + 0.5 * Fw.z[i] * inner;
+                r0.x[i] = r0.x[i] + p0.x[i] * inner / m;
+                r0.y[i] = r0.y[i] + p0.y[i] * inner / m;
+                r0.z[i] = r0.z[i] + p0.z[i] * inner / m;
             }
         }
 
-        // In every step set total potential to zero (IMPORTANT!)
-        V = 0.;
+        Vw = calculateWallForces(Fw);
 
-        // Dynamics loop
-        for (usint i = 0; i < N; i++)
+        ARGON_PROFILE_SCOPE(Phase::KickDrift);
+
+#pragma omp parallel for num_threads(forces.getThreads()) if (forces.getThreads() > 1)
+        for (uint i = 0; i < N; i++)
         {
-            // Absolute value of r_i -> |r_i|
-            double r_i = sqrt(r0[i][0] * r0[i][0] + r0[i][1] * r0[i][1] + r0[i][2] * r0[i][2]);
+            p0.x[i] = p0.x[i] + 0.5 * Fw.x[i] * inner;
+            p0.y[i] = p0.y[i] + 0.5 * Fw.y[i] * inner;
+            p0.z[i] = p0.z[i] + 0.5 * Fw.z[i] * inner;
+        }
+    }
 
-            // (10)
-            if (r_i < L)
-                Vs[i] = 0.;
-            else if (r_i >= L)
-                Vs[i] = 0.5 * f * (r_i - L) * (r_i - L);
+    // (9), (13) at the new positions and the outer half kick
+    V = Vw;
+    Fi.zero();
+    calculatePairForces();
 
-            // Accumulate potential related to sphere walls to total potential
-            V += Vs[i];
+    kick(observe);
+}
 
-            // (14)
-            for (usint j = 0; j < K; j++)
-            {
-                if (r_i < L)
-                    Fs[i][j] = 0.;
-                else if (r_i >= L)
-                    Fs[i][j] = f * (L - r_i) * r0[i][j] / r_i;
+/**************************************************************************************
+ * Kicks momenta (18c) by forces `Fi` over the half of the step. Blocks of atoms are
+ * fixed, so kinetic energy is summed always in the same order regardless of threads
+ * scheduling.
+ * @param bool calculate kinetic energy, H and T in this step.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::kick(const bool &observe) noexcept
+{
+    ARGON_PROFILE_SCOPE(Phase::Kick);
+    const uint blocks = kinetic.size();
 
-                // Accumulate repulsive forces related to sphere walls to total forces
-                Fi[i][j] = Fs[i][j];
-            }
+#pragma omp parallel for num_threads(blocks) if (blocks > 1)
+    for (uint b = 0; b < blocks; b++)
+    {
+        const uint begin = N * b / blocks;
+        const uint end = N * (b + 1) / blocks;
+        double sum = 0.;
+
+        for (uint i = begin; i < end; i++)
+        {
+            p0.x[i] = p0.x[i] + 0.5 * Fi.x[i] * dt;
+            p0.y[i] = p0.y[i] + 0.5 * Fi.y[i] * dt;
+            p0.z[i] = p0.z[i] + 0.5 * Fi.z[i] * dt;
+
+            if (observe)
+                sum += p0.x[i] * p0.x[i] + p0.y[i] * p0.y[i] + p0.z[i] * p0.z[i];
+        }
+
+        kinetic[b] = sum;
+    }
+
+    if (observe)
+    {
+        Ek = 0.;
+
+        for (uint b = 0; b < blocks; b++)
+            Ek += kinetic[b];
+
+        Ek /= 2. * m;
+        calculateHTP();
+    }
+}
+
+/**************************************************************************************
+ * Chooses the next adaptive step. Every change of the step shifts the energy, so the
+ * step is kept constant for `Sadapt` steps (velocity Verlet conserves its shadow
+ * Hamiltonian in between) and then it is halved if H has fluctuated more than `dHMax`
+ * (relative) or doubled if it has fluctuated less than dHMax/8 (the error of (18) is
+ * proportional to the square of the step). The step is halved at once if some atom
+ * could move further than `dxMax` (from the largest velocity and acceleration), e.g.
+ * when atoms collide. The step is always within [tauMin, tauMax].
+ * @return Sets the step `dt`.
+ *************************************************************************************/
+void Argon::adaptStep() noexcept
+{
+    double p2 = 0., F2 = 0.;
+
+#pragma omp parallel for num_threads(forces.getThreads()) if (forces.getThreads() > 1) reduction(max : p2, F2)
+    for (uint i = 0; i < N; i++)
+    {
+        // Forces from sphere walls are separate in r-RESPA
+        const double Fx = (respa > 1) ? Fi.x[i] + Fw.x[i] : Fi.x[i];
+        const double Fy = (respa > 1) ? Fi.y[i] + Fw.y[i] : Fi.y[i];
+        const double Fz = (respa > 1) ? Fi.z[i] + Fw.z[i] : Fi.z[i];
+
+        p2 = std::max(p2, p0.x[i] * p0.x[i] + p0.y[i] * p0.y[i] + p0.z[i] * p0.z[i]);
+        F2 = std::max(F2, Fx * Fx + Fy * Fy + Fz * Fz);
+    }
+
+    const double v = sqrt(p2) / m;
+    const double acceleration = sqrt(F2) / m;
+
+    // Solution of v dt + acceleration dt^2 / 2 = dxMax
+    double limit = tauMax;
+
+    if (acceleration > 0.)
+        limit = (sqrt(v * v + 2. * acceleration * dxMax) - v) / acceleration;
+    else if (v > 0.)
+        limit = dxMax / v;
+
+    window++;
+    Hlow = std::min(Hlow, H);
+    Hhigh = std::max(Hhigh, H);
+
+    if (dt <= limit && window < Sadapt)
+        return;
+
+    double next = dt;
+
+    // Halving (doubling) the step decreases (increases) the fluctuation about 4 times
+    if (dt > limit || (Hhigh - Hlow) > dHMax * std::abs(H))
+        next = 0.5 * dt;
+    else if (8. * (Hhigh - Hlow) < dHMax * std::abs(H))
+        next = 2. * dt;
+
+    while (next > limit && next > tauMin)
+        next *= 0.5;
+
+    dt = std::min(std::max(next, tauMin), tauMax);
+    window = 0;
+    Hlow = H;
+    Hhigh = H;
+}
+
+/**************************************************************************************
+ * Advances the system by the given number of steps without any output. H and T are
+ * calculated in every step to follow the conservation of energy and absolute values of
+ * momenta are updated at the end (`getMomentumAbs()`). The thermostat and barostat
+ * of the thermalisation are applied and atoms are sorted every `Ssort` steps. Used by
+ * benchmarks.
+ * @param uint number of steps.
+ * @return AdvanceReport with H before and after the steps, maximum relative deviation
+ * of H, number of evaluated pair interactions, the mean temperature and the locality
+ * of the neighbor list.
+ *************************************************************************************/
+AdvanceReport Argon::advance(const uint &count) noexcept
+{
+    AdvanceReport report{H, H, 0., 0, 0., 0.};
+
+    if (initialStateCheck == false)
+    {
+        *err << "`advance()` :> Error - calculate initial state before!\n\n";
+        return report;
+    }
+
+#ifdef ARGON_MPI
+    if (distributed)
+        return advanceDistributed(count);
+#endif
+
+    for (uint s = 0; s < count; s++)
+    {
+        controlledStep(true, bathEq, barostatEq);
+
+        currentTime += dt;
+        steps++;
+
+        if (adaptive)
+            adaptStep();
+
+        report.drift = std::max(report.drift, std::abs(H - report.H0) / std::abs(report.H0));
+        report.pairs += (engine == Engine::Exact) ? N * (N - 1ull) / 2 : neighbors.size();
+        report.T += T / count;
+
+        if (Ssort > 0 && steps % Ssort == 0)
+            sortAtoms();
+    }
+
+    calculateMomentumAbs();
+    report.H = H;
+    report.span = (engine == Engine::Verlet) ? neighbors.span() : 0.;
+
+    return report;
+}
+
+/**************************************************************************************
+ * Saves the complete state after the given step: parameters, positions, momenta,
+ * forces, accumulated means, seed of the generator, radius of the sphere, neighbor
+ * list, IDs of sorted atoms, image indices of the periodic box, thermostats, attached
+ * statistics of momenta and sizes of the output files (which are flushed before).
+ * @param uint current step,
+ * @param char* filename where positions are saved,
+ * @param char* filename where H, T and P are saved,
+ * @param ofstream file with positions,
+ * @param ofstream file with H, T and P.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::saveCheckpoint(const uint &step, const char *rFilename, const char *htpFilename, std::ofstream &ofileRt,
+                           std::ofstream &ofileHtp) noexcept
+{
+    ARGON_PROFILE_SCOPE(Phase::Checkpoint);
+
+    if (writer.running())
+        writer.flush();
+
+    ofileRt.flush();
+    ofileHtp.flush();
+    trajectoryW.flush();
+
+    std::error_code error;
+    OutputMark mark{};
+    mark.rtBytes = std::filesystem::file_size("../Out/" + std::string(rFilename), error);
+    mark.htpBytes = std::filesystem::file_size("../Out/" + std::string(htpFilename), error);
+    mark.frames = trajectoryW.getFrames();
+
+    const std::string filename = "../Out/" + checkpoint;
+    Checkpoint chk;
+
+    if (!error && chk.create(filename.c_str()))
+    {
+        chk.write(static_cast<uint32_t>(N));
+        chk.write(nx);
+        chk.write(ny);
+        chk.write(nz);
+        chk.write(step);
+        chk.write(So);
+        chk.write(Sd);
+        chk.write(Sout);
+        chk.write(Sxyz);
+        chk.write(m);
+        chk.write(e);
+        chk.write(R);
+        chk.write(k);
+        chk.write(f);
+        chk.write(L0);
+        chk.write(tau);
+        chk.write(engine);
+        chk.write(rc);
+        chk.write(skin);
+        chk.write(trajectory);
+        chk.write(respa);
+        chk.write(precision);
+        chk.write(potential);
+        chk.write(tableSize);
+        chk.write(adaptive);
+        chk.write(tauMin);
+        chk.write(tauMax);
+        chk.write(dxMax);
+        chk.write(dHMax);
+        chk.write(Sadapt);
+        chk.write(Sgr);
+        chk.write(grMax);
+        chk.write(grBins);
+        chk.write(Scorr);
+        chk.write(corrPoints);
+        chk.write(thermostatEq);
+        chk.write(thermostatProd);
+        chk.write(Ttarget);
+        chk.write(tauT);
+        chk.write(chain);
+        chk.write(barostatEq);
+        chk.write(barostatProd);
+        chk.write(Ptarget);
+        chk.write(tauP);
+        chk.write(boundary);
+        chk.write(box[0]);
+        chk.write(box[1]);
+        chk.write(box[2]);
+        chk.write(tail);
+        chk.write(Ssort);
+        chk.write(curve);
+
+        chk.write(V);
+        chk.write(H);
+        chk.write(T);
+        chk.write(P);
+        chk.write(Hmean);
+        chk.write(Tmean);
+        chk.write(Pmean);
+        chk.write(mark);
+        chk.write(dt);
+        chk.write(currentTime);
+        chk.write(steps);
+        chk.write(window);
+        chk.write(Hlow);
+        chk.write(Hhigh);
+        chk.write(L);
+        chk.write(Ek);
+        chk.write(Volmean);
+
+        chk.write(r0);
+        chk.write(p0);
+        chk.write(Fi);
+        chk.write(seed);
+
+        if (respa > 1)
+            chk.write(Fw);
+
+        if (Ssort > 0)
+            chk.write(ids.data(), N);
+
+        // The same list gives the same order of summation of forces
+        if (engine == Engine::Verlet)
+        {
+            chk.write(neighbors.getRebuilds());
+            chk.write(neighbors.getReference());
+        }
+
+        // Ghosts of the last build are found again from the reference and image indices
+        if (boundary == Boundary::Periodic)
+            chk.write(periodicBox.getImages());
+
+        if (Sgr > 0)
+        {
+            chk.write(rdf.getFrames());
+
+            for (const uint64_t &count : rdf.getCounts())
+                chk.write(count);
+        }
+
+        if (Scorr > 0)
+        {
+            chk.write(correlator.getLevels());
+            correlator.write(chk);
+        }
+
+        bathEq.write(chk);
+        bathProd.write(chk);
+
+        // The histogram of the production is continued after the restart
+        chk.write(stats != nullptr);
+
+        if (stats != nullptr)
+            stats->write(chk);
+    }
+
+    if (error || !chk.commit())
+        *err << "`saveCheckpoint()` :> Cannot save checkpoint " << filename << " at step " << step << '\n';
+}
+
+/**************************************************************************************
+ * Loads the state saved by `saveCheckpoint()`. Parameters of the checkpoint have to be
+ * the same as currently set (only Sd may be increased).
+ * @param char* filename of the checkpoint in `Out` folder,
+ * @param uint saved step,
+ * @param OutputMark saved sizes of the output files.
+ * @return True if the state is loaded.
+ *************************************************************************************/
+bool Argon::loadCheckpoint(const char *filename, uint &step, OutputMark &mark) noexcept
+{
+    const std::string path = "../Out/" + std::string(filename);
+    Checkpoint chk;
+
+    if (!chk.open(path.c_str()))
+    {
+        *err << "`loadCheckpoint()` :> Cannot open checkpoint " << path << "\n\n";
+        return false;
+    }
+
+    uint32_t NChk = 0;
+    uint SoChk = 0, SdChk = 0, respaChk = 0;
+    uint SoutChk = 0, SxyzChk = 0, nxChk = 0, nyChk = 0, nzChk = 0;
+    double mChk = 0., eChk = 0., RChk = 0., kChk = 0., fChk = 0., LChk = 0., tauChk = 0., rcChk = 0., skinChk = 0.;
+    double tauMinChk = 0., tauMaxChk = 0., dxMaxChk = 0., dHMaxChk = 0.;
+    uint SadaptChk = 0, SgrChk = 0, grBinsChk = 0, ScorrChk = 0, corrPointsChk = 0;
+    double grMaxChk = 0., TtargetChk = 0., tauTChk = 0., PtargetChk = 0., tauPChk = 0.;
+    uint chainChk = 0, SsortChk = 0;
+    Curve curveChk = Curve::Hilbert;
+    ThermostatKind thermostatEqChk = ThermostatKind::None, thermostatProdChk = ThermostatKind::None;
+    BarostatKind barostatEqChk = BarostatKind::Off, barostatProdChk = BarostatKind::Off;
+    bool adaptiveChk = false, tailChk = false;
+    Boundary boundaryChk = Boundary::Sphere;
+    double boxChk[3] = {0., 0., 0.};
+    Precision precisionChk = Precision::Double;
+    Potential potentialChk = Potential::Analytic;
+    uint tableSizeChk = 0;
+    Engine engineChk = Engine::Exact;
+    TrajectoryFormat trajectoryChk = TrajectoryFormat::Text;
+
+    chk.read(NChk);
+    chk.read(nxChk);
+    chk.read(nyChk);
+    chk.read(nzChk);
+    chk.read(step);
+    chk.read(SoChk);
+    chk.read(SdChk);
+    chk.read(SoutChk);
+    chk.read(SxyzChk);
+    chk.read(mChk);
+    chk.read(eChk);
+    chk.read(RChk);
+    chk.read(kChk);
+    chk.read(fChk);
+    chk.read(LChk);
+    chk.read(tauChk);
+    chk.read(engineChk);
+    chk.read(rcChk);
+    chk.read(skinChk);
+    chk.read(trajectoryChk);
+    chk.read(respaChk);
+    chk.read(precisionChk);
+    chk.read(potentialChk);
+    chk.read(tableSizeChk);
+    chk.read(adaptiveChk);
+    chk.read(tauMinChk);
+    chk.read(tauMaxChk);
+    chk.read(dxMaxChk);
+    chk.read(dHMaxChk);
+    chk.read(SadaptChk);
+    chk.read(SgrChk);
+    chk.read(grMaxChk);
+    chk.read(grBinsChk);
+    chk.read(ScorrChk);
+    chk.read(corrPointsChk);
+    chk.read(thermostatEqChk);
+    chk.read(thermostatProdChk);
+    chk.read(TtargetChk);
+    chk.read(tauTChk);
+    chk.read(chainChk);
+    chk.read(barostatEqChk);
+    chk.read(barostatProdChk);
+    chk.read(PtargetChk);
+    chk.read(tauPChk);
+    chk.read(boundaryChk);
+    chk.read(boxChk[0]);
+    chk.read(boxChk[1]);
+    chk.read(boxChk[2]);
+    chk.read(tailChk);
+    chk.read(SsortChk);
+    chk.read(curveChk);
+
+    const bool thermostats = thermostatEq != ThermostatKind::None || thermostatProd != ThermostatKind::None;
+    const bool barostats = barostatEq != BarostatKind::Off || barostatProd != BarostatKind::Off;
+
+    // Bitwise comparison, the run has to be continued with exactly the same parameters
+    const bool same = NChk == N && nxChk == nx && nyChk == ny && nzChk == nz && SoChk == So && SoutChk == Sout && SxyzChk == Sxyz && mChk == m && eChk == e &&
+                      RChk == R && kChk == k && fChk == f && LChk == L0 && tauChk == tau && engineChk == engine &&
+                      trajectoryChk == trajectory && respaChk == respa && precisionChk == precision && adaptiveChk == adaptive &&
+                      potentialChk == potential && (potential == Potential::Analytic || tableSizeChk == tableSize) &&
+                      (!adaptive || (tauMinChk == tauMin && tauMaxChk == tauMax && dxMaxChk == dxMax && dHMaxChk == dHMax && SadaptChk == Sadapt)) &&
+                      (engine == Engine::Exact || (rcChk == rc && skinChk == skin)) && SgrChk == Sgr &&
+                      (Sgr == 0 || (grMaxChk == grMax && grBinsChk == grBins)) && ScorrChk == Scorr &&
+                      (Scorr == 0 || corrPointsChk == corrPoints) && thermostatEqChk == thermostatEq &&
+                      thermostatProdChk == thermostatProd && (!thermostats || (TtargetChk == Ttarget && tauTChk == tauT && chainChk == chain)) &&
+                      barostatEqChk == barostatEq && barostatProdChk == barostatProd &&
+                      (!barostats || (PtargetChk == Ptarget && tauPChk == tauP)) && boundaryChk == boundary &&
+                      (boundary == Boundary::Sphere ||
+                       (boxChk[0] == box[0] && boxChk[1] == box[1] && boxChk[2] == box[2] && tailChk == tail)) &&
+                      SsortChk == Ssort && (Ssort == 0 || curveChk == curve);
+
+    if (!chk.ok() || !same || step >= So + Sd)
+    {
+        *err << "`loadCheckpoint()` :> Parameters differ from the checkpoint " << path << " (saved after step "
+                  << step << " of " << SoChk + SdChk << ").\n\n";
+        return false;
+    }
+
+    chk.read(V);
+    chk.read(H);
+    chk.read(T);
+    chk.read(P);
+    chk.read(Hmean);
+    chk.read(Tmean);
+    chk.read(Pmean);
+    chk.read(mark);
+    chk.read(dt);
+    chk.read(currentTime);
+    chk.read(steps);
+    chk.read(window);
+    chk.read(Hlow);
+    chk.read(Hhigh);
+    chk.read(L);
+    chk.read(Ek);
+    chk.read(Volmean);
+
+    chk.read(r0);
+    chk.read(p0);
+    chk.read(Fi);
+    chk.read(seed);
+
+    // Random kicks of Langevin depend on the seed of the run
+    setupThermostats();
+
+    if (respa > 1)
+        chk.read(Fw);
+
+    if (Ssort > 0)
+        chk.read(ids.data(), N);
+    else
+        std::iota(ids.begin(), ids.end(), 0u);
+
+    uint rebuilds = 0;
+    Vectors reference(N);
+
+    if (engine == Engine::Verlet)
+    {
+        chk.read(rebuilds);
+        chk.read(reference);
+    }
+
+    Vectors images(boundary == Boundary::Periodic ? N : 0);
+
+    if (boundary == Boundary::Periodic)
+        chk.read(images);
+
+    uint frames = 0;
+    std::vector<uint64_t> counts(Sgr > 0 ? grBins : 0, 0);
+
+    if (Sgr > 0)
+    {
+        chk.read(frames);
+
+        for (uint64_t &count : counts)
+            chk.read(count);
+    }
+
+    // Levels depend on Sd, which may be increased on restart
+    if (Scorr > 0)
+    {
+        uint levels = 0;
+        chk.read(levels);
+
+        if (levels != correlator.getLevels())
+            correlator.setup(N, corrPoints, levels, Scorr * tau);
+
+        correlator.read(chk);
+    }
+
+    bathEq.read(chk);
+    bathProd.read(chk);
+
+    // Without attached statistics the saved histogram is read and dropped
+    bool histogram = false;
+    Stats dropped;
+    chk.read(histogram);
+
+    if (histogram)
+        (stats != nullptr ? stats : &dropped)->read(chk);
+
+    if (!chk.verify())
+    {
+        *err << "`loadCheckpoint()` :> Checkpoint " << path << " is corrupted.\n\n";
+        return false;
+    }
+
+    if (boundary == Boundary::Periodic)
+    {
+        periodicBox.restore(reference, images);
+        neighbors.restore(periodicBox.getPositions(), periodicBox.size(), periodicBox.owners(), rebuilds);
+    }
+    else if (engine == Engine::Verlet)
+        neighbors.restore(reference, rebuilds);
+
+    // The barostat of the thermalisation may have moved the sphere of g(r)
+    if (Sgr > 0)
+    {
+        rdf.setup(N, grMax, grBins, L);
+
+        if (boundary == Boundary::Periodic)
+            rdf.setPeriodic(periodicBox.volume());
+
+        rdf.restore(counts, frames);
+    }
+
+    calculateMomentumAbs();
+
+    *out << "`loadCheckpoint()` :> Successfully loaded checkpoint " << path << '\n';
+
+    return true;
+}
+
+/**************************************************************************************
+ * Sorts atoms in memory along the space-filling curve, so atoms close in space are
+ * close in memory and neighbours read by the pair kernels are mostly in the cache
+ * (the order of the crystal decays by diffusion once it melts). Positions, momenta and
+ * forces are permuted together with IDs of atoms, the output and correlations stay in
+ * the order of IDs. The curve covers the cube [-L, L]^3 of the sphere or the periodic
+ * box (positions wrapped). The neighbor list is built again for the new order. Random
+ * kicks of the Langevin thermostat are drawn for places in memory, not for IDs.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::sortAtoms() noexcept
+{
+    ARGON_PROFILE_SCOPE(Phase::Sort);
+    ARGON_PROFILE_COUNT(Counter::NeighborRebuilds, 1);
+
+    const bool periodic = boundary == Boundary::Periodic;
+    double low[3], size[3];
+
+    for (uint k = 0; k < 3; k++)
+    {
+        size[k] = periodic ? box[k] : 2. * L;
+        low[k] = -0.5 * size[k];
+    }
+
+    std::vector<uint> order;
+    curveOrder(r0, low, size, periodic, curve, forces.getThreads(), order);
+
+    // Gathers vectors in the new order to the scratch array `rw` and exchanges buffers
+    auto permute = [this, &order](Vectors &v)
+    {
+#pragma omp parallel for num_threads(forces.getThreads()) if (forces.getThreads() > 1)
+        for (uint j = 0; j < N; j++)
+        {
+            rw.x[j] = v.x[order[j]];
+            rw.y[j] = v.y[order[j]];
+            rw.z[j] = v.z[order[j]];
+        }
+
+        v.swap(rw);
+    };
+
+    permute(r0);
+    permute(p0);
+    permute(Fi);
+
+    if (respa > 1)
+        permute(Fw);
+
+    std::vector<uint> moved(N);
+
+    for (uint j = 0; j < N; j++)
+        moved[j] = ids[order[j]];
+
+    ids.swap(moved);
+
+    if (periodic)
+    {
+        periodicBox.rebuild(r0);
+        neighbors.build(periodicBox.getPositions(), periodicBox.size(), periodicBox.owners());
+    }
+    else
+        neighbors.build(r0);
+}
+
+/**************************************************************************************
+ * Adds current positions to g(r). Pairs are taken from the Verlet list of the last
+ * force evaluation if it contains all of them (grMax <= rc), otherwise from the cell
+ * grid of `PairCorrelation`. The periodic box uses always the list with ghosts.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::sampleStructure() noexcept
+{
+    if (boundary == Boundary::Periodic)
+        rdf.accumulate(periodicBox.getPositions(), neighbors);
+    else if (engine == Engine::Verlet && grMax <= rc)
+        rdf.accumulate(r0, neighbors);
+    else
+        rdf.accumulate(r0);
+}
+
+/**************************************************************************************
+ * Saves g(r) to the file `rdf` and, if `structure` is on, S(q) to the file of the same
+ * name with suffix `_sq` (e.g. rdf.txt and rdf_sq.txt).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::saveStructure() const noexcept
+{
+    const std::size_t dot = rdfFile.find_last_of('.');
+    const std::string sqFile = (dot == std::string::npos) ? rdfFile + "_sq" : rdfFile.substr(0, dot) + "_sq" + rdfFile.substr(dot);
+
+    if (!rdf.save(rdfFile.c_str()) || (structure && !rdf.saveStructureFactor(sqFile.c_str())))
+        *err << "`simulateDynamics()` :> Cannot save g(r) to ../Out/" << rdfFile << '\n';
+    else
+        *out << "Pair Distribution Frames: " << rdf.getFrames() << '\n';
+}
+
+/**************************************************************************************
+ * Saves MSD and VACF to the file `corr` and prints diffusion constants. The slope of
+ * MSD is fitted where displacements are below L/2, i.e. not bounded by the walls yet
+ * (displacements in the periodic box are not bounded).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::saveCorrelations() const noexcept
+{
+    const double limit = (boundary == Boundary::Periodic) ? INFINITY : 0.25 * L * L;
+    double Dmsd, Dvacf;
+    correlator.diffusion(limit, Dmsd, Dvacf);
+
+    if (!correlator.save(corrFile.c_str(), limit))
+        *err << "`simulateDynamics()` :> Cannot save MSD and VACF to ../Out/" << corrFile << '\n';
+
+    *out << "Diffusion Constant (MSD): " << Dmsd << '\n';
+    *out << "Diffusion Constant (VACF): " << Dvacf << '\n';
+}
+
+/**************************************************************************************
+ * This function evaluates all forces at current positions in one pass: repulsion from
+ * sphere walls (10), (14), pair interactions (9), (13), the total potential and
+ * the pressure on the walls (sum of |Fs_i| over the surface of the sphere). The
+ * periodic box has no walls, its pressure follows from the virial in `calculateHTP()`.
+ * @return Sets forces `Fi` (and `Fw` in r-RESPA), total potential `V` and pressure `P`.
+ *************************************************************************************/
+void Argon::calculateForces() noexcept
+{
+    if (boundary == Boundary::Periodic)
+    {
+        V = Vtail;
+        Fi.zero();
+    }
+    // Forces from sphere walls are kept apart from the pair forces in r-RESPA
+    else if (respa > 1)
+    {
+        V = calculateWallForces(Fw);
+        Fi.zero();
+    }
+    else
+        V = calculateWallForces(Fi);
 
-            for (usint j = 0; j < i; j++)
-            {
-                // Absolute value of r_i - r_j -> |r_i - r_j|
-                double r_ij = sqrt((r0[i][0] - r0[j][0]) * (r0[i][0] - r0[j][0]) + (r0[i][1] - r0[j][1]) * (r0[i][1] - r0[j][1]) +
-                                   (r0[i][2] - r0[j][2]) * (r0[i][2] - r0[j][2]));
-
-                // Local variables to evaluate powers -> huge increase of performance (instead of calculate with common pow())
-                double z = R / r_ij;
-                double y = z * z;
-                double x = y * y * y;
-                // (9)
-                Vp[i][j] = e * x * (x - 2.);
-
-                for (usint k = 0; k < K; k++)
-                {
-                    Fp[i][j][k] = 12. * e * x * (x - 1.) * (r0[i][k] - r0[j][k]) / (r_ij * r_ij);
-
-                    // Symmetry of forces matrix (only one triangular matrix needs to be calculated) -> increase performance
-                    Fi[i][k] += Fp[i][j][k];
-                    Fi[j][k] -= Fp[i][j][k];
-                }
-
-                // Accumulate van der Waals potentials
-                V += Vp[i][j];
-            }
-        } // End of dynamics loop
+    calculatePairForces();
+}
 
-        // Calculate momenta (18c) and absolute values
-        for (usint i = 0; i < N; i++)
-        {
-            for (usint j = 0; j < K; j++)
-            {
-                p0[i][j] = p0[i][j] + 0.5 * Fi[i][j] * tau;
-                pAbs[i] += p0[i][j] * p0[i][j];
-            }
+/**************************************************************************************
+ * This function evaluates repulsion from sphere walls (10), (14) and the pressure on
+ * the walls (sum of |Fs_i| over the surface of the sphere).
+ * @param Vectors where to store forces from sphere walls.
+ * @return Potential of sphere walls. Sets pressure `P`.
+ *************************************************************************************/
+double Argon::calculateWallForces(Vectors &F) noexcept
+{
+    ARGON_PROFILE_SCOPE(Phase::WallForces);
+    double Vw = 0.;
 
-            pAbs[i] = sqrt(pAbs[i]);
-        }
+    P = 0.;
 
-        calculateCurrentHTP();
+    for (uint i = 0; i < N; i++)
+    {
+        // Absolute value of r_i -> |r_i|
+        const double r_i = sqrt(r0.x[i] * r0.x[i] + r0.y[i] * r0.y[i] + r0.z[i] * r0.z[i]);
 
-        // Save temporary positions at given time
-        if (s % Sxyz == 0)
+        // (10) and (14)
+        if (r_i < L)
         {
-            saveCurrentPositions(ofileRt);
+            F.x[i] = 0.;
+            F.y[i] = 0.;
+            F.z[i] = 0.;
         }
-
-        // Save temporary H, T and P at given time
-        if (s % Sout == 0)
+        else
         {
-            saveCurrentHTP(s * tau, ofileHtp);
+            Vw += 0.5 * f * (r_i - L) * (r_i - L);
+            P += f * (r_i - L);
+            F.x[i] = f * (L - r_i) * r0.x[i] / r_i;
+            F.y[i] = f * (L - r_i) * r0.y[i] / r_i;
+            F.z[i] = f * (L - r_i) * r0.z[i] / r_i;
         }
+    }
 
-        // Accumulate mean values only when thermalisation is done
-        if (s >= So)
+    P /= 4. * M_PI * L * L;
+
+    return Vw;
+}
+
+/**************************************************************************************
+ * This function calculates van der Waals interactions (9) and interaction forces (13).
+ * The exact engine takes all pairs of atoms (only one triangular matrix thanks to the
+ * symmetry of forces matrix). The Verlet engine takes only pairs from the neighbor
+ * list which are closer than rc, the potential is shifted by its value at rc. The list
+ * is rebuilt only if some atom has moved more than half of the skin, so the cost is
+ * O(N). `Fi` has to hold forces from sphere walls already (zeros in r-RESPA). In the
+ * periodic box the list holds also ghosts of atoms, which are wrapped and copied at
+ * every build, and forces of ghosts are folded back to atoms.
+ * @return Accumulates pair forces in `Fi` and pair potentials in `V` (virial `W`).
+ *************************************************************************************/
+void Argon::calculatePairForces() noexcept
+{
+    if (boundary == Boundary::Periodic)
+    {
+        periodicBox.update(r0);
+
+        if (neighbors.needsRebuild(periodicBox.getPositions()))
         {
-            Tmean += T;
-            Pmean += P;
-            Hmean += H;
+            ARGON_PROFILE_SCOPE(Phase::NeighborBuild);
+            ARGON_PROFILE_COUNT(Counter::NeighborRebuilds, 1);
+
+            periodicBox.rebuild(r0);
+            neighbors.build(periodicBox.getPositions(), periodicBox.size(), periodicBox.owners());
         }
-    } // End of simulation loop
 
-    printCurrentInfo((So + Sd) * tau); // Latest step
+        ARGON_PROFILE_SCOPE(Phase::PairForces);
+        ARGON_PROFILE_COUNT(Counter::PairEvaluations, neighbors.size());
 
-    // Average the cumulative values
-    Hmean /= Sd;
-    Tmean /= Sd;
-    Pmean /= Sd;
+        Vectors &Fb = periodicBox.getForces();
+        Fb.zero();
 
-    // Ideal gas law -> PV = NkT Volume not potential :)
-    IdealGas = (N * k * Tmean) / (Pmean * Vol);
+        V += forces.list(periodicBox.getPositions(), Fb, neighbors);
+        W = periodicBox.fold(Fi);
+    }
+    else if (engine == Engine::Exact)
+    {
+        ARGON_PROFILE_SCOPE(Phase::PairForces);
+        ARGON_PROFILE_COUNT(Counter::PairEvaluations, N * (N - 1ull) / 2);
 
-    // Chemical potential from microcanonical ensemble
-    u = k * T * log(Vol / N * (4. * M_PI * m * Hmean) / (3. * N) * sqrt((4. * M_PI * m * Hmean) / (3. * N)));
+        V += forces.exact(r0, Fi);
+    }
+    else if (engine == Engine::Verlet)
+    {
+        if (neighbors.needsRebuild(r0))
+        {
+            ARGON_PROFILE_SCOPE(Phase::NeighborBuild);
+            ARGON_PROFILE_COUNT(Counter::NeighborRebuilds, 1);
 
-    std::cout << "Mean Total Energy:        " << Hmean << '\n';
-    std::cout << "Mean Temperature:         " << Tmean << '\n';
-    std::cout << "Mean Pressure:            " << Pmean << '\n';
-    std::cout << "Ideal Gas Law:            " << IdealGas << '\n';
-    std::cout << "Mean Chemical Potential:  " << u << '\n';
-    std::cout << '\n';
+            neighbors.build(r0);
+        }
 
-    ofileRt.close();
-    ofileHtp.close();
+        ARGON_PROFILE_SCOPE(Phase::PairForces);
+        ARGON_PROFILE_COUNT(Counter::PairEvaluations, neighbors.size());
+
+        V += forces.list(r0, Fi, neighbors);
+    }
 }
 
 /**************************************************************************************
  * This function calculates absolute value of momentum for every particle.
- * @return std::tuple<double *, usint, double, double, double> - where the first
+ * @return std::tuple<double *, uint, double, double, double> - where the first
  * parameter is a pointer to array with the absolute momentum values, the second is the
  * size of this array, third is the temperature related to this calculated state, fourth
  * is the Boltzmann constant and the fifth is the particle mass.
  *************************************************************************************/
-std::tuple<double *, usint, double, double, double> Argon::getMomentumAbs() const noexcept
+std::tuple<double *, uint, double, double, double> Argon::getMomentumAbs() const noexcept
 {
     double *pAbsToReturn = new double[N]();
 
-    for (usint i = 0; i < N; i++)
+    for (uint i = 0; i < N; i++)
     {
         pAbsToReturn[i] = pAbs[i];
     }
@@ -650,62 +2423,93 @@ std::tuple<double *, usint, double, double, double> Argon::getMomentumAbs() cons
 }
 
 /**************************************************************************************
- * This function calculates current Hamiltonian, Temperature and Pressure of the
- * system. It uses current momenta and sphere repulsion to this.
+ * Mean values of physical parameters from the last simulation.
+ * @return std::tuple<double, double, double, double, double> - mean Hamiltonian, mean
+ * temperature, mean pressure, ideal gas law ratio and chemical potential.
+ *************************************************************************************/
+std::tuple<double, double, double, double, double> Argon::getMeanValues() const noexcept
+{
+    return std::make_tuple(Hmean, Tmean, Pmean, IdealGas, u);
+}
+
+/**************************************************************************************
+ * This function calculates current Hamiltonian and Temperature of the system from
+ * the kinetic energy and the total potential. Pressure on the sphere walls is already
+ * calculated together with forces, pressure in the periodic box follows from the
+ * virial theorem P = (2 Ek + W) / (3 Vol) + Ptail.
  * @return Calculates Hamiltonian, Temperature and Pressure of the system.
  *************************************************************************************/
-void Argon::calculateCurrentHTP() noexcept
+inline void Argon::calculateHTP() noexcept
 {
-    // Prepare to accumulate physical parameters at initial time
-    H = V; // At this moment Hamiltonian is just total potential
-    T = 0.;
-    P = 0.;
-    Ek = 0.;
+    H = V + Ek;
+    T = 2. / (3. * N * k) * Ek;
 
-    for (usint i = 0; i < N; i++)
-    {
-        // Local variable to increase performance;
-        Ek = (p0[i][0] * p0[i][0] + p0[i][1] * p0[i][1] + p0[i][2] * p0[i][2]) / (2. * m);
+    if (boundary == Boundary::Periodic)
+        P = (2. * Ek + W) / (3. * Vol) + Ptail;
+}
 
-        // Accumulate physical parameters
-        H += Ek;
-        T += 2. / (3. * N * k) * Ek;
-        P += sqrt(Fs[i][0] * Fs[i][0] + Fs[i][1] * Fs[i][1] + Fs[i][2] * Fs[i][2]) / (4. * M_PI * L * L);
+/**************************************************************************************
+ * This function calculates absolute value of momentum for every particle.
+ * @return Sets `pAbs`.
+ *************************************************************************************/
+void Argon::calculateMomentumAbs() noexcept
+{
+    for (uint i = 0; i < N; i++)
+    {
+        pAbs[i] = sqrt(p0.x[i] * p0.x[i] + p0.y[i] * p0.y[i] + p0.z[i] * p0.z[i]);
     }
 }
 
 /**************************************************************************************
- * Writes to file current time, Hamiltonian, Temperature and Pressure of the system.
+ * Writes to file current time, Hamiltonian, Temperature and Pressure of the system
+ * (or passes them to the background writer).
  * @param double current time,
  * @param ofstream file where to save current H, T and P.
  * @return Set subsequent lines with current time, H, T and P in the given file.
  *************************************************************************************/
 inline void Argon::saveCurrentHTP(const double &time, std::ofstream &ofileHtp) noexcept
 {
+    ARGON_PROFILE_SCOPE(Phase::HTP);
+
+    if (writer.running())
+    {
+        writer.pushHTP(time, H, T, P);
+        return;
+    }
+
     ofileHtp << time << '\t' << H << '\t' << T << '\t' << P << '\n';
 }
 
 /**************************************************************************************
- * Writes to file current positions of the atoms.
+ * Writes to file current positions of the atoms. Binary formats are written by
+ * the trajectory writer instead of the given text file. With asynchronous output
+ * positions are only copied and written later by the background thread.
  * @param ofstream file where to save current positions.
  * @return Set subsequent positions of particles in the given file.
  *************************************************************************************/
 void Argon::saveCurrentPositions(std::ofstream &ofileRt) noexcept
 {
-    // Number of atoms to read by Jmol
-    ofileRt << N;
-    ofileRt << "\n\n";
+    ARGON_PROFILE_SCOPE(Phase::Positions);
 
-    for (usint i = 0; i < N; i++)
+    // Positions in the periodic box are saved wrapped (the simulation keeps them unwrapped)
+    // and sorted atoms are saved in the order of IDs, so frames are comparable
+    if (boundary == Boundary::Periodic)
+        periodicBox.wrap(r0, rw, ids.data());
+    else if (Ssort > 0)
     {
-        ofileRt << "AR\t";
-
-        for (usint j = 0; j < K; j++)
-            ofileRt << r0[i][j] << '\t';
-        ofileRt << '\n';
+        for (uint k = 0; k < 3; k++)
+            for (uint i = 0; i < N; i++)
+                rw[k][ids[i]] = r0[k][i];
     }
 
-    ofileRt << '\n';
+    const Vectors &r = (boundary == Boundary::Periodic || Ssort > 0) ? rw : r0;
+
+    if (writer.running())
+        writer.pushPositions(r);
+    else if (trajectory != TrajectoryFormat::Text)
+        trajectoryW.write(r);
+    else
+        writeXYZFrame(ofileRt, r);
 }
 
 /**************************************************************************************
@@ -728,7 +2532,7 @@ void Argon::saveInitialState(const char *rFilename, const char *pFilename, const
     rOut << N << "\n\n";
     pOut << N << '\t' << T << '\t' << k << '\t' << m << "\n\n";
 
-    for (usint i = 0; i < N; i++)
+    for (uint i = 0; i < N; i++)
     {
         // AR beacuse of we analyse Argon gas
         rOut << "AR\t";
@@ -736,8 +2540,8 @@ void Argon::saveInitialState(const char *rFilename, const char *pFilename, const
 
         for (usint j = 0; j < K; j++)
         {
-            rOut << r0[i][j] << '\t';
-            pOut << p0[i][j] << '\t';
+            rOut << r0[j][i] << '\t';
+            pOut << p0[j][i] << '\t';
         }
 
         pOut << pAbs[i] << '\n';
@@ -762,9 +2566,9 @@ void Argon::saveInitialState(const char *rFilename, const char *pFilename, const
  * @param ifstream input.
  * @return True if file is empty, otherwise false.
  *************************************************************************************/
-inline bool Argon::fileIsEmpty(std::ifstream &input) const noexcept
+inline bool Argon::fileIsEmpty(std::istream &input) const noexcept
 {
-    return input.peek() == std::ifstream::traits_type::eof();
+    return input.peek() == std::istream::traits_type::eof();
 }
 
 /**************************************************************************************
@@ -774,11 +2578,426 @@ inline bool Argon::fileIsEmpty(std::ifstream &input) const noexcept
  *************************************************************************************/
 void Argon::printCurrentInfo(const double &time) const noexcept
 {
-    std::cout << std::fixed << std::setprecision(5);
-    std::cout << "Current Time:             " << time << '\n';
-    std::cout << "Current Total Energy:     " << H << '\n';
-    std::cout << "Current Total Potential:  " << V << '\n';
-    std::cout << "Current Temperature:      " << T << '\n';
-    std::cout << "Current Pressure:         " << P << '\n';
-    std::cout << '\n';
+    ARGON_PROFILE_SCOPE(Phase::Info);
+
+    *out << std::fixed << std::setprecision(5);
+    *out << "Current Time:             " << time << '\n';
+    *out << "Current Total Energy:     " << H << '\n';
+    *out << "Current Total Potential:  " << V << '\n';
+    *out << "Current Temperature:      " << T << '\n';
+    *out << "Current Pressure:         " << P << '\n';
+    *out << '\n';
+}
+
+#ifdef ARGON_MPI
+/**************************************************************************************
+ * Runs the simulation on the ranks of the communicator with the domain decomposition
+ * of the periodic box (MPI_COMM_NULL runs the whole system on this process). By
+ * default the constructor uses MPI_COMM_WORLD if the run has several ranks. Buffers
+ * are allocated again, so call it before `setParameters()`.
+ * @param MPI_Comm communicator of ranks sharing the system.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::setDistributed(MPI_Comm comm)
+{
+    distributed = (comm != MPI_COMM_NULL);
+
+    if (distributed)
+        domain.attach(comm);
+
+    if (distributed && domain.getRank() > 0)
+        out = err = &quiet;
+
+    allocate();
+}
+
+/**************************************************************************************
+ * Creates the grid of ranks over the periodic box and the cell grid over the brick of
+ * this rank extended by the layers of ghosts.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::setupDomain()
+{
+    const double halo = rc + skin;
+    double low[3], high[3];
+
+    domain.setup(box, halo);
+    domain.getLower(low);
+    domain.getUpper(high);
+
+    for (uint k = 0; k < 3; k++)
+    {
+        low[k] -= halo;
+        high[k] += halo;
+    }
+
+    // The cell grid is limited by the mean number of atoms of the domain
+    neighbors.setup(N / domain.getRanks() + 1, rc, skin, low, high);
+
+    *out << "`setupDomain()` :> Periodic box divided among " << domain.getRanks() << " ranks, grid " << domain.getDims(0)
+         << " x " << domain.getDims(1) << " x " << domain.getDims(2) << ".\n";
+}
+
+/**************************************************************************************
+ * Initial state of the distributed system. Every rank takes the sites of the crystal (5)
+ * in its brick and draws momenta of these atoms from the counter-based generator by
+ * their IDs, so the system is the same as in the serial run. The centre of mass
+ * movement is removed with the momentum summed over all ranks. Files are written by
+ * rank 0 from the gathered system. Requires the periodic box.
+ * @param char* filename where to save initial positions (nullptr means no files),
+ * @param char* filename where to save initial momenta,
+ * @param char* filename where to save initial H, T and P.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::initialDistributed(const char *rFilename, const char *pFilename, const char *htpFilename) noexcept
+{
+    // Default parameters (restored after invalid ones) are not distributed
+    if (boundary != Boundary::Periodic)
+    {
+        *err << "`initialState()` :> Error - several MPI ranks require the periodic box.\n\n";
+        return;
+    }
+
+    setupForces();
+
+    const double period[3] = {nx * a, ny * a * sqrt(3.) * 0.5, nz * a * sqrt(6.) / 3.};
+    const Philox philox(seed);
+    const double sigma = std::sqrt(m * k * T0);
+
+    domain.clear();
+
+    for (usint j = 0; j < K; j++)
+        p[j] = 0.;
+
+    for (uint i = 0; i < N; i++)
+    {
+        const uint i_0 = i % nx;
+        const uint i_1 = i / nx % ny;
+        const uint i_2 = i / nx / ny;
+        double x[3], px[3];
+
+        for (usint j = 0; j < K; j++)
+        {
+            x[j] = (i_0 - 0.5 * (nx - 1)) * b0[j] + (i_1 - 0.5 * (ny - 1)) * b1[j] + (i_2 - 0.5 * (nz - 1)) * b2[j];
+            x[j] -= std::floor(x[j] / period[j] + 0.5) * period[j];
+        }
+
+        if (!domain.contains(x))
+            continue;
+
+        for (usint j = 0; j < K; j++)
+        {
+            px[j] = sigma * philox.gaussian(i, j, static_cast<uint32_t>(RandomStream::Momenta), 0);
+            p[j] += px[j];
+        }
+
+        domain.add(i, x, px);
+    }
+
+    // Eliminate the centre of mass movement (8)
+    Vectors &pd = domain.momenta();
+    domain.sum(p, K);
+
+    for (usint j = 0; j < K; j++)
+        for (uint i = 0; i < domain.size(); i++)
+            pd[j][i] -= p[j] / N;
+
+    dt = tau;
+    currentTime = 0.;
+    steps = 0;
+    window = 0;
+    Vol = box[0] * box[1] * box[2];
+
+    // Initial forces, potential and pressure
+    calculateDistributedForces();
+
+    double sums[3] = {0., V, W};
+
+    for (uint i = 0; i < domain.size(); i++)
+        sums[0] += pd.x[i] * pd.x[i] + pd.y[i] * pd.y[i] + pd.z[i] * pd.z[i];
+
+    domain.sum(sums, 3);
+    Ek = sums[0] / (2. * m);
+    V = Vtail + sums[1];
+    W = sums[2];
+    calculateHTP();
+
+    Hlow = H;
+    Hhigh = H;
+
+    initialStateCheck = true;
+
+    if (rFilename == nullptr)
+    {
+        *out << "`initialState()` :> Successfully calculated initial state.\n\n";
+        return;
+    }
+
+    domain.gather(domain.unwrapped(), r0, false);
+    gatherMomenta();
+
+    if (domain.getRank() == 0)
+        saveInitialState(rFilename, pFilename, htpFilename);
+
+    *out << "`initialState()` :> Successfully calculated and saved initial state.\n\n";
+}
+
+/**************************************************************************************
+ * The simulation loop of the distributed system (NVE). H, T and P are reduced over
+ * ranks in every step and rank 0 writes all files: positions gathered every `Sxyz`
+ * steps, H, T and P every `Sout` steps and momentum statistics from momenta gathered
+ * every `Sout` steps of the production.
+ * @param char* filename where to save current positions,
+ * @param char* filename where to save current H, T and P.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Argon::runDistributed(const char *rFilename, const char *htpFilename) noexcept
+{
+    const bool root = (domain.getRank() == 0);
+    const std::string rPath = "../Out/" + std::string(rFilename);
+    const double extent = 0.5 * std::max({box[0], box[1], box[2]});
+
+    std::ofstream ofileRt;
+    std::ofstream ofileHtp;
+
+    if (root)
+    {
+        ofileHtp.open("../Out/" + std::string(htpFilename), std::ios::out);
+
+        if (trajectory == TrajectoryFormat::Text)
+            ofileRt.open(rPath, std::ios::out);
+        else if (!trajectoryW.open(rPath.c_str(), trajectory, N, Sxyz * tau, extent))
+            *err << "`simulateDynamics()` :> Cannot open binary trajectory " << rPath << '\n';
+    }
+
+    ofileRt << std::fixed << std::setprecision(5);
+    ofileHtp << std::fixed << std::setprecision(5);
+
+    // Positions are gathered on rank 0 in the order of IDs and wrapped into the box
+    auto savePositions = [this, root, &ofileRt]()
+    {
+        ARGON_PROFILE_SCOPE(Phase::Positions);
+        domain.gather(domain.unwrapped(), r0, true);
+
+        if (root && trajectory != TrajectoryFormat::Text)
+            trajectoryW.write(r0);
+        else if (root)
+            writeXYZFrame(ofileRt, r0);
+    };
+
+    savePositions();
+
+    if (root)
+        saveCurrentHTP(0., ofileHtp);
+
+    printCurrentInfo(0.);
+
+    if (stats != nullptr)
+        stats->setSystem(k, m);
+
+    // Informations print interval
+    const uint infoOut = std::max(Sd / 10, 1u);
+
+    for (uint s = 1; s <= So + Sd; s++)
+    {
+        integrateDistributed();
+
+        currentTime = s * tau;
+        steps++;
+
+        if (s % infoOut == 0 && s < So + Sd)
+            printCurrentInfo(currentTime);
+
+        if (s % Sxyz == 0)
+            savePositions();
+
+        if (s % Sout == 0 && root)
+            saveCurrentHTP(currentTime, ofileHtp);
+
+        // Steps So + 1 ... So + Sd, as in `simulateDynamics()`
+        if (s > So)
+        {
+            Tmean += T;
+            Pmean += P;
+            Hmean += H;
+            Volmean += Vol;
+        }
+
+        // Every rank takes part in the gather, rank 0 accumulates the statistics
+        if (s > So && s % Sout == 0)
+        {
+            gatherMomenta();
+
+            if (root && stats != nullptr)
+                stats->accumulate(pAbs, N, T);
+        }
+    }
+
+    printCurrentInfo(currentTime); // Latest step
+    gatherMomenta();
+
+    // Average the cumulative values
+    Hmean /= Sd;
+    Tmean /= Sd;
+    Pmean /= Sd;
+    Volmean /= Sd;
+
+    // Ideal gas law -> PV = NkT Volume not potential :)
+    IdealGas = (N * k * Tmean) / (Pmean * Vol);
+
+    // Chemical potential from microcanonical ensemble
+    u = k * T * log(Vol / N * (4. * M_PI * m * Hmean) / (3. * N) * sqrt((4. * M_PI * m * Hmean) / (3. * N)));
+
+    *out << "Mean Total Energy:        " << Hmean << '\n';
+    *out << "Mean Temperature:         " << Tmean << '\n';
+    *out << "Mean Pressure:            " << Pmean << '\n';
+    *out << "Ideal Gas Law:            " << IdealGas << '\n';
+    *out << "Mean Chemical Potential:  " << u << '\n';
+    *out << "Neighbor List Rebuilds:   " << neighbors.getRebuilds() << '\n';
+    *out << "MPI Ranks:                " << domain.getRanks() << '\n';
+    *out << '\n';
+
+    ofileRt.close();
+    ofileHtp.close();
+    trajectoryW.close();
+}
+
+/**************************************************************************************
+ * `advance()` of the distributed system: steps without output, momenta are gathered on
+ * rank 0 at the end.
+ * @param uint number of steps.
+ * @return AdvanceReport like `advance()`, pairs are summed over ranks and the locality
+ * of the list is the one of this rank.
+ *************************************************************************************/
+AdvanceReport Argon::advanceDistributed(const uint &count) noexcept
+{
+    AdvanceReport report{H, H, 0., 0, 0., 0.};
+    uint64_t pairs = 0;
+
+    for (uint s = 0; s < count; s++)
+    {
+        integrateDistributed();
+
+        currentTime += dt;
+        steps++;
+
+        report.drift = std::max(report.drift, std::abs(H - report.H0) / std::abs(report.H0));
+        report.T += T / count;
+        pairs += neighbors.size();
+    }
+
+    gatherMomenta();
+    report.H = H;
+    report.pairs = domain.sum(pairs);
+    report.span = neighbors.span();
+
+    return report;
+}
+
+/**************************************************************************************
+ * Single step of the velocity Verlet integrator (18a), (18b), (18c) over atoms of the
+ * domain. Atoms may migrate to other ranks during the force evaluation, so the second
+ * half of the kick takes the new atoms of the domain. H, T and P of the whole system
+ * are reduced in every step (a single reduction of three numbers).
+ * @return Updates positions, momenta, forces, potential and pressure.
+ *************************************************************************************/
+void Argon::integrateDistributed() noexcept
+{
+    Vectors &r = domain.unwrapped();
+    Vectors &pd = domain.momenta();
+    Vectors &F = domain.forces();
+
+    // Calculate auxiliary momenta (18a) and positions (18b)
+    {
+        ARGON_PROFILE_SCOPE(Phase::KickDrift);
+        const uint atoms = domain.size();
+
+#pragma omp parallel for num_threads(forces.getThreads()) if (forces.getThreads() > 1)
+        for (uint i = 0; i < atoms; i++)
+        {
+            pd.x[i] = pd.x[i] + 0.5 * F.x[i] * dt;
+            pd.y[i] = pd.y[i] + 0.5 * F.y[i] * dt;
+            pd.z[i] = pd.z[i] + 0.5 * F.z[i] * dt;
+            r.x[i] = r.x[i] + pd.x[i] * dt / m;
+            r.y[i] = r.y[i] + pd.y[i] * dt / m;
+            r.z[i] = r.z[i] + pd.z[i] * dt / m;
+        }
+    }
+
+    // (9), (13) and migration of atoms
+    calculateDistributedForces();
+
+    double sums[3] = {0., V, W};
+
+    {
+        ARGON_PROFILE_SCOPE(Phase::Kick);
+        const uint atoms = domain.size();
+        double sum = 0.;
+
+#pragma omp parallel for num_threads(forces.getThreads()) if (forces.getThreads() > 1) reduction(+ : sum)
+        for (uint i = 0; i < atoms; i++)
+        {
+            pd.x[i] = pd.x[i] + 0.5 * F.x[i] * dt;
+            pd.y[i] = pd.y[i] + 0.5 * F.y[i] * dt;
+            pd.z[i] = pd.z[i] + 0.5 * F.z[i] * dt;
+
+            sum += pd.x[i] * pd.x[i] + pd.y[i] * pd.y[i] + pd.z[i] * pd.z[i];
+        }
+
+        sums[0] = sum;
+    }
+
+    domain.sum(sums, 3);
+    Ek = sums[0] / (2. * m);
+    V = Vtail + sums[1];
+    W = sums[2];
+    calculateHTP();
+}
+
+/**************************************************************************************
+ * Pair forces of the domain. The list is rebuilt on all ranks together when some atom
+ * of any domain has moved more than half of the skin: atoms migrate to the ranks of
+ * their bricks and ghosts are exchanged again. Otherwise only positions of ghosts are
+ * updated. Forces of ghosts are sent back to the ranks of their atoms.
+ * @return Sets forces of the domain, its pair potential `V` and virial `W` (sums over
+ * ranks follow in `integrateDistributed()`).
+ *************************************************************************************/
+void Argon::calculateDistributedForces() noexcept
+{
+    domain.update();
+
+    if (domain.any(neighbors.needsRebuild(domain.positions())))
+    {
+        ARGON_PROFILE_SCOPE(Phase::NeighborBuild);
+        ARGON_PROFILE_COUNT(Counter::NeighborRebuilds, 1);
+
+        domain.migrate();
+        domain.exchange();
+        neighbors.build(domain.positions(), domain.size(), domain.total(), domain.getIds());
+    }
+    else
+        domain.forward();
+
+    ARGON_PROFILE_SCOPE(Phase::PairForces);
+    ARGON_PROFILE_COUNT(Counter::PairEvaluations, neighbors.size());
+
+    Vectors &F = domain.forces();
+    F.zero();
+
+    V = forces.list(domain.positions(), F, neighbors);
+    W = domain.fold();
+}
+
+/**************************************************************************************
+ * Gathers momenta of all atoms on rank 0 in the order of IDs and calculates their
+ * absolute values (`getMomentumAbs()` of rank 0).
+ * @return Sets `p0` and `pAbs` of rank 0.
+ *************************************************************************************/
+void Argon::gatherMomenta() noexcept
+{
+    domain.gather(domain.momenta(), p0, false);
+
+    if (domain.getRank() == 0)
+        calculateMomentumAbs();
 }
+#endif // ARGON_MPI
@@ -1,32 +1,180 @@
 #ifndef ARGON_H
 #define ARGON_H
-#include <random>
 #include <fstream>
+#include <ostream>
 #include <tuple>
+#include <string>
+#include <cstdint>
+#include <vector>
+#include "neighbors.h"
+#include "vectors.h"
+#include "forces.h"
+#include "trajectory.h"
+#include "writer.h"
+#include "checkpoint.h"
+#include "rdf.h"
+#include "correlator.h"
+#include "philox.h"
+#include "thermostat.h"
+#include "box.h"
+#include "curve.h"
+#include "domain.h"
 typedef unsigned short int usint;
 typedef unsigned int uint;
 
+class Stats;
+
+/// Available methods of pair forces evaluation
+enum class Engine : usint
+{
+    Exact,  ///< All pairs without cutoff (reference)
+    Verlet, ///< Truncated and shifted potential with linked cells and Verlet neighbor list
+};
+
+/// Largest number of atoms: the Verlet list keeps about 46 neighbours of every atom
+/// with 32-bit offsets, so 46 N has to stay well below 2^32
+constexpr uint64_t MaxAtoms = 1ull << 26;
+
+/// Atoms in the single block of the parallel initialisation, sums over the fixed blocks
+/// do not depend on the number of threads
+constexpr uint InitBlock = 4096;
+
+/// Evaluation of the pair potential in the kernels
+enum class Potential : usint
+{
+    Analytic, ///< Formula (9) for every pair
+    Table,    ///< Cubic Hermite table of V(r^2) (Verlet engine)
+};
+
+/// Streams of random numbers (third word of the Philox counter after atom and component)
+enum class RandomStream : uint32_t
+{
+    Momenta,  ///< Initial momenta
+    Langevin, ///< Random kicks of the Langevin thermostat
+};
+
+/// Sizes of the output files at the moment of the checkpoint
+struct OutputMark
+{
+    uint64_t rtBytes;  ///< Size of the file with positions
+    uint64_t htpBytes; ///< Size of the file with H, T and P
+    uint64_t frames;   ///< Number of frames of the binary trajectory
+};
+
+/// Summary of `Argon::advance()` used by benchmarks
+struct AdvanceReport
+{
+    double H0;      ///< Hamiltonian before the first step
+    double H;       ///< Hamiltonian after the last step
+    double drift;   ///< Maximum of |H - H0| / |H0| over all steps
+    uint64_t pairs; ///< Number of evaluated pair interactions
+    double T;       ///< Mean temperature over all steps
+    double span;    ///< Mean distance |i - j| in memory of listed pairs at the end (Verlet engine)
+};
+
 class Argon
 {
 private:
+    std::ostream *out; ///< Stream of messages
+    std::ostream *err; ///< Stream of errors
+
     /// Declaration of parameters describing the system
-    usint n;    ///< Number of atoms along the crystal edge
+    uint n;     ///< Number of atoms along the crystal edge
+    uint nx;    ///< Number of atoms along the first edge (0 means n)
+    uint ny;    ///< Number of atoms along the second edge (0 means n)
+    uint nz;    ///< Number of atoms along the third edge (0 means n)
     uint So;    ///< Thermalisation steps
     uint Sd;    ///< Number of steps of core simulation
-    usint Sout; ///< Save informations about the system every `Sout` steps
-    usint Sxyz; ///< Save positions of atoms every `Sxyz` steps
+    uint Sout;  ///< Save informations about the system every `Sout` steps
+    uint Sxyz;  ///< Save positions of atoms every `Sxyz` steps
     double m;   ///< Mass of the single atom
     double e;   ///< Minimum of the potential
     double R;   ///< Interatomic distance for which occurs minimum of the potential
     double k;   ///< Boltzmann constant
     double f;   ///< Elastic coefficient
-    double L;   ///< Radius of sphere which confines atoms
+    double L;   ///< Radius of sphere which confines atoms (moved by the barostat)
+    double L0;  ///< Radius of sphere from parameters
     double a;   ///< Interatomic distance
     double T0;  ///< Initial temperature
     double tau; ///< Integration step
+    uint respa; ///< Number of inner sub-steps of the sphere walls in the r-RESPA step (1 means velocity Verlet)
+
+    /// Declaration of parameters describing the adaptive integration step
+    bool adaptive; ///< Adapt the step to the energy error and displacements of atoms (`tau` is the initial step)
+    double tauMin; ///< Lower limit of the adaptive step
+    double tauMax; ///< Upper limit of the adaptive step
+    double dxMax;  ///< Largest displacement of an atom in the single adaptive step
+    double dHMax;  ///< Largest relative fluctuation of H over `Sadapt` steps
+    uint Sadapt;   ///< Adapt the step by the fluctuation of H every `Sadapt` steps
+
+    /// Declaration of parameters describing the temperature and pressure control
+    ThermostatKind thermostatEq;   ///< Thermostat of the thermalisation (steps up to So)
+    ThermostatKind thermostatProd; ///< Thermostat of the production
+    double Ttarget;                ///< Target temperature of thermostats (0 means T0)
+    double tauT;                   ///< Coupling time of thermostats
+    uint chain;                    ///< Number of thermostats of the Nose-Hoover chain
+    BarostatKind barostatEq;       ///< Barostat of the thermalisation
+    BarostatKind barostatProd;     ///< Barostat of the production
+    double Ptarget;                ///< Target pressure on the sphere walls
+    double tauP;                   ///< Coupling time of the barostat
+
+    Thermostat bathEq;   ///< Thermostat of the thermalisation
+    Thermostat bathProd; ///< Thermostat of the production
+
+    /// Declaration of parameters describing the periodic box
+    Boundary boundary; ///< Sphere walls or the periodic box
+    double box[3];     ///< Edges Lx, Ly, Lz of the periodic box (0 means the period of the crystal)
+    bool tail;         ///< Add long-range corrections of the truncated potential to V and P (periodic box)
+
+    PeriodicBox periodicBox; ///< Wrapped atoms and their periodic images
+
+    /// Declaration of parameters describing the force engine
+    Engine engine;       ///< Method of pair forces evaluation
+    double rc;           ///< Cutoff radius of the pair potential (Verlet engine)
+    double skin;         ///< Thickness of the Verlet skin (Verlet engine)
+    Isa isa;             ///< Requested instruction set of the pair kernels
+    Precision precision; ///< Precision of the pair kernels (mixed computes pair terms in float)
+    Potential potential; ///< Evaluation of the pair potential
+    uint tableSize;      ///< Number of intervals of the tabulated potential
+    uint threads;        ///< Number of threads of the pair forces evaluation (0 means all available)
+    uint Ssort;          ///< Sort atoms in memory along the space-filling curve every `Ssort` steps (0 means never)
+    Curve curve;         ///< Space-filling curve of the sorting
+
+    PairForces forces;      ///< Pair forces evaluated by SIMD kernels on several threads
+
+#ifdef ARGON_MPI
+    /// Declaration of the domain decomposition over MPI ranks
+    bool distributed;            ///< Atoms are distributed over domains of ranks (every rank evaluates its domain)
+    Domain domain;               ///< Brick of the periodic box of this rank with its atoms and ghosts
+    std::ostream quiet{nullptr}; ///< Stream without buffer, drops messages of ranks other than 0
+#endif
+
+    /// Declaration of parameters describing the output
+    TrajectoryFormat trajectory;  ///< Format of the file with positions from the whole simulation
+    TrajectoryWriter trajectoryW; ///< Writer of the binary trajectory
+    bool asyncOutput;             ///< Write positions and H, T, P on the background thread
+    uint outputSlots;             ///< Number of snapshots buffered by the background writer
+    AsyncWriter writer;           ///< Background writer
+    uint Schk;                    ///< Save checkpoint every `Schk` steps (0 means never)
+    std::string checkpoint;       ///< Name of the checkpoint file in `Out` folder
+
+    /// Declaration of parameters describing the structure analysis
+    uint Sgr;             ///< Accumulate g(r) every `Sgr` steps of the production (0 means never)
+    double grMax;         ///< Largest distance of g(r)
+    uint grBins;          ///< Number of bins of g(r)
+    std::string rdfFile;  ///< Name of the file with g(r) in `Out` folder
+    bool structure;       ///< Save also the static structure factor S(q) next to g(r)
+    uint Scorr;           ///< Add positions and velocities to MSD and VACF every `Scorr` steps of the production (0 means never)
+    uint corrPoints;      ///< Number of samples kept on every level of the multiple-tau correlator
+    std::string corrFile; ///< Name of the file with MSD and VACF in `Out` folder
+
+    NeighborList neighbors;        ///< Linked cells and Verlet list of neighbours
+    Stats *stats;                  ///< Momentum statistics accumulated every `Sout` steps of the production (not owned)
+    PairCorrelation rdf;           ///< Radial distribution function accumulated every `Sgr` steps of the production
+    MultiTauCorrelator correlator; ///< MSD and VACF accumulated every `Scorr` steps of the production
 
     /// Declaration of internal parameters
-    usint N; ///< Total number of atoms (this especially denotes number of rows in the position and momentum arrays)
+    uint N;  ///< Total number of atoms (this especially denotes number of rows in the position and momentum arrays)
     usint K; ///< Dimension (this especially denotes number of columns in the position and momentum arrays)
 
     /// Declaration of bufors
@@ -36,18 +184,19 @@ private:
 
     double *p;    ///< 1D array to store sum of momentum in each axis
     double *pAbs; ///< 1D array to store absolute value of momentum for every particle
-    double *Vs;   ///< 1D array to store trapping potentials
 
-    double **r0; ///< 2D array to store atoms positions
-    double **p0; ///< 2D array to store atoms momentum
-    double **Vp; ///< 2D array to store van der Waals interactions
-    double **Fs; ///< 2D array to store repulsion from sphere walls
-    double **Fi; ///< 2D array to store total forces impact to atoms
+    Vectors r0; ///< Array of vectors to store atoms positions
+    Vectors p0; ///< Array of vectors to store atoms momentum
+    Vectors Fi; ///< Array of vectors to store total forces impact to atoms (only pair forces in r-RESPA)
+    Vectors Fw; ///< Array of vectors to store forces from sphere walls (r-RESPA)
+    Vectors rw; ///< Array of vectors to store positions in the order of IDs, wrapped into the periodic box (output)
 
-    double ***Fp; ///< 3D array to store interaction forces between atoms
+    std::vector<uint> ids; ///< ID of the atom in every place of the arrays (sorting permutes atoms in memory)
+
+    std::vector<double> kinetic; ///< Doubled kinetic energy of the blocks of atoms in the last step
 
     bool initialStateCheck; ///< Indicates if initial state is calculated
-    std::mt19937 mt;        ///< High definition pseudo-random number generator
+    uint64_t seed;          ///< Seed of the counter-based generator (Philox)
 
     // Physical parameters related to system
     double V;        ///< Total potential energy;
@@ -55,31 +204,88 @@ private:
     double T;        ///< Temperature of the system at a given moment in time
     double P;        ///< Pressure of the system at a given moment in time
     double Ek;       ///< Kinetic energy at a given moment in time
-    double Vol;      ///< Volume of the system (sphere)
+    double Vol;      ///< Volume of the system (sphere or box)
+    double W;        ///< Virial of pair forces sum r_ij F_ij (periodic box)
+    double Vtail;    ///< Correction of the potential energy for pairs beyond rc (periodic box)
+    double Ptail;    ///< Correction of the pressure for pairs beyond rc (periodic box)
     double IdealGas; ///< It should be around 1 if the ideal gas formula is fulfilled
 
+    // Progress of the simulation
+    double dt;          ///< Current integration step (equal to `tau` unless the step is adaptive)
+    double currentTime; ///< Simulated time
+    uint64_t steps;     ///< Number of integration steps (force evaluations) of the simulation
+    uint window;        ///< Steps since the last change of the adaptive step
+    double Hlow;        ///< Lowest H since the last change of the adaptive step
+    double Hhigh;       ///< Highest H since the last change of the adaptive step
+
     // Mean values of physical parameters
-    double Hmean; ///< Mean Hamiltonian
-    double Tmean; ///< Mean Temperature
-    double Pmean; ///< Mean Pressure
-    double u;     ///< Mean Chemical potential
+    double Hmean;   ///< Mean Hamiltonian
+    double Tmean;   ///< Mean Temperature
+    double Pmean;   ///< Mean Pressure
+    double Volmean; ///< Mean Volume (changes with the barostat)
+    double u;       ///< Mean Chemical potential
 
-    void calculateCurrentHTP() noexcept;
+    void setDefaultParameters() noexcept;
+    void allocate();
+    uint64_t requiredMemory() const noexcept;
+    void setupForces();
+    void runDynamics(const char *rFilename, const char *htpFilename, const uint &first, const OutputMark *mark) noexcept;
+    void controlledStep(const bool &observe, Thermostat &bath, const BarostatKind &barostat) noexcept;
+    void integrate(const bool &observe) noexcept;
+    void integrateRespa(const bool &observe) noexcept;
+    void kick(const bool &observe) noexcept;
+    void adaptStep() noexcept;
+    void scaleRadius() noexcept;
+    void setupThermostats();
+    void setupBox();
+    void sortAtoms() noexcept;
+    void calculateForces() noexcept;
+    double calculateWallForces(Vectors &F) noexcept;
+    void calculatePairForces() noexcept;
+    void sampleStructure() noexcept;
+    void saveStructure() const noexcept;
+    void saveCorrelations() const noexcept;
+    void calculateHTP() noexcept;
+    void calculateMomentumAbs() noexcept;
     void saveCurrentHTP(const double &time, std::ofstream &ofileHtp) noexcept;
     void saveCurrentPositions(std::ofstream &ofileRt) noexcept;
+    void saveCheckpoint(const uint &step, const char *rFilename, const char *htpFilename, std::ofstream &ofileRt,
+                        std::ofstream &ofileHtp) noexcept;
+    bool loadCheckpoint(const char *filename, uint &step, OutputMark &mark) noexcept;
     void saveInitialState(const char *rFilename, const char *pFilename, const char *htpFilename) const noexcept;
-    bool fileIsEmpty(std::ifstream &input) const noexcept;
+    bool fileIsEmpty(std::istream &input) const noexcept;
     void printCurrentInfo(const double &time) const noexcept;
 
+#ifdef ARGON_MPI
+    void setupDomain();
+    void initialDistributed(const char *rFilename, const char *pFilename, const char *htpFilename) noexcept;
+    void runDistributed(const char *rFilename, const char *htpFilename) noexcept;
+    AdvanceReport advanceDistributed(const uint &count) noexcept;
+    void integrateDistributed() noexcept;
+    void calculateDistributedForces() noexcept;
+    void gatherMomenta() noexcept;
+#endif
+
 public:
     Argon() noexcept;
+    Argon(std::ostream &out, std::ostream &err) noexcept;
     ~Argon() noexcept;
 
-    void setParameters(const char *filename);
+    bool setParameters(const char *filename);
+    bool setParameters(std::istream &input, const std::string &source);
+    void setSeed(const uint64_t &seed) noexcept;
+    void attachStats(Stats *stats) noexcept;
     void checkParameters() const noexcept;
     void initialState(const char *rFilename, const char *pFilename, const char *htpFilename) noexcept;
     void simulateDynamics(const char *rFilename, const char *htpFilename) noexcept;
-    std::tuple<double *, usint, double, double, double> getMomentumAbs() const noexcept;
+    AdvanceReport advance(const uint &count) noexcept;
+    bool restart(const char *checkpointFilename, const char *rFilename, const char *htpFilename) noexcept;
+    std::tuple<double *, uint, double, double, double> getMomentumAbs() const noexcept;
+    std::tuple<double, double, double, double, double> getMeanValues() const noexcept;
+
+#ifdef ARGON_MPI
+    void setDistributed(MPI_Comm comm);
+#endif
 };
 
 #endif // ARGON_H
\ No newline at end of file
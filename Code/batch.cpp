@@ -0,0 +1,257 @@
+#include "batch.h"
+#include "argon.h"
+#include "stats.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    /// Single replica of the batch with its results
+    struct Replica
+    {
+        std::string name;       ///< Prefix of the output files
+        std::string source;     ///< File with parameters
+        std::string parameters; ///< Parameters with overrides as `name value` lines
+        uint seed;              ///< Seed of the initial momenta
+        uint N;                 ///< Number of atoms
+        uint steps;             ///< Number of steps So + Sd
+        double cost;            ///< Estimated number of pair evaluations and atom updates
+        bool ok;                ///< True if the replica has finished
+        double seconds;         ///< Time of the replica
+        double Hmean;           ///< Mean Hamiltonian
+        double Tmean;           ///< Mean Temperature
+        double Pmean;           ///< Mean Pressure
+        double IdealGas;        ///< Ideal gas law ratio
+        double u;               ///< Chemical potential
+    };
+
+    /**************************************************************************************
+     * Reads `name value` pairs from the parameters file, replaces values given in
+     * the overrides (new names are appended) and estimates the cost of the replica.
+     *************************************************************************************/
+    bool composeParameters(Replica &replica, std::istream &overrides)
+    {
+        std::ifstream input("../Config/" + replica.source, std::ios::in);
+
+        if (input.fail())
+            return false;
+
+        std::vector<std::pair<std::string, std::string>> values;
+        std::string name, value;
+
+        while (input >> name >> value)
+            values.emplace_back(name, value);
+
+        while (overrides >> name >> value)
+        {
+            auto it = std::find_if(values.begin(), values.end(), [&name](const std::pair<std::string, std::string> &v)
+                                   { return v.first == name; });
+
+            if (it != values.end())
+                it->second = value;
+            else
+                values.emplace_back(name, value);
+        }
+
+        std::ostringstream parameters;
+        // Defaults of Argon if the file does not set them
+        double n = 6., nx = 0., ny = 0., nz = 0., So = 5000., Sd = 50000.;
+        bool verlet = false;
+
+        // Bad numbers (like `n abc`) make the replica invalid instead of ending the batch
+        try
+        {
+            for (const auto &v : values)
+            {
+                parameters << v.first << '\t' << v.second << '\n';
+
+                if (v.first == "n")
+                    n = std::stod(v.second);
+                else if (v.first == "nx")
+                    nx = std::stod(v.second);
+                else if (v.first == "ny")
+                    ny = std::stod(v.second);
+                else if (v.first == "nz")
+                    nz = std::stod(v.second);
+                else if (v.first == "So")
+                    So = std::stod(v.second);
+                else if (v.first == "Sd")
+                    Sd = std::stod(v.second);
+                else if (v.first == "engine")
+                    verlet = (v.second == "verlet");
+            }
+        }
+        catch (const std::invalid_argument &)
+        {
+            return false;
+        }
+        catch (const std::out_of_range &)
+        {
+            return false;
+        }
+
+        // About 46 neighbours of every atom in the Verlet list
+        const double N = (nx > 0. ? nx : n) * (ny > 0. ? ny : n) * (nz > 0. ? nz : n);
+        const double pairs = verlet ? 46. * N : 0.5 * N * (N - 1.);
+
+        replica.parameters = parameters.str();
+        replica.N = N;
+        replica.steps = So + Sd;
+        replica.cost = (So + Sd) * (pairs + 10. * N);
+
+        return true;
+    }
+
+    /**************************************************************************************
+     * Runs the whole simulation of the single replica as `main()` does, with messages
+     * in the log file of the replica.
+     *************************************************************************************/
+    void runReplica(Replica &replica)
+    {
+        const std::string prefix = replica.name + "_";
+        std::ofstream log("../Out/" + replica.name + ".log", std::ios::out);
+
+        auto t0 = std::chrono::steady_clock::now();
+
+        Argon *A = new Argon(log, log);
+        std::istringstream input(replica.parameters);
+
+        if (!A->setParameters(input, "../Config/" + replica.source))
+        {
+            delete A;
+            return;
+        }
+
+        A->setSeed(replica.seed);
+        A->checkParameters();
+        A->initialState((prefix + "r0.txt").c_str(), (prefix + "p0.txt").c_str(), (prefix + "htp0.txt").c_str());
+
+        Stats *S = new Stats;
+        A->attachStats(S);
+
+        A->simulateDynamics((prefix + "rt.txt").c_str(), (prefix + "htp.txt").c_str());
+        std::tie(replica.Hmean, replica.Tmean, replica.Pmean, replica.IdealGas, replica.u) = A->getMeanValues();
+        delete A;
+
+        S->evaluateHist((prefix + "hist.txt").c_str());
+        delete S;
+
+        auto t1 = std::chrono::steady_clock::now();
+        replica.seconds = std::chrono::duration<double>(t1 - t0).count();
+        replica.ok = true;
+    }
+} // namespace
+
+bool runBatch(const char *batchFilename, const char *summaryFilename, const uint &nWorkers)
+{
+    std::ifstream input("../Config/" + std::string(batchFilename), std::ios::in);
+
+    if (input.fail())
+    {
+        std::cerr << "`runBatch()` :> Cannot open batch file ../Config/" << batchFilename << "\n\n";
+        return false;
+    }
+
+    std::vector<Replica> replicas;
+    std::string line;
+
+    while (std::getline(input, line))
+    {
+        std::istringstream fields(line);
+        Replica replica{};
+
+        if (!(fields >> replica.name) || replica.name[0] == '#')
+            continue;
+
+        if (!(fields >> replica.source >> replica.seed) || !composeParameters(replica, fields))
+        {
+            std::cerr << "`runBatch()` :> Invalid replica: " << line << "\n\n";
+            return false;
+        }
+
+        replicas.push_back(replica);
+    }
+
+    // Longest processing time first: idle workers take the most expensive replica left
+    std::vector<std::size_t> order(replicas.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&replicas](const std::size_t &a, const std::size_t &b)
+                     { return replicas[a].cost > replicas[b].cost; });
+
+    const uint workers = std::min<std::size_t>(std::max(1u, nWorkers > 0 ? nWorkers : std::thread::hardware_concurrency()),
+                                               std::max<std::size_t>(1, replicas.size()));
+
+    std::cout << "`runBatch()` :> Running " << replicas.size() << " replicas on " << workers << " worker(s).\n";
+
+    std::atomic<std::size_t> next(0);
+    std::mutex print;
+    std::vector<std::thread> pool;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    for (uint w = 0; w < workers; w++)
+    {
+        pool.emplace_back([&]()
+                          {
+            for (std::size_t q = next++; q < order.size(); q = next++)
+            {
+                Replica &replica = replicas[order[q]];
+                runReplica(replica);
+
+                std::lock_guard<std::mutex> lock(print);
+                std::cout << "`runBatch()` :> Replica " << replica.name << (replica.ok ? " finished in " : " FAILED after ")
+                          << replica.seconds << " s.\n";
+            } });
+    }
+
+    for (std::thread &worker : pool)
+        worker.join();
+
+    auto t1 = std::chrono::steady_clock::now();
+    const double makespan = std::chrono::duration<double>(t1 - t0).count();
+    double busy = 0.;
+    bool ok = true;
+
+    std::ofstream summary("../Out/" + std::string(summaryFilename), std::ios::out);
+    std::ostringstream table;
+
+    table << std::fixed << std::setprecision(5);
+    table << "name\tseed\tN\tsteps\ttime (s)\tHmean (kJ/mol)\tTmean (K)\tPmean (atm)\tIdealGas\tu\n";
+
+    for (const Replica &replica : replicas)
+    {
+        table << replica.name << '\t' << replica.seed << '\t' << replica.N << '\t' << replica.steps << '\t';
+
+        if (replica.ok)
+            table << replica.seconds << '\t' << replica.Hmean << '\t' << replica.Tmean << '\t' << replica.Pmean << '\t'
+                  << replica.IdealGas << '\t' << replica.u << '\n';
+        else
+            table << "FAILED\n";
+
+        busy += replica.seconds;
+        ok = ok && replica.ok;
+    }
+
+    summary << table.str();
+    std::cout << '\n'
+              << table.str() << '\n';
+    std::cout << "`runBatch()` :> Wall time " << std::fixed << std::setprecision(3) << makespan << " s, workers busy "
+              << std::setprecision(1)
+              << 100. * busy / (workers * makespan) << "% of the time.\n";
+    std::cout << "`runBatch()` :> Summary saved to ../Out/" << summaryFilename << "\n\n"
+              << std::defaultfloat;
+
+    return ok;
+}
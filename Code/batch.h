@@ -0,0 +1,23 @@
+#ifndef BATCH_H
+#define BATCH_H
+typedef unsigned int uint;
+
+/// Runs independent replicas listed in the batch file (in `Config` folder) concurrently,
+/// one Argon instance per replica. Every line of the file describes one replica:
+///
+///     name  parameters.txt  seed  [name value ...]
+///
+/// where the optional `name value` pairs override parameters from the file (e.g.
+/// `T0 100 L 8`). Lines starting with '#' are comments. Replicas are started from the
+/// most expensive one (estimated from steps and pairs per step) and idle workers take
+/// the next one (longest processing time first), so all workers stay busy even if
+/// replicas differ a lot in size. Every replica writes `name.log`, `name_r0.txt`,
+/// `name_p0.txt`, `name_htp0.txt`, `name_rt.txt`, `name_htp.txt` and `name_hist.txt`
+/// to `Out` folder. The summary table of mean values is printed and saved to `Out`.
+/// @param char* batch file in `Config` folder,
+/// @param char* summary file in `Out` folder,
+/// @param uint number of workers (0 means all hardware threads).
+/// @return True if all replicas finished.
+bool runBatch(const char *batchFilename, const char *summaryFilename, const uint &workers);
+
+#endif // BATCH_H
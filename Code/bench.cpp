@@ -0,0 +1,1160 @@
+#include "bench.h"
+#include "vectors.h"
+#include "kernels.h"
+#include "neighbors.h"
+#include "forces.h"
+#include "argon.h"
+#include "stats.h"
+#include "table.h"
+#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    // Parameters of the system used by the benchmark (default Argon values)
+    constexpr double m = 40.;
+    constexpr double e = 1.;
+    constexpr double R = 0.38;
+    constexpr double a = 0.38;
+    constexpr double tau = 1e-3;
+
+    // Integrator benchmark
+    constexpr double T0 = 1e3;              ///< Initial temperature (the crystal melts but stays compact)
+    constexpr uint Seed = 12345;            ///< Seed of the initial momenta
+    constexpr uint WarmupSteps = 10;        ///< Steps before the measurement (e.g. the first list build)
+    constexpr double PairsPerConfig = 2e8;  ///< Measured steps evaluate about that many pairs
+    constexpr double DriftTolerance = 1e-4; ///< Maximum relative deviation of H accepted by the check
+
+    // Multiple time step benchmark
+    constexpr double RespaTime = 10.; ///< Simulated time of every configuration (ps)
+
+    // Mixed precision validation
+    constexpr double PrecisionTime = 10.; ///< Simulated time of every configuration (ps)
+
+    // Tabulated potential
+    constexpr double TableTime = 10.; ///< Simulated time of the energy conservation check (ps)
+
+    // Thermostats
+    constexpr double ThermostatTime = 20.;       ///< Simulated time of every thermostat (ps)
+    constexpr uint ThermostatWindow = 100;       ///< Steps of the running mean of T
+    constexpr double ThermostatTolerance = 0.05; ///< Relative deviation of the settled running mean of T
+
+    // Sorting of atoms along space-filling curves
+    constexpr double SortT0 = 2e3;       ///< Initial temperature of the periodic box (hot fluid, atoms diffuse fast)
+    constexpr double SortTau = 1e-3;     ///< Integration step of the hot fluid
+    constexpr uint SortMeltSteps = 4000; ///< Steps before the measurement, the order of the crystal decays
+    constexpr uint SortSteps = 500;      ///< Measured steps
+
+    // Weak scaling of the domain decomposition
+    constexpr uint MpiEdge = 18;          ///< Atoms along every edge of the crystal per rank (even and a multiple of 3)
+    constexpr uint MpiWarmupSteps = 100;  ///< Steps before the measurement (first builds, atoms start to migrate)
+    constexpr uint MpiSteps = 500;        ///< Measured steps
+
+    /// Single row of the integrator benchmark (sent from the child process by the pipe)
+    struct SuiteRow
+    {
+        uint n;
+        uint N;
+        bool verlet;
+        uint threads;
+        uint steps;
+        double nsPerStep;
+        double pairsPerStep;
+        double pairsPerSecond;
+        double peakMB;
+        double H0;
+        double drift;
+        bool ok; ///< False if the child process failed
+    };
+
+    /// Cache misses of the calling thread counted by the hardware (`perf_event_open`), which
+    /// may be unavailable, e.g. in virtual machines or with perf_event_paranoid > 2
+    class CacheCounters
+    {
+    private:
+        int l1;  ///< Descriptor of L1 data cache read misses (-1 if unavailable)
+        int llc; ///< Descriptor of last level cache misses (-1 if unavailable)
+
+        static int open(const uint32_t &type, const uint64_t &config) noexcept
+        {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        static uint64_t value(const int &fd) noexcept
+        {
+            uint64_t count = 0;
+            return (read(fd, &count, sizeof(count)) == sizeof(count)) ? count : 0;
+        }
+
+    public:
+        CacheCounters() noexcept
+            : l1(open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                                              PERF_COUNT_HW_CACHE_RESULT_MISS << 16)),
+              llc(open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES))
+        {
+        }
+
+        ~CacheCounters() noexcept
+        {
+            if (l1 >= 0)
+                close(l1);
+            if (llc >= 0)
+                close(llc);
+        }
+
+        CacheCounters(const CacheCounters &) = delete;
+        CacheCounters &operator=(const CacheCounters &) = delete;
+
+        bool available() const noexcept { return l1 >= 0 && llc >= 0; }
+
+        void start() noexcept
+        {
+            for (const int fd : {l1, llc})
+            {
+                if (fd >= 0)
+                {
+                    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+        }
+
+        /// Stops counting and returns misses since `start()`
+        void stop(uint64_t &l1Misses, uint64_t &llcMisses) noexcept
+        {
+            for (const int fd : {l1, llc})
+                if (fd >= 0)
+                    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+            l1Misses = (l1 >= 0) ? value(l1) : 0;
+            llcMisses = (llc >= 0) ? value(llc) : 0;
+        }
+    };
+
+    /**************************************************************************************
+     * Single step of the integrator with the old layout: N separately allocated rows.
+     *************************************************************************************/
+    double stepAoS(double **r, double **p, double **F, const uint &N)
+    {
+        for (uint i = 0; i < N; i++)
+        {
+            for (uint j = 0; j < 3; j++)
+            {
+                p[i][j] = p[i][j] + 0.5 * F[i][j] * tau;
+                r[i][j] = r[i][j] + p[i][j] * tau / m;
+                F[i][j] = 0.;
+            }
+        }
+
+        double V = 0.;
+
+        for (uint i = 0; i < N; i++)
+        {
+            for (uint j = 0; j < i; j++)
+            {
+                double r_ij = std::sqrt((r[i][0] - r[j][0]) * (r[i][0] - r[j][0]) + (r[i][1] - r[j][1]) * (r[i][1] - r[j][1]) +
+                                        (r[i][2] - r[j][2]) * (r[i][2] - r[j][2]));
+
+                double z = R / r_ij;
+                double y = z * z;
+                double x = y * y * y;
+                V += e * x * (x - 2.);
+
+                for (uint k = 0; k < 3; k++)
+                {
+                    double Fp = 12. * e * x * (x - 1.) * (r[i][k] - r[j][k]) / (r_ij * r_ij);
+                    F[i][k] += Fp;
+                    F[j][k] -= Fp;
+                }
+            }
+        }
+
+        for (uint i = 0; i < N; i++)
+            for (uint j = 0; j < 3; j++)
+                p[i][j] = p[i][j] + 0.5 * F[i][j] * tau;
+
+        return V;
+    }
+
+    /**************************************************************************************
+     * Single step of the integrator with the structure of arrays layout.
+     *************************************************************************************/
+    double stepSoA(Vectors &r, Vectors &p, Vectors &F, const uint &N)
+    {
+        for (uint i = 0; i < N; i++)
+        {
+            p.x[i] = p.x[i] + 0.5 * F.x[i] * tau;
+            p.y[i] = p.y[i] + 0.5 * F.y[i] * tau;
+            p.z[i] = p.z[i] + 0.5 * F.z[i] * tau;
+            r.x[i] = r.x[i] + p.x[i] * tau / m;
+            r.y[i] = r.y[i] + p.y[i] * tau / m;
+            r.z[i] = r.z[i] + p.z[i] * tau / m;
+        }
+
+        F.zero();
+        double V = 0.;
+
+        for (uint i = 0; i < N; i++)
+        {
+            const double xi = r.x[i];
+            const double yi = r.y[i];
+            const double zi = r.z[i];
+            double Fx = 0., Fy = 0., Fz = 0.;
+
+            for (uint j = 0; j < i; j++)
+            {
+                const double dx = xi - r.x[j];
+                const double dy = yi - r.y[j];
+                const double dz = zi - r.z[j];
+                const double r_ij = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+                const double z = R / r_ij;
+                const double y = z * z;
+                const double x = y * y * y;
+                const double Fp = 12. * e * x * (x - 1.) / (r_ij * r_ij);
+                V += e * x * (x - 2.);
+
+                Fx += Fp * dx;
+                Fy += Fp * dy;
+                Fz += Fp * dz;
+                F.x[j] -= Fp * dx;
+                F.y[j] -= Fp * dy;
+                F.z[j] -= Fp * dz;
+            }
+
+            F.x[i] += Fx;
+            F.y[i] += Fy;
+            F.z[i] += Fz;
+        }
+
+        for (uint i = 0; i < N; i++)
+        {
+            p.x[i] = p.x[i] + 0.5 * F.x[i] * tau;
+            p.y[i] = p.y[i] + 0.5 * F.y[i] * tau;
+            p.z[i] = p.z[i] + 0.5 * F.z[i] * tau;
+        }
+
+        return V;
+    }
+
+    /**************************************************************************************
+     * Simulation of the single configuration of the integrator benchmark. Runs in the
+     * child process, messages of Argon go to /dev/null.
+     *************************************************************************************/
+    SuiteRow runSuiteConfig(const uint &n, const bool &verlet, const uint &threads)
+    {
+        SuiteRow row{};
+        row.n = n;
+        row.N = n * n * n;
+        row.verlet = verlet;
+        row.threads = threads;
+
+        // Estimated pairs per step: all pairs or about 46 neighbours of every atom in the crystal
+        const double pairs = verlet ? 46. * row.N : 0.5 * row.N * (row.N - 1.);
+        row.steps = std::min(5000., std::max(5., PairsPerConfig / pairs));
+
+        std::ostringstream config;
+        config << "n " << n << " m " << m << " e " << e << " R " << R << " k 8.31e-3 f 1e4 L " << 2.5 * n * a << " a " << a
+               << " T0 " << T0 << " tau " << tau << " So 0 Sd " << WarmupSteps + row.steps << " Sout 1 Sxyz 1"
+               << " engine " << (verlet ? "verlet" : "exact") << " threads " << threads;
+
+        std::istringstream input(config.str());
+        Argon argon;
+        argon.setParameters(input, "benchmark");
+        argon.setSeed(Seed + n);
+        argon.initialState(nullptr, nullptr, nullptr);
+        argon.advance(WarmupSteps);
+
+        auto t0 = std::chrono::steady_clock::now();
+        const AdvanceReport report = argon.advance(row.steps);
+        auto t1 = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(t1 - t0).count();
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        row.nsPerStep = 1e9 * seconds / row.steps;
+        row.pairsPerStep = static_cast<double>(report.pairs) / row.steps;
+        row.pairsPerSecond = report.pairs / seconds;
+        row.peakMB = usage.ru_maxrss / 1024.;
+        row.H0 = report.H0;
+        row.drift = report.drift;
+        row.ok = true;
+
+        return row;
+    }
+
+    /**************************************************************************************
+     * Runs the configuration in the forked process and receives its row by the pipe.
+     *************************************************************************************/
+    SuiteRow forkSuiteConfig(const uint &n, const bool &verlet, const uint &threads)
+    {
+        SuiteRow row{};
+        row.n = n;
+        row.N = n * n * n;
+        row.verlet = verlet;
+        row.threads = threads;
+
+        int fd[2];
+
+        if (pipe(fd) != 0)
+            return row;
+
+        std::cout.flush();
+        const pid_t pid = fork();
+
+        if (pid == 0)
+        {
+            close(fd[0]);
+            std::freopen("/dev/null", "w", stdout);
+            std::freopen("/dev/null", "w", stderr);
+
+            const SuiteRow result = runSuiteConfig(n, verlet, threads);
+            const bool sent = write(fd[1], &result, sizeof(result)) == sizeof(result);
+            _exit(sent ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+
+        close(fd[1]);
+
+        if (pid > 0)
+        {
+            SuiteRow result{};
+
+            if (read(fd[0], &result, sizeof(result)) == sizeof(result))
+                row = result;
+
+            waitpid(pid, nullptr, 0);
+        }
+
+        close(fd[0]);
+
+        return row;
+    }
+} // namespace
+
+void benchLayout()
+{
+    std::cout << "`benchLayout()` :> Array of pointers vs structure of arrays (exact engine).\n";
+    std::cout << std::setw(4) << "n" << std::setw(8) << "N" << std::setw(8) << "steps" << std::setw(16) << "AoS (ms/step)"
+              << std::setw(16) << "SoA (ms/step)" << std::setw(10) << "speedup" << '\n';
+
+    for (const uint n : {6u, 12u, 20u})
+    {
+        const uint N = n * n * n;
+        const double pairs = 0.5 * N * (N - 1.);
+        // About 10^8 pair evaluations per layout
+        const uint steps = std::max(1., 1e8 / pairs);
+
+        double **rA = new double *[N];
+        double **pA = new double *[N];
+        double **FA = new double *[N];
+        Vectors rS(N), pS(N), FS(N);
+
+        // Simple cubic crystal with small random momenta, the same for both layouts
+        std::mt19937 mt(12345);
+        std::normal_distribution<double> gauss(0., 1.);
+
+        for (uint i = 0; i < N; i++)
+        {
+            rA[i] = new double[3]{(i % n) * a, (i / n % n) * a, (i / n / n) * a};
+            pA[i] = new double[3]{gauss(mt), gauss(mt), gauss(mt)};
+            FA[i] = new double[3]();
+
+            for (uint j = 0; j < 3; j++)
+            {
+                rS[j][i] = rA[i][j];
+                pS[j][i] = pA[i][j];
+            }
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        double VA = 0.;
+        for (uint s = 0; s < steps; s++)
+            VA = stepAoS(rA, pA, FA, N);
+        auto t1 = std::chrono::steady_clock::now();
+        double VS = 0.;
+        for (uint s = 0; s < steps; s++)
+            VS = stepSoA(rS, pS, FS, N);
+        auto t2 = std::chrono::steady_clock::now();
+
+        const double msA = std::chrono::duration<double, std::milli>(t1 - t0).count() / steps;
+        const double msS = std::chrono::duration<double, std::milli>(t2 - t1).count() / steps;
+
+        std::cout << std::fixed << std::setprecision(4);
+        std::cout << std::setw(4) << n << std::setw(8) << N << std::setw(8) << steps << std::setw(16) << msA
+                  << std::setw(16) << msS << std::setw(10) << std::setprecision(2) << msA / msS;
+        std::cout << "   (relative V difference: " << std::scientific << std::setprecision(1)
+                  << std::abs(VA - VS) / std::abs(VA) << std::defaultfloat << ")\n";
+
+        for (uint i = 0; i < N; i++)
+        {
+            delete[] rA[i];
+            delete[] pA[i];
+            delete[] FA[i];
+        }
+
+        delete[] rA;
+        delete[] pA;
+        delete[] FA;
+    }
+
+    std::cout << '\n';
+}
+
+void benchKernels()
+{
+    std::cout << "`benchKernels()` :> Pair kernels compared with the scalar kernel (tolerance " << PairKernelTolerance
+              << ", mixed precision " << MixedKernelTolerance << ").\n";
+    std::cout << std::setw(4) << "n" << std::setw(8) << "engine" << std::setw(14) << "isa" << std::setw(14) << "ms/step"
+              << std::setw(10) << "speedup" << std::setw(12) << "dV/V" << std::setw(12) << "dF/Fmax" << '\n';
+
+    for (const uint n : {6u, 12u, 20u})
+    {
+        const uint N = n * n * n;
+        Vectors r(N), F(N), F0(N);
+        VectorsF rF(N);
+
+        // Slightly perturbed simple cubic crystal
+        std::mt19937 mt(12345);
+        std::uniform_real_distribution<double> shift(-0.05, 0.05);
+
+        for (uint i = 0; i < N; i++)
+        {
+            r.x[i] = (i % n) * a + shift(mt);
+            r.y[i] = (i / n % n) * a + shift(mt);
+            r.z[i] = (i / n / n) * a + shift(mt);
+        }
+
+        NeighborList neighbors;
+        neighbors.setup(N, 0.85, 0., 0.5 * n * a + 1.);
+        neighbors.build(r);
+
+        const double yc = R * R / (0.85 * 0.85);
+        const double xc = yc * yc * yc;
+        const PairParams exact{e, R * R, INFINITY, 0.};
+        const PairParams cut{e, R * R, 0.85 * 0.85, e * xc * (xc - 2.)};
+
+        for (const bool list : {false, true})
+        {
+            const uint steps = list ? 200 : std::max(1., 2e7 / (0.5 * N * N));
+            double V0 = 0., ms0 = 0.;
+
+            for (const Isa isa : {Isa::Scalar, Isa::AVX2, Isa::AVX512})
+            {
+                if (!isaSupported(isa))
+                    continue;
+
+                const PairKernels kernels = selectKernels(isa);
+
+                for (const Precision precision : {Precision::Double, Precision::Mixed})
+                {
+                    const bool mixed = (precision == Precision::Mixed);
+                    double V = 0.;
+
+                    auto t0 = std::chrono::steady_clock::now();
+                    for (uint s = 0; s < steps; s++)
+                    {
+                        F.zero();
+                        V = 0.;
+
+                        // Rounding of positions is a part of every pass of the mixed kernels
+                        if (mixed)
+                            rF.assign(r);
+
+                        for (uint i = 0; i < N; i++)
+                        {
+                            const uint *js = neighbors.neighbors() + neighbors.begin(i);
+                            const uint count = neighbors.end(i) - neighbors.begin(i);
+
+                            if (list)
+                                V += mixed ? kernels.listMixed(rF, F, i, js, count, cut) : kernels.list(r, F, i, js, count, cut);
+                            else
+                                V += mixed ? kernels.rowMixed(rF, F, i, i, exact) : kernels.row(r, F, i, i, exact);
+                        }
+                    }
+                    auto t1 = std::chrono::steady_clock::now();
+                    const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / steps;
+
+                    if (isa == Isa::Scalar && !mixed)
+                    {
+                        V0 = V;
+                        ms0 = ms;
+                        for (uint j = 0; j < 3; j++)
+                            std::copy(F[j], F[j] + N, F0[j]);
+                    }
+
+                    double dF = 0., Fmax = 0.;
+                    for (uint j = 0; j < 3; j++)
+                    {
+                        for (uint i = 0; i < N; i++)
+                        {
+                            dF = std::max(dF, std::abs(F[j][i] - F0[j][i]));
+                            Fmax = std::max(Fmax, std::abs(F0[j][i]));
+                        }
+                    }
+
+                    const double dV = std::abs(V - V0) / std::abs(V0);
+                    const double tolerance = mixed ? MixedKernelTolerance : PairKernelTolerance;
+                    dF /= Fmax;
+
+                    std::cout << std::fixed << std::setprecision(4);
+                    std::cout << std::setw(4) << n << std::setw(8) << (list ? "verlet" : "exact") << std::setw(14)
+                              << (isaName(isa) + std::string(mixed ? "-mixed" : "")) << std::setw(14) << ms << std::setw(10)
+                              << std::setprecision(2) << ms0 / ms;
+                    std::cout << std::scientific << std::setprecision(1) << std::setw(12) << dV << std::setw(12) << dF
+                              << ((dV <= tolerance && dF <= tolerance) ? "  OK" : "  FAILED") << std::defaultfloat << '\n';
+                }
+            }
+        }
+    }
+
+    std::cout << '\n';
+}
+
+void benchThreads()
+{
+    std::cout << "`benchThreads()` :> Strong scaling of the pair forces (hardware threads: "
+              << std::thread::hardware_concurrency() << ").\n";
+    std::cout << std::setw(4) << "n" << std::setw(8) << "engine" << std::setw(9) << "threads" << std::setw(14) << "ms/pass"
+              << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << '\n';
+
+    for (const uint n : {12u, 20u})
+    {
+        const uint N = n * n * n;
+        Vectors r(N), F(N);
+
+        std::mt19937 mt(12345);
+        std::uniform_real_distribution<double> shift(-0.05, 0.05);
+
+        for (uint i = 0; i < N; i++)
+        {
+            r.x[i] = (i % n) * a + shift(mt);
+            r.y[i] = (i / n % n) * a + shift(mt);
+            r.z[i] = (i / n / n) * a + shift(mt);
+        }
+
+        NeighborList neighbors;
+        neighbors.setup(N, 0.85, 0.1, 0.5 * n * a + 1.);
+        neighbors.build(r);
+
+        for (const bool list : {false, true})
+        {
+            const uint passes = list ? 200 : std::max(2., 4e7 / (0.5 * N * N));
+            double ms1 = 0.;
+
+            for (const uint threads : {1u, 2u, 4u, 8u, 16u, 32u})
+            {
+                PairForces forces;
+                forces.setup(N, e, R, 0.85, Isa::Auto, threads, Precision::Double);
+
+                auto t0 = std::chrono::steady_clock::now();
+                for (uint s = 0; s < passes; s++)
+                {
+                    F.zero();
+                    if (list)
+                        forces.list(r, F, neighbors);
+                    else
+                        forces.exact(r, F);
+                }
+                auto t1 = std::chrono::steady_clock::now();
+                const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / passes;
+
+                if (threads == 1)
+                    ms1 = ms;
+
+                std::cout << std::fixed << std::setprecision(4);
+                std::cout << std::setw(4) << n << std::setw(8) << (list ? "verlet" : "exact") << std::setw(9)
+                          << forces.getThreads() << std::setw(14) << ms << std::setw(10) << std::setprecision(2) << ms1 / ms
+                          << std::setw(12) << ms1 / ms / forces.getThreads() << std::defaultfloat << '\n';
+            }
+        }
+    }
+
+    std::cout << '\n';
+}
+
+void benchRespa()
+{
+    std::cout << "`benchRespa()` :> Velocity Verlet and r-RESPA over " << RespaTime << " ps (inner step " << tau << " ps).\n";
+    std::cout << std::setw(4) << "n" << std::setw(8) << "engine" << std::setw(8) << "f" << std::setw(10) << "tau"
+              << std::setw(7) << "respa" << std::setw(12) << "ms/ps" << std::setw(10) << "speedup" << std::setw(14) << "drift"
+              << '\n';
+
+    for (const bool verlet : {false, true})
+    {
+        const uint n = verlet ? 12 : 6;
+
+        for (const double f : {1e4, 1e6})
+        {
+            double ms0 = 0.;
+
+            for (const uint k : {1u, 2u, 4u, 8u})
+            {
+                // Reference velocity Verlet with the inner step, then both integrators with the longer step
+                for (const uint respa : {1u, k})
+                {
+                    if (k == 1 && respa == 1 && ms0 > 0.)
+                        continue;
+
+                    const double step = k * tau;
+                    const uint steps = RespaTime / step;
+
+                    std::ostringstream config;
+                    config << "n " << n << " m " << m << " e " << e << " R " << R << " k 8.31e-3 f " << f << " L "
+                           << 1.22 * (n - 1) * a << " a " << a << " T0 " << T0 << " tau " << step << " So 0 Sd " << steps
+                           << " Sout 1 Sxyz 1 engine " << (verlet ? "verlet" : "exact") << " respa " << respa;
+
+                    std::istringstream input(config.str());
+                    std::ofstream devNull("/dev/null");
+                    Argon argon(devNull, devNull);
+                    argon.setParameters(input, "benchmark");
+                    argon.setSeed(Seed + n);
+                    argon.initialState(nullptr, nullptr, nullptr);
+
+                    auto t0 = std::chrono::steady_clock::now();
+                    const AdvanceReport report = argon.advance(steps);
+                    auto t1 = std::chrono::steady_clock::now();
+                    const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / RespaTime;
+
+                    if (k == 1)
+                        ms0 = ms;
+
+                    std::cout << std::setw(4) << n << std::setw(8) << (verlet ? "verlet" : "exact") << std::setw(8)
+                              << std::setprecision(0) << std::scientific << f << std::setw(10) << std::defaultfloat << step
+                              << std::setw(7) << respa << std::fixed << std::setprecision(2) << std::setw(12) << ms
+                              << std::setw(10) << ms0 / ms << std::scientific << std::setprecision(3) << std::setw(14)
+                              << report.drift << std::defaultfloat << '\n';
+                }
+            }
+        }
+    }
+
+    std::cout << '\n';
+}
+
+void benchPrecision()
+{
+    std::cout << "`benchPrecision()` :> Double and mixed precision pair kernels over " << PrecisionTime << " ps (tau " << tau
+              << " ps).\n";
+    std::cout << std::setw(4) << "n" << std::setw(8) << "engine" << std::setw(11) << "precision" << std::setw(12) << "ms/step"
+              << std::setw(10) << "speedup" << std::setw(12) << "drift" << std::setw(12) << "T (K)" << std::setw(12)
+              << "pPro (%)" << std::setw(12) << "pMean (%)" << std::setw(12) << "pMeanSq (%)" << std::setw(12) << "Ek (%)"
+              << '\n';
+
+    for (const bool verlet : {false, true})
+    {
+        const uint n = verlet ? 12 : 6;
+        const uint steps = PrecisionTime / tau;
+        double ms0 = 0.;
+
+        for (const Precision precision : {Precision::Double, Precision::Mixed})
+        {
+            const bool mixed = (precision == Precision::Mixed);
+
+            std::ostringstream config;
+            config << "n " << n << " m " << m << " e " << e << " R " << R << " k 8.31e-3 f 1e4 L " << 1.22 * (n - 1) * a
+                   << " a " << a << " T0 " << T0 << " tau " << tau << " So 0 Sd " << steps << " Sout 1 Sxyz 1 engine "
+                   << (verlet ? "verlet" : "exact") << " precision " << (mixed ? "mixed" : "double");
+
+            std::istringstream input(config.str());
+            std::ofstream devNull("/dev/null");
+            Argon argon(devNull, devNull);
+            argon.setParameters(input, "benchmark");
+            argon.setSeed(Seed + n);
+            argon.initialState(nullptr, nullptr, nullptr);
+
+            auto t0 = std::chrono::steady_clock::now();
+            const AdvanceReport report = argon.advance(steps);
+            auto t1 = std::chrono::steady_clock::now();
+            const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / steps;
+
+            if (!mixed)
+                ms0 = ms;
+
+            // Maxwell-Boltzmann errors of the final momenta
+            uint N;
+            double *pAbs, T, k, mass;
+            std::tie(pAbs, N, T, k, mass) = argon.getMomentumAbs();
+
+            Stats stats;
+            stats.setInputFromArgon(pAbs, N, T, k, mass);
+            stats.evaluate();
+            delete[] pAbs;
+
+            double pPro, pMean, pMeanSq, Ek;
+            std::tie(pPro, pMean, pMeanSq, Ek) = stats.getErrors();
+
+            std::cout << std::setw(4) << n << std::setw(8) << (verlet ? "verlet" : "exact") << std::setw(11)
+                      << (mixed ? "mixed" : "double") << std::fixed << std::setprecision(4) << std::setw(12) << ms
+                      << std::setprecision(2) << std::setw(10) << ms0 / ms << std::scientific << std::setprecision(3)
+                      << std::setw(12) << report.drift << std::fixed << std::setprecision(2) << std::setw(12) << T
+                      << std::setw(12) << pPro << std::setw(12) << pMean << std::setw(12) << pMeanSq << std::setw(12) << Ek
+                      << std::defaultfloat << '\n';
+        }
+    }
+
+    std::cout << '\n';
+}
+
+void benchTable()
+{
+    std::cout << "`benchTable()` :> Tabulated potential compared with the analytic scalar kernel (Verlet list).\n";
+    std::cout << std::setw(4) << "n" << std::setw(8) << "size" << std::setw(8) << "isa" << std::setw(14) << "ms/step"
+              << std::setw(10) << "speedup" << std::setw(12) << "table V" << std::setw(12) << "table F" << std::setw(12)
+              << "dV/V" << std::setw(12) << "dF/Fmax" << '\n';
+
+    const double yc = R * R / (0.85 * 0.85);
+    const double xc = yc * yc * yc;
+    const PairParams cut{e, R * R, 0.85 * 0.85, e * xc * (xc - 2.)};
+    const PairPotential potential = lennardJones(e, R, cut.Vc);
+
+    for (const uint n : {12u, 20u})
+    {
+        const uint N = n * n * n;
+        Vectors r(N), F(N), F0(N);
+
+        std::mt19937 mt(12345);
+        std::uniform_real_distribution<double> shift(-0.05, 0.05);
+
+        for (uint i = 0; i < N; i++)
+        {
+            r.x[i] = (i % n) * a + shift(mt);
+            r.y[i] = (i / n % n) * a + shift(mt);
+            r.z[i] = (i / n / n) * a + shift(mt);
+        }
+
+        NeighborList neighbors;
+        neighbors.setup(N, 0.85, 0., 0.5 * n * a + 1.);
+        neighbors.build(r);
+
+        constexpr uint steps = 200;
+
+        // Time of the force pass with the analytic or tabulated kernel, V is the potential energy
+        auto pass = [&](const PairKernels &kernels, const PairTable *table, double &V)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            for (uint s = 0; s < steps; s++)
+            {
+                F.zero();
+                V = 0.;
+
+                for (uint i = 0; i < N; i++)
+                {
+                    const uint *js = neighbors.neighbors() + neighbors.begin(i);
+                    const uint count = neighbors.end(i) - neighbors.begin(i);
+
+                    V += table ? kernels.listTable(r, F, i, js, count, *table) : kernels.list(r, F, i, js, count, cut);
+                }
+            }
+            auto t1 = std::chrono::steady_clock::now();
+
+            return std::chrono::duration<double, std::milli>(t1 - t0).count() / steps;
+        };
+
+        double V0 = 0.;
+        pass(selectKernels(Isa::Scalar), nullptr, V0);
+        for (uint j = 0; j < 3; j++)
+            std::copy(F[j], F[j] + N, F0[j]);
+
+        for (const Isa isa : {Isa::Scalar, Isa::AVX2, Isa::AVX512})
+        {
+            if (!isaSupported(isa))
+                continue;
+
+            const PairKernels kernels = selectKernels(isa);
+            double V = 0.;
+            const double ms0 = pass(kernels, nullptr, V);
+
+            std::cout << std::setw(4) << n << std::setw(8) << "-" << std::setw(8) << isaName(isa) << std::fixed
+                      << std::setprecision(4) << std::setw(14) << ms0 << std::setw(10) << std::setprecision(2) << 1.
+                      << std::defaultfloat << '\n';
+
+            for (const uint size : {256u, 1024u, 4096u, 16384u})
+            {
+                PairTable table;
+                table.build(potential, 0.25 * cut.R2, cut.rc2, size);
+                table.setCore(cut);
+                const TableError error = table.error(potential, e, R);
+
+                const double ms = pass(kernels, &table, V);
+
+                double dF = 0., Fmax = 0.;
+                for (uint j = 0; j < 3; j++)
+                {
+                    for (uint i = 0; i < N; i++)
+                    {
+                        dF = std::max(dF, std::abs(F[j][i] - F0[j][i]));
+                        Fmax = std::max(Fmax, std::abs(F0[j][i]));
+                    }
+                }
+
+                std::cout << std::setw(4) << n << std::setw(8) << size << std::setw(8) << isaName(isa) << std::fixed
+                          << std::setprecision(4) << std::setw(14) << ms << std::setw(10) << std::setprecision(2) << ms0 / ms
+                          << std::scientific << std::setprecision(1) << std::setw(12) << error.V << std::setw(12) << error.F
+                          << std::setw(12) << std::abs(V - V0) / std::abs(V0) << std::setw(12) << dF / Fmax
+                          << std::defaultfloat << '\n';
+            }
+        }
+    }
+
+    // Energy conservation of the whole simulation with the same seed
+    std::cout << "\n`benchTable()` :> Energy drift max |H - H0| / |H0| over " << TableTime << " ps (n = 12, Verlet).\n";
+    std::cout << std::setw(10) << "potential" << std::setw(8) << "size" << std::setw(12) << "ms/step" << std::setw(14) << "drift"
+              << std::setw(14) << "H (kJ/mol)" << '\n';
+
+    const uint steps = TableTime / tau;
+
+    for (const uint size : {0u, 256u, 1024u, 4096u, 16384u})
+    {
+        std::ostringstream config;
+        config << "n 12 m " << m << " e " << e << " R " << R << " k 8.31e-3 f 1e4 L " << 1.22 * 11 * a << " a " << a
+               << " T0 " << T0 << " tau " << tau << " So 0 Sd " << steps << " Sout 1 Sxyz 1 engine verlet potential "
+               << (size == 0 ? "analytic" : "table tableSize " + std::to_string(size));
+
+        std::istringstream input(config.str());
+        std::ofstream devNull("/dev/null");
+        Argon argon(devNull, devNull);
+        argon.setParameters(input, "benchmark");
+        argon.setSeed(Seed + 12);
+        argon.initialState(nullptr, nullptr, nullptr);
+
+        auto t0 = std::chrono::steady_clock::now();
+        const AdvanceReport report = argon.advance(steps);
+        auto t1 = std::chrono::steady_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / steps;
+
+        std::cout << std::setw(10) << (size == 0 ? "analytic" : "table") << std::setw(8);
+
+        if (size == 0)
+            std::cout << "-";
+        else
+            std::cout << size;
+
+        std::cout << std::fixed << std::setprecision(4) << std::setw(12) << ms << std::scientific << std::setprecision(3)
+                  << std::setw(14) << report.drift << std::fixed << std::setprecision(5) << std::setw(14) << report.H
+                  << std::defaultfloat << '\n';
+    }
+
+    std::cout << '\n';
+}
+
+void benchThermostat()
+{
+    const uint steps = ThermostatTime / tau;
+    const uint windows = steps / ThermostatWindow;
+
+    std::cout << "`benchThermostat()` :> Thermalisation of n = 6 (exact) to T = " << T0 << " K over " << ThermostatTime
+              << " ps, reached when the mean T of " << ThermostatWindow << " steps is within "
+              << 100. * ThermostatTolerance << "% of the target (of the second half for none).\n";
+    std::cout << std::setw(12) << "thermostat" << std::setw(10) << "tauT" << std::setw(12) << "reached" << std::setw(12)
+              << "T (K)" << std::setw(12) << "sigma T" << std::setw(12) << "ms/step" << '\n';
+
+    for (const char *name : {"none", "rescale", "berendsen", "nosehoover", "langevin"})
+    {
+        for (const double tauT : {0.05, 0.5})
+        {
+            if (std::string(name) == "none" && tauT > 0.05)
+                continue;
+
+            std::ostringstream config;
+            config << "n 6 m " << m << " e " << e << " R " << R << " k 8.31e-3 f 1e4 L " << 1.22 * 5 * a << " a " << a
+                   << " T0 " << T0 << " tau " << tau << " So 0 Sd " << steps << " Sout 1 Sxyz 1 thermostatEq " << name
+                   << " Ttarget " << T0 << " tauT " << tauT;
+
+            std::istringstream input(config.str());
+            std::ofstream devNull("/dev/null");
+            Argon argon(devNull, devNull);
+            argon.setParameters(input, "benchmark");
+            argon.setSeed(Seed + 6);
+            argon.initialState(nullptr, nullptr, nullptr);
+
+            // Running means of T in windows
+            std::vector<double> means(windows);
+            double ms = 0.;
+
+            for (uint w = 0; w < windows; w++)
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                means[w] = argon.advance(ThermostatWindow).T;
+                auto t1 = std::chrono::steady_clock::now();
+                ms += std::chrono::duration<double, std::milli>(t1 - t0).count() / steps;
+            }
+
+            double mean = 0., meanSq = 0.;
+
+            for (uint w = windows / 2; w < windows; w++)
+            {
+                mean += means[w] / (windows - windows / 2);
+                meanSq += means[w] * means[w] / (windows - windows / 2);
+            }
+
+            // The first window close to the target
+            const double target = (std::string(name) == "none") ? mean : T0;
+            uint reached = 0;
+
+            while (reached < windows && std::abs(means[reached] - target) > ThermostatTolerance * target)
+                reached++;
+
+            std::cout << std::setw(12) << name << std::setw(10);
+
+            if (std::string(name) == "none")
+                std::cout << "-";
+            else
+                std::cout << tauT;
+
+            std::cout << std::setw(12);
+
+            if (reached == windows)
+                std::cout << "-";
+            else
+                std::cout << (reached + 1) * ThermostatWindow;
+
+            std::cout << std::fixed << std::setprecision(1) << std::setw(12) << mean << std::setw(12)
+                      << std::sqrt(std::max(0., meanSq - mean * mean)) << std::setprecision(4) << std::setw(12) << ms
+                      << std::defaultfloat << '\n';
+        }
+    }
+
+    std::cout << '\n';
+}
+
+void benchSort()
+{
+    CacheCounters counters;
+
+    std::cout << "`benchSort()` :> Periodic box of the hot fluid (T0 = " << SortT0 << " K, 1 thread), " << SortMeltSteps
+              << " steps of melting and " << SortSteps << " measured steps with and without sorting of atoms.\n";
+    std::cout << "`benchSort()` :> span is the mean |i - j| of listed pairs of atoms, misses are counted per step"
+              << (counters.available() ? ".\n" : " (hardware counters are not available).\n");
+    std::cout << std::setw(4) << "n" << std::setw(8) << "N" << std::setw(10) << "curve" << std::setw(8) << "Ssort"
+              << std::setw(12) << "ms/step" << std::setw(10) << "speedup" << std::setw(12) << "span" << std::setw(14)
+              << "L1D misses" << std::setw(14) << "LLC misses" << std::setw(14) << "H (kJ/mol)" << '\n';
+
+    for (const uint n : {24u, 36u})
+    {
+        double ms0 = 0.;
+
+        for (const auto &[name, Ssort] : {std::pair<const char *, uint>{"none", 0}, {"morton", 100}, {"hilbert", 10},
+                                          {"hilbert", 100}, {"hilbert", 1000}})
+        {
+            std::ostringstream config;
+            config << "n " << n << " m " << m << " e " << e << " R " << R << " k 8.31e-3 f 1e4 L " << 1.22 * n * a
+                   << " a " << a << " T0 " << SortT0
+                   << " tau " << SortTau << " So 0 Sd " << SortMeltSteps + SortSteps
+                   << " Sout 1 Sxyz 1 engine verlet boundary periodic Ssort " << Ssort
+                   << (Ssort > 0 ? std::string(" curve ") + name : "");
+
+            std::istringstream input(config.str());
+            std::ofstream devNull("/dev/null");
+            Argon argon(devNull, devNull);
+            argon.setParameters(input, "benchmark");
+            argon.setSeed(Seed + n);
+            argon.initialState(nullptr, nullptr, nullptr);
+            argon.advance(SortMeltSteps);
+
+            uint64_t l1 = 0, llc = 0;
+            counters.start();
+            auto t0 = std::chrono::steady_clock::now();
+            const AdvanceReport report = argon.advance(SortSteps);
+            auto t1 = std::chrono::steady_clock::now();
+            counters.stop(l1, llc);
+
+            const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / SortSteps;
+            ms0 = (Ssort == 0) ? ms : ms0;
+
+            std::cout << std::setw(4) << n << std::setw(8) << n * n * n << std::setw(10) << name << std::setw(8) << Ssort
+                      << std::fixed << std::setprecision(4) << std::setw(12) << ms << std::setprecision(2) << std::setw(10)
+                      << ms0 / ms << std::setprecision(1) << std::setw(12) << report.span;
+
+            if (counters.available())
+                std::cout << std::setw(14) << l1 / SortSteps << std::setw(14) << llc / SortSteps;
+            else
+                std::cout << std::setw(14) << "n/a" << std::setw(14) << "n/a";
+
+            std::cout << std::setprecision(3) << std::setw(14) << report.H << std::defaultfloat << '\n';
+        }
+    }
+
+    std::cout << '\n';
+}
+
+#ifdef ARGON_MPI
+void benchMPI()
+{
+    int rank = 0, size = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    const uint cores = std::max(1u, std::thread::hardware_concurrency());
+    double ms1 = 0.;
+
+    if (rank == 0)
+    {
+        std::cout << "`benchMPI()` :> Periodic box with " << MpiEdge * MpiEdge * MpiEdge << " atoms per rank (T0 = " << T0
+                  << " K, 1 thread per rank), " << MpiSteps << " measured steps, " << size << " ranks, " << cores
+                  << " cores of this node (* ranks share cores).\n";
+        std::cout << std::setw(6) << "ranks" << std::setw(10) << "grid" << std::setw(10) << "N" << std::setw(12) << "ms/step"
+                  << std::setw(12) << "efficiency" << std::setw(14) << "pairs/s" << std::setw(12) << "drift" << '\n';
+    }
+
+    for (int P = 1; P <= size; P++)
+    {
+        MPI_Comm group;
+        MPI_Comm_split(MPI_COMM_WORLD, (rank < P) ? 0 : MPI_UNDEFINED, rank, &group);
+
+        if (group != MPI_COMM_NULL)
+        {
+            int dims[3];
+            Domain::grid(P, dims);
+
+            const uint nx = MpiEdge * dims[0], ny = MpiEdge * dims[1], nz = MpiEdge * dims[2];
+            std::ostringstream config;
+            config << "n " << MpiEdge << " m " << m << " e " << e << " R " << R << " k 8.31e-3 f 1e4 L " << 1.22 * MpiEdge * a
+                   << " a " << a << " T0 " << T0 << " tau " << tau << " So 0 Sd " << MpiWarmupSteps + MpiSteps
+                   << " Sout 1 Sxyz 1 nx " << nx << " ny " << ny << " nz " << nz << " engine verlet boundary periodic";
+
+            double elapsed = 0.;
+            AdvanceReport report{};
+
+            // Domains of the group are released before the group
+            {
+                std::istringstream input(config.str());
+                std::ofstream devNull("/dev/null");
+                Argon argon(devNull, devNull);
+                argon.setDistributed(group);
+                argon.setParameters(input, "benchmark");
+                argon.setSeed(Seed);
+                argon.initialState(nullptr, nullptr, nullptr);
+                argon.advance(MpiWarmupSteps);
+
+                MPI_Barrier(group);
+                const double t0 = MPI_Wtime();
+                report = argon.advance(MpiSteps);
+                elapsed = MPI_Wtime() - t0;
+            }
+
+            MPI_Allreduce(MPI_IN_PLACE, &elapsed, 1, MPI_DOUBLE, MPI_MAX, group);
+            MPI_Comm_free(&group);
+
+            const double ms = 1e3 * elapsed / MpiSteps;
+            ms1 = (P == 1) ? ms : ms1;
+
+            if (rank == 0)
+                std::cout << std::setw(5) << P << (static_cast<uint>(P) > cores ? "*" : " ") << std::setw(10)
+                          << std::to_string(dims[0]) + "x" + std::to_string(dims[1]) + "x" + std::to_string(dims[2])
+                          << std::setw(10) << nx * ny * nz << std::fixed << std::setprecision(3) << std::setw(12) << ms
+                          << std::setprecision(2) << std::setw(12) << ms1 / ms << std::scientific << std::setw(14)
+                          << report.pairs / elapsed << std::setw(12) << report.drift << std::defaultfloat << std::endl;
+        }
+
+        // Ranks outside the group (and the group after its run) wait without spinning
+        MPI_Request request;
+        int done = 0;
+        MPI_Ibarrier(MPI_COMM_WORLD, &request);
+
+        while (MPI_Test(&request, &done, MPI_STATUS_IGNORE) == MPI_SUCCESS && !done)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (rank == 0)
+        std::cout << '\n';
+}
+#endif
+
+void benchSuite(const char *filename)
+{
+    std::vector<uint> threadCounts = {1, 2, 4, std::max(1u, std::thread::hardware_concurrency())};
+    std::sort(threadCounts.begin(), threadCounts.end());
+    threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+    std::vector<SuiteRow> rows;
+    const std::string header = "n,N,engine,threads,isa,steps,ns_per_step,pairs_per_step,pairs_per_s,peak_mb,H0,drift,drift_ok";
+    const char *isa = isaName(detectIsa());
+
+    std::cout << header << '\n';
+
+    for (const uint n : {4u, 6u, 8u, 10u, 12u, 15u, 20u, 25u})
+    {
+        for (const bool verlet : {false, true})
+        {
+            for (const uint threads : threadCounts)
+            {
+                const SuiteRow row = forkSuiteConfig(n, verlet, threads);
+                rows.push_back(row);
+
+                std::cout << row.n << ',' << row.N << ',' << (row.verlet ? "verlet" : "exact") << ',' << row.threads << ','
+                          << isa << ',' << row.steps << ',' << std::fixed << std::setprecision(1) << row.nsPerStep << ','
+                          << row.pairsPerStep << ',' << std::scientific << std::setprecision(4) << row.pairsPerSecond << ','
+                          << std::fixed << std::setprecision(2) << row.peakMB << ',' << std::setprecision(5) << row.H0 << ','
+                          << std::scientific << std::setprecision(2) << row.drift << ','
+                          << (row.ok ? (row.drift <= DriftTolerance ? "OK" : "FAILED") : "ERROR") << std::defaultfloat
+                          << std::endl;
+            }
+        }
+    }
+
+    if (filename == nullptr)
+        return;
+
+    const std::string name(filename);
+    const bool json = name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0;
+    std::ofstream output("../Out/" + name, std::ios::out);
+
+    if (!output)
+    {
+        std::cerr << "`benchSuite()` :> Cannot open ../Out/" << name << '\n';
+        return;
+    }
+
+    if (json)
+        output << "{\n  \"isa\": \"" << isa << "\",\n  \"drift_tolerance\": " << DriftTolerance << ",\n  \"results\": [\n";
+    else
+        output << header << '\n';
+
+    for (std::size_t i = 0; i < rows.size(); i++)
+    {
+        const SuiteRow &row = rows[i];
+        const char *status = row.ok ? (row.drift <= DriftTolerance ? "OK" : "FAILED") : "ERROR";
+        output << std::setprecision(10);
+
+        if (json)
+            output << "    {\"n\": " << row.n << ", \"N\": " << row.N << ", \"engine\": \"" << (row.verlet ? "verlet" : "exact")
+                   << "\", \"threads\": " << row.threads << ", \"steps\": " << row.steps << ", \"ns_per_step\": "
+                   << row.nsPerStep << ", \"pairs_per_step\": " << row.pairsPerStep << ", \"pairs_per_s\": "
+                   << row.pairsPerSecond << ", \"peak_mb\": " << row.peakMB << ", \"H0\": " << row.H0 << ", \"drift\": "
+                   << row.drift << ", \"drift_ok\": \"" << status << "\"}" << (i + 1 < rows.size() ? "," : "") << '\n';
+        else
+            output << row.n << ',' << row.N << ',' << (row.verlet ? "verlet" : "exact") << ',' << row.threads << ',' << isa << ','
+                   << row.steps << ',' << row.nsPerStep << ',' << row.pairsPerStep << ',' << row.pairsPerSecond << ','
+                   << row.peakMB << ',' << row.H0 << ',' << row.drift << ',' << status << '\n';
+    }
+
+    if (json)
+        output << "  ]\n}\n";
+
+    std::cout << "`benchSuite()` :> Results saved to ../Out/" << name << '\n';
+}
@@ -0,0 +1,71 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/// Compares the old array-of-pointers layout (`double **`, N rows of 3 doubles) with
+/// the structure of arrays `Vectors` in the kick/drift and exact pair force loops
+/// for n = 6, 12 and 20 and prints the time per step.
+void benchLayout();
+
+/// Compares pair kernels of all instruction sets supported by the CPU with the scalar
+/// kernel (time and agreement within `PairKernelTolerance`) for the exact engine rows
+/// and for the Verlet neighbor list.
+void benchKernels();
+
+/// Strong scaling of the threaded pair forces: time of a single force pass for
+/// n = 12 and 20 (exact and Verlet engines) on 1, 2, 4, ..., 32 threads.
+void benchThreads();
+
+/// Compares velocity Verlet with r-RESPA at the same simulated time for n = 6 (exact)
+/// and n = 12 (Verlet) in the sphere close to the crystal and soft or stiff walls:
+/// velocity Verlet with the short step is the reference, then velocity Verlet and
+/// r-RESPA (inner step kept short) with 2, 4 and 8 times longer steps. Prints time per
+/// ps, speedup over the reference and the energy drift max |H - H0| / |H0|.
+void benchRespa();
+
+/// Validation of the mixed precision pair kernels: the same simulations (fixed seed,
+/// n = 6 exact and n = 12 Verlet) with double and mixed precision kernels. Prints time
+/// per step, speedup, the energy drift max |H - H0| / |H0|, the final temperature and
+/// errors of the Maxwell-Boltzmann statistics from `Stats::evaluate()` (no files are
+/// written).
+void benchPrecision();
+
+/// Tabulated potential against the analytic one for the Verlet list (n = 12 and 20):
+/// for tables of 256 ... 16384 intervals and every instruction set prints time per
+/// force pass, speedup over the analytic kernel of the same instruction set, errors of
+/// the table and differences of the potential energy and forces from the scalar
+/// analytic kernel. Then the energy drift of the same simulation (n = 12) with both.
+void benchTable();
+
+/// Thermalisation of n = 6 (exact) from the crystal at T0 with every thermostat and
+/// coupling times 0.05 and 0.5 ps: prints the number of steps until the running mean
+/// of T is within `ThermostatTolerance` of the target (for none, i.e. NVE, of its own
+/// mean in the second half of the run), the mean and fluctuation of the running mean
+/// in the second half and time per step.
+void benchThermostat();
+
+/// Sorting of atoms along space-filling curves in the periodic box of the hot fluid
+/// (n = 24 and 36, 1 thread): after the crystal melts, the same simulation without
+/// sorting, with the Morton curve and with the Hilbert curve every 10, 100 and 1000
+/// steps. Prints time per step, speedup over the unsorted run, the mean distance
+/// |i - j| in memory of listed pairs and L1 data and last level cache misses per step
+/// if hardware counters are available.
+void benchSort();
+
+#ifdef ARGON_MPI
+/// Weak scaling of the domain decomposition: groups of the first 1, 2, ... all ranks of
+/// the MPI run simulate the periodic box with `MpiEdge`^3 atoms per rank (the crystal
+/// grows along the grid of ranks). Prints time per step of the slowest rank, weak
+/// scaling efficiency t(1) / t(P), pair interactions per second and the energy drift.
+/// Ranks outside the group wait without spinning.
+void benchMPI();
+#endif
+
+/// Benchmark of the whole integrator (`Argon::advance()`, no output): simulations with
+/// fixed seeds for n = 4 ... 25, 1, 2, 4 and all hardware threads and both engines.
+/// Every configuration runs in a separate process, so its peak memory is not affected
+/// by the others. Prints CSV with ns/step, pair interactions per second, peak memory
+/// and the energy drift check; the same table is saved to `Out` folder as CSV or JSON
+/// (by the extension of the file name) if the name is given.
+void benchSuite(const char *filename);
+
+#endif // BENCH_H
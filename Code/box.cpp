@@ -0,0 +1,193 @@
+#include "box.h"
+#include <cmath>
+
+PeriodicBox::PeriodicBox() noexcept : N(0), M(0), edge{0., 0., 0.}, halo(0.)
+{
+}
+
+/**************************************************************************************
+ * Prepares the box centred at the origin, i.e. [-Lx/2, Lx/2) x [-Ly/2, Ly/2) x
+ * [-Lz/2, Lz/2), without ghosts.
+ * @param uint number of atoms,
+ * @param double[3] edges of the box,
+ * @param double thickness of the layer copied behind every face (rc + skin).
+ * @return Nothing to return.
+ *************************************************************************************/
+void PeriodicBox::setup(const uint &NAtoms, const double (&edges)[3], const double &layer)
+{
+    N = NAtoms;
+    M = N;
+    halo = layer;
+
+    for (uint k = 0; k < 3; k++)
+        edge[k] = edges[k];
+
+    images.resize(N);
+    positions.resize(N);
+    forces.resize(N);
+    owner.clear();
+    shift.clear();
+}
+
+/**************************************************************************************
+ * Wraps atoms into the box (new image indices) and copies those near the faces.
+ * Called together with the build of the neighbor list.
+ * @param Vectors positions of atoms (not wrapped).
+ * @return Nothing to return.
+ *************************************************************************************/
+void PeriodicBox::rebuild(const Vectors &r)
+{
+    for (uint k = 0; k < 3; k++)
+        for (uint i = 0; i < N; i++)
+            images[k][i] = std::floor(r[k][i] / edge[k] + 0.5);
+
+    collect(r, false);
+}
+
+/**************************************************************************************
+ * Restores ghosts of the last build from the checkpoint.
+ * @param Vectors wrapped positions of atoms at the moment of the last build,
+ * @param Vectors image indices of atoms.
+ * @return Nothing to return.
+ *************************************************************************************/
+void PeriodicBox::restore(const Vectors &reference, const Vectors &saved)
+{
+    for (uint k = 0; k < 3; k++)
+        for (uint i = 0; i < N; i++)
+            images[k][i] = saved[k][i];
+
+    collect(reference, true);
+}
+
+/**************************************************************************************
+ * Finds ghosts of the wrapped atoms and fills the extended array. An atom closer than
+ * the halo to the lower face is copied one edge up and vice versa, atoms near edges
+ * and corners of the box get also the combined shifts.
+ * @param Vectors positions of atoms,
+ * @param bool true if positions are already wrapped.
+ * @return Nothing to return.
+ *************************************************************************************/
+void PeriodicBox::collect(const Vectors &r, const bool &wrapped)
+{
+    owner.clear();
+    shift.clear();
+
+    for (uint i = 0; i < N; i++)
+    {
+        // Shifts -1, 0 and 1 allowed along every axis
+        bool allowed[3][3];
+
+        for (uint k = 0; k < 3; k++)
+        {
+            const double w = wrapped ? r[k][i] : r[k][i] - images[k][i] * edge[k];
+
+            allowed[k][0] = w >= 0.5 * edge[k] - halo;
+            allowed[k][1] = true;
+            allowed[k][2] = w < halo - 0.5 * edge[k];
+        }
+
+        for (uint code = 0; code < 27; code++)
+        {
+            if (code != 13 && allowed[0][code % 3] && allowed[1][code / 3 % 3] && allowed[2][code / 9])
+            {
+                owner.push_back(i);
+                shift.push_back(code);
+            }
+        }
+    }
+
+    M = N + owner.size();
+
+    // Some spare room, the number of ghosts fluctuates between builds
+    if (M > positions.size())
+    {
+        positions.resize(M + M / 8);
+        forces.resize(M + M / 8);
+    }
+
+    for (uint k = 0; k < 3; k++)
+        for (uint i = 0; i < N; i++)
+            positions[k][i] = wrapped ? r[k][i] : r[k][i] - images[k][i] * edge[k];
+
+    place();
+}
+
+/**************************************************************************************
+ * Moves ghosts to the current positions of their owners.
+ * @return Nothing to return.
+ *************************************************************************************/
+inline void PeriodicBox::place() noexcept
+{
+    for (uint g = 0; g < M - N; g++)
+    {
+        const uint i = owner[g];
+        const int code = shift[g];
+
+        positions.x[N + g] = positions.x[i] + (code % 3 - 1) * edge[0];
+        positions.y[N + g] = positions.y[i] + (code / 3 % 3 - 1) * edge[1];
+        positions.z[N + g] = positions.z[i] + (code / 9 - 1) * edge[2];
+    }
+}
+
+/**************************************************************************************
+ * Moves atoms and ghosts to the current positions with image indices of the last build
+ * (atoms may leave the box by half of the skin until the next build).
+ * @param Vectors positions of atoms (not wrapped).
+ * @return Nothing to return.
+ *************************************************************************************/
+void PeriodicBox::update(const Vectors &r) noexcept
+{
+    for (uint k = 0; k < 3; k++)
+        for (uint i = 0; i < N; i++)
+            positions[k][i] = r[k][i] - images[k][i] * edge[k];
+
+    place();
+}
+
+/**************************************************************************************
+ * Computes the virial sum r F over atoms and ghosts, which is equal to the sum
+ * r_ij F_ij over pairs of minimum images, adds forces of ghosts to their owners and
+ * then forces of atoms to F.
+ * @param Vectors forces to which pair forces are added.
+ * @return Virial of pair forces.
+ *************************************************************************************/
+double PeriodicBox::fold(Vectors &F) noexcept
+{
+    double W = 0.;
+
+    for (uint q = 0; q < M; q++)
+        W += positions.x[q] * forces.x[q] + positions.y[q] * forces.y[q] + positions.z[q] * forces.z[q];
+
+    for (uint g = 0; g < M - N; g++)
+    {
+        const uint i = owner[g];
+
+        forces.x[i] += forces.x[N + g];
+        forces.y[i] += forces.y[N + g];
+        forces.z[i] += forces.z[N + g];
+    }
+
+    for (uint i = 0; i < N; i++)
+    {
+        F.x[i] += forces.x[i];
+        F.y[i] += forces.y[i];
+        F.z[i] += forces.z[i];
+    }
+
+    return W;
+}
+
+/**************************************************************************************
+ * Wraps positions into the box, e.g. for the trajectory. Atoms are put in the order of
+ * their IDs (the simulation may have sorted them in memory).
+ * @param Vectors positions of atoms (not wrapped),
+ * @param Vectors wrapped positions,
+ * @param uint* ID of every atom.
+ * @return Nothing to return.
+ *************************************************************************************/
+void PeriodicBox::wrap(const Vectors &r, Vectors &w, const uint *ids) const noexcept
+{
+    for (uint k = 0; k < 3; k++)
+        for (uint i = 0; i < N; i++)
+            w[k][ids[i]] = r[k][i] - std::floor(r[k][i] / edge[k] + 0.5) * edge[k];
+}
@@ -0,0 +1,59 @@
+#ifndef BOX_H
+#define BOX_H
+#include <vector>
+#include "vectors.h"
+typedef unsigned short int usint;
+typedef unsigned int uint;
+
+/// Available boundaries of the system
+enum class Boundary : usint
+{
+    Sphere,   ///< Atoms confined by the elastic walls of the sphere
+    Periodic, ///< Orthorhombic periodic box without walls
+};
+
+/// Periodic images (ghosts) of atoms near the faces of the orthorhombic box. Positions
+/// of the simulation are never wrapped, every atom keeps its image index from the last
+/// build instead, so the extended array holds wrapped atoms 0 ... N - 1 followed by
+/// copies of them shifted by one edge along some axes (atoms closer than the halo
+/// rc + skin to the face). Pair kernels see ordinary atoms, forces of ghosts are
+/// folded back to their owners and sum r F over the extended array is the virial of
+/// minimum images. Edges are at least 2 rc, so only the nearest image interacts.
+class PeriodicBox
+{
+private:
+    uint N;         ///< Number of atoms
+    uint M;         ///< Number of atoms and ghosts
+    double edge[3]; ///< Edges of the box
+    double halo;    ///< Thickness of the layer copied behind every face (rc + skin)
+
+    Vectors images;                   ///< Image index of every atom (edges subtracted from positions)
+    std::vector<uint> owner;          ///< Atom of every ghost
+    std::vector<unsigned char> shift; ///< Shift of every ghost (sx + 1) + 3 (sy + 1) + 9 (sz + 1)
+
+    Vectors positions; ///< Wrapped atoms and ghosts (size is the capacity)
+    Vectors forces;    ///< Pair forces of atoms and ghosts
+
+    void collect(const Vectors &r, const bool &wrapped);
+    void place() noexcept;
+
+public:
+    PeriodicBox() noexcept;
+
+    void setup(const uint &N, const double (&edges)[3], const double &halo);
+    void rebuild(const Vectors &r);
+    void restore(const Vectors &reference, const Vectors &images);
+    void update(const Vectors &r) noexcept;
+    double fold(Vectors &F) noexcept;
+    void wrap(const Vectors &r, Vectors &w, const uint *ids) const noexcept;
+
+    double volume() const noexcept { return edge[0] * edge[1] * edge[2]; }
+    double getEdge(const uint &k) const noexcept { return edge[k]; }
+    uint size() const noexcept { return M; }
+    const uint *owners() const noexcept { return owner.data(); }
+    const Vectors &getImages() const noexcept { return images; }
+    const Vectors &getPositions() const noexcept { return positions; }
+    Vectors &getForces() noexcept { return forces; }
+};
+
+#endif // BOX_H
@@ -0,0 +1,205 @@
+#include "checkpoint.h"
+#include <cstring>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char Magic[8] = {'A', 'R', 'G', 'O', 'N', 'C', 'H', 'K'};
+    constexpr uint32_t Version = 14;
+    constexpr uint64_t FnvOffset = 14695981039346656037ull; ///< Initial value of FNV-1a hash
+    constexpr uint64_t FnvPrime = 1099511628211ull;         ///< Multiplier of FNV-1a hash
+
+    /// Updates FNV-1a hash with the given bytes
+    uint64_t hashBytes(uint64_t hash, const void *data, const std::size_t &size) noexcept
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+
+        for (std::size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= FnvPrime;
+        }
+
+        return hash;
+    }
+} // namespace
+
+Checkpoint::Checkpoint() noexcept : file(nullptr), checksum(FnvOffset), good(false)
+{
+}
+
+/**************************************************************************************
+ * Closes the file. Unfinished checkpoint is removed, so the previous one stays valid.
+ * @return Nothing to return.
+ *************************************************************************************/
+Checkpoint::~Checkpoint() noexcept
+{
+    if (file == nullptr)
+        return;
+
+    std::fclose(file);
+
+    if (!tmpPath.empty())
+        std::remove(tmpPath.c_str());
+}
+
+/**************************************************************************************
+ * Starts writing of the new checkpoint into the temporary file `filename.tmp`.
+ * @param char* filename of the checkpoint.
+ * @return True if the file is ready to write.
+ *************************************************************************************/
+bool Checkpoint::create(const char *filename)
+{
+    path = filename;
+    tmpPath = path + ".tmp";
+    checksum = FnvOffset;
+
+    file = std::fopen(tmpPath.c_str(), "wb");
+    good = (file != nullptr);
+
+    writeBytes(Magic, sizeof(Magic));
+    write(Version);
+
+    return good;
+}
+
+/**************************************************************************************
+ * Finishes writing: appends the checksum, flushes the file to the disk and atomically
+ * replaces the previous checkpoint with the new one.
+ * @return True if the checkpoint is saved.
+ *************************************************************************************/
+bool Checkpoint::commit() noexcept
+{
+    if (file == nullptr)
+        return false;
+
+    const uint64_t sum = checksum;
+    writeBytes(&sum, sizeof(sum));
+
+    good = good && std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+    good = (std::fclose(file) == 0) && good;
+    file = nullptr;
+
+    if (good)
+        good = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+
+    if (!good)
+        std::remove(tmpPath.c_str());
+
+    tmpPath.clear();
+
+    return good;
+}
+
+/**************************************************************************************
+ * Opens the checkpoint to read and checks its magic and version.
+ * @param char* filename of the checkpoint.
+ * @return True if the file is a checkpoint of the supported version.
+ *************************************************************************************/
+bool Checkpoint::open(const char *filename)
+{
+    path = filename;
+    tmpPath.clear();
+    checksum = FnvOffset;
+
+    file = std::fopen(filename, "rb");
+    good = (file != nullptr);
+
+    char magic[sizeof(Magic)] = {};
+    uint32_t version = 0;
+
+    readBytes(magic, sizeof(magic));
+    read(version);
+
+    good = good && std::memcmp(magic, Magic, sizeof(Magic)) == 0 && version == Version;
+
+    return good;
+}
+
+/**************************************************************************************
+ * Reads the checksum at the end of the checkpoint and closes the file.
+ * @return True if all values were read and the checksum is correct.
+ *************************************************************************************/
+bool Checkpoint::verify() noexcept
+{
+    if (file == nullptr)
+        return false;
+
+    const uint64_t expected = checksum;
+    uint64_t sum = 0;
+    readBytes(&sum, sizeof(sum));
+
+    good = good && sum == expected && std::fgetc(file) == EOF;
+
+    std::fclose(file);
+    file = nullptr;
+
+    return good;
+}
+
+void Checkpoint::writeBytes(const void *data, const std::size_t &size) noexcept
+{
+    if (!good)
+        return;
+
+    good = std::fwrite(data, 1, size, file) == size;
+    checksum = hashBytes(checksum, data, size);
+}
+
+void Checkpoint::readBytes(void *data, const std::size_t &size) noexcept
+{
+    if (!good)
+        return;
+
+    good = std::fread(data, 1, size, file) == size;
+    checksum = hashBytes(checksum, data, size);
+}
+
+void Checkpoint::write(const double *values, const uint &count) noexcept
+{
+    write(count);
+    writeBytes(values, count * sizeof(double));
+}
+
+/**************************************************************************************
+ * Reads array written by `write(const double *, uint)`. The array must have the same
+ * size as the saved one.
+ * @param double* array to fill,
+ * @param uint size of the array.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Checkpoint::read(double *values, const uint &count) noexcept
+{
+    uint saved = 0;
+    read(saved);
+
+    good = good && saved == count;
+    readBytes(values, count * sizeof(double));
+}
+
+void Checkpoint::write(const uint *values, const uint &count) noexcept
+{
+    write(count);
+    writeBytes(values, count * sizeof(uint));
+}
+
+void Checkpoint::read(uint *values, const uint &count) noexcept
+{
+    uint saved = 0;
+    read(saved);
+
+    good = good && saved == count;
+    readBytes(values, count * sizeof(uint));
+}
+
+void Checkpoint::write(const Vectors &v) noexcept
+{
+    for (uint k = 0; k < 3; k++)
+        write(v[k], v.size());
+}
+
+void Checkpoint::read(Vectors &v) noexcept
+{
+    for (uint k = 0; k < 3; k++)
+        read(v[k], v.size());
+}
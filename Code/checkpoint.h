@@ -0,0 +1,53 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include "vectors.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+typedef unsigned int uint;
+
+/// Binary file with the complete state of the simulation. It starts with the magic
+/// "ARGONCHK" and the version, then values follow in the order of writing and the file
+/// ends with the FNV-1a checksum of all previous bytes. The checkpoint is written to
+/// a temporary file which replaces the previous one only when it is complete and synced
+/// to the disk (rename is atomic), so a crash never leaves a corrupt checkpoint.
+class Checkpoint
+{
+private:
+    std::FILE *file;     ///< Opened file
+    std::string path;    ///< Final name of the file
+    std::string tmpPath; ///< Temporary name used while writing
+    uint64_t checksum;   ///< FNV-1a hash of bytes written or read so far
+    bool good;           ///< False after any failed write or read
+
+    void writeBytes(const void *data, const std::size_t &size) noexcept;
+    void readBytes(void *data, const std::size_t &size) noexcept;
+
+public:
+    Checkpoint() noexcept;
+    ~Checkpoint() noexcept;
+
+    Checkpoint(const Checkpoint &) = delete;
+    Checkpoint &operator=(const Checkpoint &) = delete;
+
+    bool create(const char *filename);
+    bool commit() noexcept;
+    bool open(const char *filename);
+    bool verify() noexcept;
+
+    template <typename T>
+    void write(const T &value) noexcept { writeBytes(&value, sizeof(T)); }
+    template <typename T>
+    void read(T &value) noexcept { readBytes(&value, sizeof(T)); }
+
+    void write(const double *values, const uint &count) noexcept;
+    void read(double *values, const uint &count) noexcept;
+    void write(const uint *values, const uint &count) noexcept;
+    void read(uint *values, const uint &count) noexcept;
+    void write(const Vectors &v) noexcept;
+    void read(Vectors &v) noexcept;
+
+    bool ok() const noexcept { return good; }
+};
+
+#endif // CHECKPOINT_H
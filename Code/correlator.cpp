@@ -0,0 +1,324 @@
+#include "correlator.h"
+#include "profile.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+namespace
+{
+    /// Time, MSD and VACF of the single lag
+    struct Lag
+    {
+        double t;
+        double msd;
+        double vacf;
+    };
+
+    /**************************************************************************************
+     * Mean values of all lags with samples in the order of increasing time. Level l > 0
+     * starts at lag P/2, whose time P 2^(l - 1) dt is greater than all lags below.
+     *************************************************************************************/
+    std::vector<Lag> lags(const std::vector<double> &msd, const std::vector<double> &vacf,
+                          const std::vector<uint64_t> &counts, const uint &P, const uint &levels, const double &dt)
+    {
+        std::vector<Lag> result;
+
+        for (uint l = 0; l < levels; l++)
+        {
+            for (uint j = (l == 0) ? 0 : P / 2; j < P; j++)
+            {
+                const uint q = l * P + j;
+
+                if (counts[q] > 0)
+                    result.push_back({std::ldexp(j * dt, l), msd[q] / counts[q], vacf[q] / counts[q]});
+            }
+        }
+
+        return result;
+    }
+} // namespace
+
+MultiTauCorrelator::MultiTauCorrelator() noexcept : N(0), P(0), levels(0), dt(0.), stride(0), samples(0)
+{
+}
+
+/**************************************************************************************
+ * Number of levels whose lags cover the whole run.
+ * @param uint64_t number of samples of the run,
+ * @param uint number of samples kept on every level.
+ * @return Number of levels (at most 40).
+ *************************************************************************************/
+uint MultiTauCorrelator::levelsFor(const uint64_t &nSamples, const uint &nPoints) noexcept
+{
+    uint l = 1;
+
+    while (l < 40 && (static_cast<uint64_t>(nPoints) << (l - 1)) < nSamples)
+        l++;
+
+    return l;
+}
+
+/**************************************************************************************
+ * Memory of the correlator.
+ * @param uint number of atoms,
+ * @param uint number of samples kept on every level,
+ * @param uint number of levels.
+ * @return Size of buffers in bytes.
+ *************************************************************************************/
+uint64_t MultiTauCorrelator::bytes(const uint &NAtoms, const uint &nPoints, const uint &nLevels) noexcept
+{
+    return static_cast<uint64_t>(NAtoms) * nLevels * (2 * nPoints + 1) * 3 * sizeof(double);
+}
+
+/**************************************************************************************
+ * Prepares empty buffers and correlations.
+ * @param uint number of atoms,
+ * @param uint number of samples kept on every level (even),
+ * @param uint number of levels,
+ * @param double time between samples.
+ * @return Nothing to return.
+ *************************************************************************************/
+void MultiTauCorrelator::setup(const uint &NAtoms, const uint &nPoints, const uint &nLevels, const double &dtSample)
+{
+    N = NAtoms;
+    P = nPoints;
+    levels = nLevels;
+    dt = dtSample;
+    stride = N;
+
+    const std::size_t blocks = static_cast<std::size_t>(levels) * 3 * stride;
+
+    rBuf.assign(blocks * P, 0.);
+    vBuf.assign(blocks * P, 0.);
+    vAcc.assign(blocks, 0.);
+    accumulated.assign(levels, 0);
+
+    head.assign(levels, 0);
+    filled.assign(levels, 0);
+
+    msd.assign(levels * P, 0.);
+    vacf.assign(levels * P, 0.);
+    counts.assign(levels * P, 0);
+
+    samples = 0;
+}
+
+/**************************************************************************************
+ * Adds the sample of positions and velocities p / m. Positions are never wrapped
+ * (atoms are confined by the walls or the periodic box keeps image indices apart), so
+ * they are used directly. Samples are stored by IDs of atoms, which stay the same when
+ * the simulation sorts atoms in memory.
+ * @param Vectors positions of atoms,
+ * @param Vectors momenta of atoms,
+ * @param double mass of the single atom,
+ * @param uint* ID of every atom.
+ * @return Nothing to return.
+ *************************************************************************************/
+void MultiTauCorrelator::add(const Vectors &r, const Vectors &p, const double &m, const uint *ids) noexcept
+{
+    ARGON_PROFILE_SCOPE(Phase::Correlation);
+
+    double *rr = positions(0, head[0]);
+    double *vv = velocities(0, head[0]);
+
+    for (uint c = 0; c < 3; c++)
+    {
+        const double *rc = r[c];
+        const double *pc = p[c];
+
+        for (uint i = 0; i < N; i++)
+        {
+            rr[c * stride + ids[i]] = rc[i];
+            vv[c * stride + ids[i]] = pc[i] / m;
+        }
+    }
+
+    samples++;
+    correlate(0);
+}
+
+/**************************************************************************************
+ * Correlates the newest sample of level l (already in its slot) with the older ones
+ * and passes every second sample (positions) and the average of two samples
+ * (velocities) to the next level.
+ * @param uint level.
+ * @return Nothing to return.
+ *************************************************************************************/
+void MultiTauCorrelator::correlate(const uint &l) noexcept
+{
+    const uint slot = head[l];
+    const uint first = (l == 0) ? 0 : P / 2;
+    const double *r1 = positions(l, slot);
+    const double *v1 = velocities(l, slot);
+
+    filled[l] = std::min(filled[l] + 1, P);
+
+    for (uint j = first; j < filled[l]; j++)
+    {
+        const uint old = (slot + P - j) % P;
+        const double *r2 = positions(l, old);
+        const double *v2 = velocities(l, old);
+        double dr2 = 0., vv = 0.;
+
+        for (uint k = 0; k < 3 * stride; k++)
+        {
+            const double d = r1[k] - r2[k];
+            dr2 += d * d;
+            vv += v1[k] * v2[k];
+        }
+
+        msd[l * P + j] += dr2 / N;
+        vacf[l * P + j] += vv / N;
+        counts[l * P + j]++;
+    }
+
+    head[l] = (slot + 1) % P;
+
+    if (l + 1 == levels)
+        return;
+
+    double *vSum = vAcc.data() + static_cast<std::size_t>(l) * 3 * stride;
+
+    for (uint k = 0; k < 3 * stride; k++)
+        vSum[k] += v1[k];
+
+    if (++accumulated[l] < 2)
+        return;
+
+    double *rNext = positions(l + 1, head[l + 1]);
+    double *vNext = velocities(l + 1, head[l + 1]);
+
+    for (uint k = 0; k < 3 * stride; k++)
+    {
+        rNext[k] = r1[k];
+        vNext[k] = 0.5 * vSum[k];
+        vSum[k] = 0.;
+    }
+
+    accumulated[l] = 0;
+    correlate(l + 1);
+}
+
+/**************************************************************************************
+ * Diffusion constant from the slope of MSD (Einstein, MSD = 6 D t) and from the
+ * integral of VACF (Green-Kubo, D = 1/3 int VACF dt, trapezoids on the lags). Both use
+ * lags up to the tenth of the sampled time (later ones have too few time origins) and
+ * with MSD below `limit`, where displacements are not yet bounded by the walls. The
+ * slope is fitted by least squares over the last decade of these lags.
+ * @param double largest MSD of the fit,
+ * @param double diffusion constant from MSD,
+ * @param double diffusion constant from VACF.
+ * @return Nothing to return.
+ *************************************************************************************/
+void MultiTauCorrelator::diffusion(const double &limit, double &Dmsd, double &Dvacf) const noexcept
+{
+    const std::vector<Lag> result = lags(msd, vacf, counts, P, levels, dt);
+    const double tRun = 0.1 * samples * dt;
+    double tEnd = 0.;
+
+    for (const Lag &lag : result)
+        if (lag.msd < limit && lag.t <= tRun)
+            tEnd = lag.t;
+
+    Dmsd = Dvacf = 0.;
+
+    for (std::size_t q = 1; q < result.size() && result[q].t <= tEnd; q++)
+        Dvacf += 0.5 * (result[q].vacf + result[q - 1].vacf) * (result[q].t - result[q - 1].t) / 3.;
+
+    double n = 0., st = 0., sy = 0., stt = 0., sty = 0.;
+
+    for (const Lag &lag : result)
+    {
+        if (lag.t >= 0.1 * tEnd && lag.t <= tEnd && lag.t > 0.)
+        {
+            n += 1.;
+            st += lag.t;
+            sy += lag.msd;
+            stt += lag.t * lag.t;
+            sty += lag.t * lag.msd;
+        }
+    }
+
+    if (n > 1.)
+        Dmsd = (n * sty - st * sy) / (n * stt - st * st) / 6.;
+}
+
+/**************************************************************************************
+ * Saves columns t, MSD(t), VACF(t) and VACF(t) / VACF(0) preceded by the diffusion
+ * constants in lines starting with `#`.
+ * @param char* filename in `Out` folder,
+ * @param double largest MSD of the fit of the diffusion constant.
+ * @return True if the file is written.
+ *************************************************************************************/
+bool MultiTauCorrelator::save(const char *filename, const double &limit) const
+{
+    std::ofstream ofile("../Out/" + std::string(filename), std::ios::out);
+    const std::vector<Lag> result = lags(msd, vacf, counts, P, levels, dt);
+
+    double Dmsd, Dvacf;
+    diffusion(limit, Dmsd, Dvacf);
+
+    ofile << std::scientific << std::setprecision(6);
+    ofile << "# D (MSD):  " << Dmsd << '\n';
+    ofile << "# D (VACF): " << Dvacf << '\n';
+
+    const double vacf0 = result.empty() ? 0. : result.front().vacf;
+
+    for (const Lag &lag : result)
+        ofile << lag.t << '\t' << lag.msd << '\t' << lag.vacf << '\t' << (vacf0 > 0. ? lag.vacf / vacf0 : 0.) << '\n';
+
+    return ofile.good();
+}
+
+/**************************************************************************************
+ * Saves the complete state of the correlator to the checkpoint.
+ * @param Checkpoint opened checkpoint.
+ * @return Nothing to return.
+ *************************************************************************************/
+void MultiTauCorrelator::write(Checkpoint &chk) const noexcept
+{
+    chk.write(samples);
+    chk.write(rBuf.data(), rBuf.size());
+    chk.write(vBuf.data(), vBuf.size());
+    chk.write(vAcc.data(), vAcc.size());
+    chk.write(msd.data(), msd.size());
+    chk.write(vacf.data(), vacf.size());
+
+    for (uint l = 0; l < levels; l++)
+    {
+        chk.write(accumulated[l]);
+        chk.write(head[l]);
+        chk.write(filled[l]);
+    }
+
+    for (const uint64_t &count : counts)
+        chk.write(count);
+}
+
+/**************************************************************************************
+ * Restores the state saved by `write()`, the correlator has to be set up with the
+ * same sizes.
+ * @param Checkpoint opened checkpoint.
+ * @return Nothing to return.
+ *************************************************************************************/
+void MultiTauCorrelator::read(Checkpoint &chk) noexcept
+{
+    chk.read(samples);
+    chk.read(rBuf.data(), rBuf.size());
+    chk.read(vBuf.data(), vBuf.size());
+    chk.read(vAcc.data(), vAcc.size());
+    chk.read(msd.data(), msd.size());
+    chk.read(vacf.data(), vacf.size());
+
+    for (uint l = 0; l < levels; l++)
+    {
+        chk.read(accumulated[l]);
+        chk.read(head[l]);
+        chk.read(filled[l]);
+    }
+
+    for (uint64_t &count : counts)
+        chk.read(count);
+}
@@ -0,0 +1,65 @@
+#ifndef CORRELATOR_H
+#define CORRELATOR_H
+#include <cstdint>
+#include <vector>
+#include "vectors.h"
+#include "checkpoint.h"
+typedef unsigned int uint;
+
+/// Mean squared displacement and velocity autocorrelation of atoms computed on the fly
+/// by the multiple-tau correlator. Level l keeps the last P samples of blocks of 2^l
+/// samples, so lags j 2^l dt for j < P are correlated at the resolution of their block
+/// and the memory is O(N P log T) instead of O(N T). Level 0 gives lags 0 ... P - 1,
+/// every next level lags P/2 ... P - 1 of its own blocks. Velocities are averaged over
+/// the block, positions are taken at its end (averaged positions would lower MSD of
+/// the lag j blocks by 1/(3j) of the diffusive value, decimated ones are unbiased).
+class MultiTauCorrelator
+{
+private:
+    uint N;      ///< Number of atoms
+    uint P;      ///< Number of samples kept on every level
+    uint levels; ///< Number of levels
+    double dt;   ///< Time between samples of level 0
+    uint stride; ///< Distance (in doubles) between component arrays in buffers
+
+    /// Buffers of samples in the layout [level][slot][component][atom]
+    std::vector<double> rBuf; ///< Positions (at the end of blocks of the level)
+    std::vector<double> vBuf; ///< Velocities (averaged over blocks of the level)
+
+    /// Sums of velocities waiting for the next level in the layout [level][component][atom]
+    std::vector<double> vAcc;      ///< Sums of velocities
+    std::vector<uint> accumulated; ///< Number of samples in the sums of every level
+
+    std::vector<uint> head;   ///< Slot of the next sample on every level
+    std::vector<uint> filled; ///< Number of valid slots on every level
+
+    /// Correlations in the layout [level][lag]
+    std::vector<double> msd;      ///< Sums of mean squared displacements
+    std::vector<double> vacf;     ///< Sums of mean products of velocities
+    std::vector<uint64_t> counts; ///< Number of correlated pairs of samples
+
+    uint64_t samples; ///< Number of samples of level 0
+
+    double *positions(const uint &l, const uint &slot) noexcept { return rBuf.data() + (static_cast<std::size_t>(l) * P + slot) * 3 * stride; }
+    double *velocities(const uint &l, const uint &slot) noexcept { return vBuf.data() + (static_cast<std::size_t>(l) * P + slot) * 3 * stride; }
+    void correlate(const uint &l) noexcept;
+
+public:
+    MultiTauCorrelator() noexcept;
+
+    static uint levelsFor(const uint64_t &samples, const uint &P) noexcept;
+    static uint64_t bytes(const uint &N, const uint &P, const uint &levels) noexcept;
+
+    void setup(const uint &N, const uint &P, const uint &levels, const double &dt);
+    void add(const Vectors &r, const Vectors &p, const double &m, const uint *ids) noexcept;
+    void diffusion(const double &limit, double &Dmsd, double &Dvacf) const noexcept;
+    bool save(const char *filename, const double &limit) const;
+
+    void write(Checkpoint &chk) const noexcept;
+    void read(Checkpoint &chk) noexcept;
+
+    uint getLevels() const noexcept { return levels; }
+    uint64_t getSamples() const noexcept { return samples; }
+};
+
+#endif // CORRELATOR_H
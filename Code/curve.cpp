@@ -0,0 +1,125 @@
+#include "curve.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /**************************************************************************************
+     * Spreads 10 bits of the coordinate to every third bit (bit b goes to bit 3b).
+     *************************************************************************************/
+    inline uint64_t spread(uint64_t x) noexcept
+    {
+        x &= 0x3ff;
+        x = (x | x << 16) & 0x30000ff;
+        x = (x | x << 8) & 0x300f00f;
+        x = (x | x << 4) & 0x30c30c3;
+        x = (x | x << 2) & 0x9249249;
+
+        return x;
+    }
+} // namespace
+
+/**************************************************************************************
+ * Position of the cell on the Morton (Z-order) curve: bits of the coordinates are
+ * interleaved from the most significant one, x first.
+ * @param uint32_t[3] cell coordinates below 2^CurveBits.
+ * @return Key of the cell.
+ *************************************************************************************/
+uint64_t mortonKey(const uint32_t (&cell)[3]) noexcept
+{
+    return spread(cell[0]) << 2 | spread(cell[1]) << 1 | spread(cell[2]);
+}
+
+/**************************************************************************************
+ * Position of the cell on the Hilbert curve by the algorithm of J. Skilling
+ * (Programming the Hilbert curve, AIP Conf. Proc. 707, 2004): coordinates are
+ * transformed into the transposed Hilbert index, which is then interleaved like the
+ * Morton key.
+ * @param uint32_t[3] cell coordinates below 2^CurveBits.
+ * @return Key of the cell.
+ *************************************************************************************/
+uint64_t hilbertKey(const uint32_t (&cell)[3]) noexcept
+{
+    uint32_t X[3] = {cell[0], cell[1], cell[2]};
+
+    // Inverse undo of the excess work
+    for (uint32_t Q = 1u << (CurveBits - 1); Q > 1; Q >>= 1)
+    {
+        const uint32_t P = Q - 1;
+
+        for (uint i = 0; i < 3; i++)
+        {
+            if (X[i] & Q)
+                X[0] ^= P;
+            else
+            {
+                const uint32_t t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+
+    // Gray encode
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+
+    uint32_t t = 0;
+
+    for (uint32_t Q = 1u << (CurveBits - 1); Q > 1; Q >>= 1)
+        if (X[2] & Q)
+            t ^= Q - 1;
+
+    for (uint i = 0; i < 3; i++)
+        X[i] ^= t;
+
+    return mortonKey(X);
+}
+
+/**************************************************************************************
+ * Orders atoms along the curve over the grid of 2^CurveBits cells along every edge of
+ * the region [low, low + size). Atoms outside are clamped to the border cells or, in
+ * the periodic box, wrapped. Atoms in the same cell keep their relative order.
+ * @param Vectors positions of atoms,
+ * @param double[3] lower corner of the region,
+ * @param double[3] edges of the region,
+ * @param bool true if the region is periodic,
+ * @param Curve space-filling curve,
+ * @param uint number of threads computing keys,
+ * @param vector<uint> order[j] is the atom which goes to the place j.
+ * @return Nothing to return.
+ *************************************************************************************/
+void curveOrder(const Vectors &r, const double (&low)[3], const double (&size)[3], const bool &periodic, const Curve &curve,
+                const uint &threads, std::vector<uint> &order)
+{
+    const uint N = r.size();
+    const double cells = 1u << CurveBits;
+
+    // Key in the high half and the atom in the low half, so a single sort gives both
+    std::vector<uint64_t> keys(N);
+
+#pragma omp parallel for num_threads(threads) if (threads > 1)
+    for (uint i = 0; i < N; i++)
+    {
+        uint32_t cell[3];
+
+        for (uint k = 0; k < 3; k++)
+        {
+            double s = (r[k][i] - low[k]) / size[k];
+
+            if (periodic)
+                s -= std::floor(s);
+
+            cell[k] = static_cast<uint32_t>(std::clamp(s * cells, 0., cells - 1.));
+        }
+
+        const uint64_t key = (curve == Curve::Morton) ? mortonKey(cell) : hilbertKey(cell);
+        keys[i] = key << 32 | i;
+    }
+
+    std::sort(keys.begin(), keys.end());
+    order.resize(N);
+
+    for (uint j = 0; j < N; j++)
+        order[j] = static_cast<uint>(keys[j]);
+}
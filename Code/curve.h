@@ -0,0 +1,24 @@
+#ifndef CURVE_H
+#define CURVE_H
+#include <cstdint>
+#include <vector>
+#include "vectors.h"
+typedef unsigned short int usint;
+typedef unsigned int uint;
+
+/// Space-filling curves ordering atoms in memory
+enum class Curve : usint
+{
+    Morton,  ///< Z-order, interleaved bits of the cell coordinates
+    Hilbert, ///< Hilbert curve, consecutive cells are always face neighbours
+};
+
+/// Bits of every cell coordinate, i.e. 1024 cells along every edge of the sorted region
+constexpr uint CurveBits = 10;
+
+uint64_t mortonKey(const uint32_t (&cell)[3]) noexcept;
+uint64_t hilbertKey(const uint32_t (&cell)[3]) noexcept;
+void curveOrder(const Vectors &r, const double (&low)[3], const double (&size)[3], const bool &periodic, const Curve &curve,
+                const uint &threads, std::vector<uint> &order);
+
+#endif // CURVE_H
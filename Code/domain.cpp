@@ -0,0 +1,557 @@
+#include "domain.h"
+#ifdef ARGON_MPI
+#include <algorithm>
+#include <cmath>
+
+Domain::Domain() noexcept : world(MPI_COMM_NULL), cart(MPI_COMM_NULL), rank(0), ranks(1), dims{1, 1, 1}, coords{0, 0, 0},
+                            neighbor{{0, 0}, {0, 0}, {0, 0}}, edge{0., 0., 0.}, low{0., 0., 0.}, high{0., 0., 0.},
+                            shift{0., 0., 0., 0., 0., 0.}, halo(0.), N(0), M(0), first{0, 0, 0, 0, 0, 0},
+                            received{0, 0, 0, 0, 0, 0}
+{
+}
+
+/**************************************************************************************
+ * Releases the Cartesian communicator (unless MPI has been finalized already).
+ * @return Nothing to return.
+ *************************************************************************************/
+Domain::~Domain() noexcept
+{
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+
+    if (cart != MPI_COMM_NULL && !finalized)
+        MPI_Comm_free(&cart);
+}
+
+/**************************************************************************************
+ * Balanced grid of ranks, e.g. 2 x 1 x 1 for 2 ranks and 2 x 2 x 1 for 4 ranks. The
+ * same for every call, so parameters may be validated before the grid is created.
+ * @param int number of ranks,
+ * @param int[3] number of ranks along every axis.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::grid(const int &nRanks, int (&grid)[3]) noexcept
+{
+    grid[0] = grid[1] = grid[2] = 0;
+    MPI_Dims_create(nRanks, 3, grid);
+}
+
+/**************************************************************************************
+ * Attaches the domain to the communicator of the run (the grid is created later by
+ * `setup()`).
+ * @param MPI_Comm communicator of all ranks of the run.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::attach(MPI_Comm comm)
+{
+    if (cart != MPI_COMM_NULL)
+        MPI_Comm_free(&cart);
+
+    world = comm;
+    MPI_Comm_rank(world, &rank);
+    MPI_Comm_size(world, &ranks);
+}
+
+/**************************************************************************************
+ * Creates the periodic grid of ranks over the box [-Lx/2, Lx/2) x [-Ly/2, Ly/2) x
+ * [-Lz/2, Lz/2) and finds the brick of this rank. The domain is left empty.
+ * @param double[3] edges of the box,
+ * @param double thickness of the layer of ghosts (rc + skin, not larger than the brick).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::setup(const double (&edges)[3], const double &layer)
+{
+    if (cart != MPI_COMM_NULL)
+        MPI_Comm_free(&cart);
+
+    const int periods[3] = {1, 1, 1};
+
+    grid(ranks, dims);
+    MPI_Cart_create(world, 3, dims, periods, 0, &cart);
+    MPI_Cart_coords(cart, rank, 3, coords);
+
+    halo = layer;
+
+    for (uint k = 0; k < 3; k++)
+    {
+        MPI_Cart_shift(cart, k, 1, &neighbor[k][0], &neighbor[k][1]);
+
+        // Neighbours compute the common face by the same expression
+        edge[k] = edges[k];
+        low[k] = -0.5 * edge[k] + coords[k] * edge[k] / dims[k];
+        high[k] = -0.5 * edge[k] + (coords[k] + 1) * edge[k] / dims[k];
+
+        // Atoms sent across the border of the box come to the other end
+        shift[2 * k] = (coords[k] == 0) ? edge[k] : 0.;
+        shift[2 * k + 1] = (coords[k] == dims[k] - 1) ? -edge[k] : 0.;
+    }
+
+    clear();
+}
+
+/**************************************************************************************
+ * Removes all atoms and ghosts.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::clear() noexcept
+{
+    N = 0;
+    M = 0;
+
+    for (uint s = 0; s < 6; s++)
+    {
+        sent[s].clear();
+        first[s] = 0;
+        received[s] = 0;
+    }
+}
+
+/**************************************************************************************
+ * Index of the brick along the axis which owns the position wrapped into the box (by
+ * the same expression as `PeriodicBox::wrap()`).
+ * @param uint axis,
+ * @param double coordinate of the position (not wrapped).
+ * @return Coordinate of the owner in the grid of ranks.
+ *************************************************************************************/
+int Domain::cell(const uint &k, const double &x) const noexcept
+{
+    const double w = x - std::floor(x / edge[k] + 0.5) * edge[k];
+    const int c = static_cast<int>(std::floor((w + 0.5 * edge[k]) / edge[k] * dims[k]));
+
+    return std::clamp(c, 0, dims[k] - 1);
+}
+
+/**************************************************************************************
+ * Checks if the position (wrapped into the box) belongs to the brick of this rank.
+ * Every position belongs to exactly one rank.
+ * @param double[3] position.
+ * @return True if the position is in the brick.
+ *************************************************************************************/
+bool Domain::contains(const double (&x)[3]) const noexcept
+{
+    for (uint k = 0; k < 3; k++)
+        if (cell(k, x[k]) != coords[k])
+            return false;
+
+    return true;
+}
+
+/**************************************************************************************
+ * Adds the atom to the domain (only before the first exchange of ghosts).
+ * @param uint global ID of the atom,
+ * @param double[3] position (not wrapped),
+ * @param double[3] momentum.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::add(const uint &id, const double (&x)[3], const double (&px)[3])
+{
+    reserve(N + 1);
+
+    for (uint k = 0; k < 3; k++)
+    {
+        u[k][N] = x[k];
+        images[k][N] = 0.;
+        r[k][N] = x[k];
+        p[k][N] = px[k];
+    }
+
+    ids[N] = id;
+    M = ++N;
+}
+
+/**************************************************************************************
+ * Makes room for the given number of atoms and ghosts, atoms are kept (forces are
+ * not, they are evaluated again after every exchange).
+ * @param uint number of atoms and ghosts.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::reserve(const uint &count)
+{
+    if (count <= r.size())
+        return;
+
+    // Some spare room, the numbers of atoms and ghosts fluctuate
+    const uint capacity = count + count / 8;
+    Vectors uNew(capacity), imagesNew(capacity), rNew(capacity), pNew(capacity);
+
+    for (uint k = 0; k < 3; k++)
+    {
+        std::copy(u[k], u[k] + M, uNew[k]);
+        std::copy(images[k], images[k] + M, imagesNew[k]);
+        std::copy(r[k], r[k] + M, rNew[k]);
+        std::copy(p[k], p[k] + M, pNew[k]);
+    }
+
+    u.swap(uNew);
+    images.swap(imagesNew);
+    r.swap(rNew);
+    p.swap(pNew);
+    F.resize(capacity);
+    ids.resize(capacity);
+}
+
+/**************************************************************************************
+ * Sends the packed atoms to one neighbour and receives those of the other one.
+ * @param int rank which gets `sendBuffer`,
+ * @param int rank which fills `recvBuffer`,
+ * @param uint number of doubles of every atom,
+ * @param bool true if `recvBuffer` already has the size of the message (otherwise
+ * sizes are exchanged first).
+ * @return Number of received atoms.
+ *************************************************************************************/
+uint Domain::transfer(const int &dest, const int &source, const uint &width, const bool &known)
+{
+    if (!known)
+    {
+        uint64_t outgoing = sendBuffer.size(), incoming = 0;
+
+        MPI_Sendrecv(&outgoing, 1, MPI_UINT64_T, dest, 0, &incoming, 1, MPI_UINT64_T, source, 0, cart, MPI_STATUS_IGNORE);
+        recvBuffer.resize(incoming);
+    }
+
+    MPI_Sendrecv(sendBuffer.data(), sendBuffer.size(), MPI_DOUBLE, dest, 1, recvBuffer.data(), recvBuffer.size(),
+                 MPI_DOUBLE, source, 1, cart, MPI_STATUS_IGNORE);
+
+    return recvBuffer.size() / width;
+}
+
+/**************************************************************************************
+ * Wrapped positions of atoms from the unwrapped ones and image indices of the last
+ * exchange, as `PeriodicBox::update()` (atoms may leave the brick by half of the skin
+ * until the next exchange).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::update() noexcept
+{
+    for (uint k = 0; k < 3; k++)
+        for (uint i = 0; i < N; i++)
+            r[k][i] = u[k][i] - images[k][i] * edge[k];
+}
+
+/**************************************************************************************
+ * Moves atoms whose wrapped positions have left the brick to the neighbouring ranks
+ * (with ID, unwrapped position and momentum), first along x, then y and z, so an atom
+ * which has left across the edge or corner arrives in two or three hops. Ghosts are
+ * dropped.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::migrate()
+{
+    M = N;
+
+    for (uint s = 0; s < 6; s++)
+    {
+        const uint k = s / 2;
+        const bool down = (s % 2 == 0);
+
+        // With two ranks along the axis both neighbours are the same rank
+        const int upper = (coords[k] + 1) % dims[k];
+
+        sendBuffer.clear();
+
+        for (uint i = 0; i < N;)
+        {
+            const int c = cell(k, u[k][i]);
+
+            if (c == coords[k] || (c == upper) == down)
+            {
+                i++;
+                continue;
+            }
+
+            sendBuffer.insert(sendBuffer.end(), {static_cast<double>(ids[i]), u.x[i], u.y[i], u.z[i], p.x[i], p.y[i], p.z[i]});
+
+            // The last atom takes the place of the leaving one
+            N--;
+
+            for (uint j = 0; j < 3; j++)
+            {
+                u[j][i] = u[j][N];
+                p[j][i] = p[j][N];
+            }
+
+            ids[i] = ids[N];
+        }
+
+        M = N;
+
+        const uint count = transfer(neighbor[k][down ? 0 : 1], neighbor[k][down ? 1 : 0], 7, false);
+        reserve(N + count);
+
+        for (uint a = 0; a < count; a++, N++)
+        {
+            const double *atom = recvBuffer.data() + 7 * a;
+
+            ids[N] = static_cast<uint>(atom[0]);
+
+            for (uint j = 0; j < 3; j++)
+            {
+                u[j][N] = atom[1 + j];
+                p[j][N] = atom[4 + j];
+            }
+        }
+
+        M = N;
+    }
+}
+
+/**************************************************************************************
+ * Copies atoms closer than the halo to the faces of the brick to the neighbouring ranks
+ * as ghosts and remembers the routes for `forward()` and `fold()`. Stages along y and
+ * z also forward ghosts received along the earlier axes. Called after `migrate()`.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::exchange()
+{
+    // Image indices and wrapped positions of atoms, as `PeriodicBox::rebuild()`
+    for (uint k = 0; k < 3; k++)
+    {
+        for (uint i = 0; i < N; i++)
+        {
+            images[k][i] = std::floor(u[k][i] / edge[k] + 0.5);
+            r[k][i] = u[k][i] - images[k][i] * edge[k];
+        }
+    }
+
+    M = N;
+
+    for (uint k = 0; k < 3; k++)
+    {
+        // Atoms and ghosts of the earlier axes
+        const uint candidates = M;
+
+        for (uint s = 2 * k; s < 2 * k + 2; s++)
+        {
+            const bool down = (s % 2 == 0);
+
+            sent[s].clear();
+            sendBuffer.clear();
+
+            for (uint q = 0; q < candidates; q++)
+            {
+                if (down ? r[k][q] >= low[k] + halo : r[k][q] < high[k] - halo)
+                    continue;
+
+                sent[s].push_back(q);
+                sendBuffer.insert(sendBuffer.end(), {static_cast<double>(ids[q]), r.x[q], r.y[q], r.z[q]});
+                sendBuffer[sendBuffer.size() - 3 + k] += shift[s];
+            }
+
+            const uint count = transfer(neighbor[k][down ? 0 : 1], neighbor[k][down ? 1 : 0], 4, false);
+            reserve(M + count);
+
+            first[s] = M;
+            received[s] = count;
+
+            for (uint g = 0; g < count; g++, M++)
+            {
+                const double *ghost = recvBuffer.data() + 4 * g;
+
+                ids[M] = static_cast<uint>(ghost[0]);
+                r.x[M] = ghost[1];
+                r.y[M] = ghost[2];
+                r.z[M] = ghost[3];
+            }
+        }
+    }
+}
+
+/**************************************************************************************
+ * Moves ghosts to the current positions of their atoms along the routes of the last
+ * exchange.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::forward()
+{
+    for (uint s = 0; s < 6; s++)
+    {
+        const uint k = s / 2;
+        const bool down = (s % 2 == 0);
+        const std::vector<uint> &atoms = sent[s];
+
+        sendBuffer.resize(3 * atoms.size());
+        recvBuffer.resize(3 * received[s]);
+
+        for (uint a = 0; a < atoms.size(); a++)
+        {
+            for (uint j = 0; j < 3; j++)
+                sendBuffer[3 * a + j] = r[j][atoms[a]];
+
+            sendBuffer[3 * a + k] += shift[s];
+        }
+
+        transfer(neighbor[k][down ? 0 : 1], neighbor[k][down ? 1 : 0], 3, true);
+
+        for (uint g = 0; g < received[s]; g++)
+            for (uint j = 0; j < 3; j++)
+                r[j][first[s] + g] = recvBuffer[3 * g + j];
+    }
+}
+
+/**************************************************************************************
+ * Computes the virial sum r F over atoms and ghosts of the domain (summed over ranks it
+ * is the sum r_ij F_ij over pairs of minimum images) and sends forces of ghosts back to
+ * their atoms, in the reverse order of stages, so forwarded ghosts pass their forces on.
+ * @return Virial of pair forces of the domain.
+ *************************************************************************************/
+double Domain::fold()
+{
+    double W = 0.;
+
+    for (uint q = 0; q < M; q++)
+        W += r.x[q] * F.x[q] + r.y[q] * F.y[q] + r.z[q] * F.z[q];
+
+    for (uint s = 6; s-- > 0;)
+    {
+        const uint k = s / 2;
+        const bool down = (s % 2 == 0);
+        const std::vector<uint> &atoms = sent[s];
+
+        sendBuffer.resize(3 * received[s]);
+        recvBuffer.resize(3 * atoms.size());
+
+        for (uint g = 0; g < received[s]; g++)
+            for (uint j = 0; j < 3; j++)
+                sendBuffer[3 * g + j] = F[j][first[s] + g];
+
+        transfer(neighbor[k][down ? 1 : 0], neighbor[k][down ? 0 : 1], 3, true);
+
+        for (uint a = 0; a < atoms.size(); a++)
+            for (uint j = 0; j < 3; j++)
+                F[j][atoms[a]] += recvBuffer[3 * a + j];
+    }
+
+    return W;
+}
+
+/**************************************************************************************
+ * Gathers the vector of every atom on rank 0 in the order of IDs, e.g. positions for
+ * the trajectory.
+ * @param Vectors vectors of atoms of the domain (e.g. `unwrapped()`),
+ * @param Vectors vectors of all atoms on rank 0 (not used by other ranks),
+ * @param bool true if positions are wrapped into the box (as `PeriodicBox::wrap()`).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::gather(const Vectors &v, Vectors &out, const bool &wrap)
+{
+    sendBuffer.resize(4 * N);
+
+    for (uint i = 0; i < N; i++)
+    {
+        sendBuffer[4 * i] = ids[i];
+
+        for (uint k = 0; k < 3; k++)
+            sendBuffer[4 * i + 1 + k] = wrap ? v[k][i] - std::floor(v[k][i] / edge[k] + 0.5) * edge[k] : v[k][i];
+    }
+
+    const int count = sendBuffer.size();
+    std::vector<int> counts(rank == 0 ? ranks : 0), offsets(rank == 0 ? ranks : 0);
+
+    MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, world);
+
+    if (rank == 0)
+    {
+        for (int q = 1; q < ranks; q++)
+            offsets[q] = offsets[q - 1] + counts[q - 1];
+
+        recvBuffer.resize(offsets[ranks - 1] + counts[ranks - 1]);
+    }
+
+    MPI_Gatherv(sendBuffer.data(), count, MPI_DOUBLE, recvBuffer.data(), counts.data(), offsets.data(), MPI_DOUBLE, 0,
+                world);
+
+    if (rank != 0)
+        return;
+
+    for (std::size_t a = 0; a < recvBuffer.size() / 4; a++)
+    {
+        const uint id = static_cast<uint>(recvBuffer[4 * a]);
+
+        for (uint k = 0; k < 3; k++)
+            out[k][id] = recvBuffer[4 * a + 1 + k];
+    }
+}
+
+/**************************************************************************************
+ * Sums the values over all ranks, every rank gets the sums.
+ * @param double* values of this rank, replaced by the sums,
+ * @param int number of values.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::sum(double *values, const int &count) const noexcept
+{
+    MPI_Allreduce(MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_SUM, world);
+}
+
+/**************************************************************************************
+ * Sums the counter over all ranks.
+ * @param uint64_t value of this rank.
+ * @return Sum over all ranks.
+ *************************************************************************************/
+uint64_t Domain::sum(const uint64_t &value) const noexcept
+{
+    uint64_t total = value;
+    MPI_Allreduce(MPI_IN_PLACE, &total, 1, MPI_UINT64_T, MPI_SUM, world);
+
+    return total;
+}
+
+/**************************************************************************************
+ * Checks if the flag is true on some rank, e.g. if some atom requires the rebuild of
+ * the neighbor list.
+ * @param bool flag of this rank.
+ * @return True if the flag is true on at least one rank.
+ *************************************************************************************/
+bool Domain::any(const bool &flag) const noexcept
+{
+    int value = flag;
+    MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_INT, MPI_LOR, world);
+
+    return value != 0;
+}
+
+/**************************************************************************************
+ * Largest value over all ranks, e.g. time of the slowest rank.
+ * @param double value of this rank.
+ * @return Maximum over all ranks.
+ *************************************************************************************/
+double Domain::slowest(const double &value) const noexcept
+{
+    double largest = value;
+    MPI_Allreduce(MPI_IN_PLACE, &largest, 1, MPI_DOUBLE, MPI_MAX, world);
+
+    return largest;
+}
+
+/**************************************************************************************
+ * Waits for all ranks of the run.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::barrier() const noexcept
+{
+    MPI_Barrier(world);
+}
+
+/**************************************************************************************
+ * Lower corner of the brick of this rank.
+ * @param double[3] corner.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::getLower(double (&corner)[3]) const noexcept
+{
+    for (uint k = 0; k < 3; k++)
+        corner[k] = low[k];
+}
+
+/**************************************************************************************
+ * Upper corner of the brick of this rank.
+ * @param double[3] corner.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Domain::getUpper(double (&corner)[3]) const noexcept
+{
+    for (uint k = 0; k < 3; k++)
+        corner[k] = high[k];
+}
+
+#endif // ARGON_MPI
@@ -0,0 +1,104 @@
+#ifndef DOMAIN_H
+#define DOMAIN_H
+#ifdef ARGON_MPI
+#include <mpi.h>
+#include <cstdint>
+#include <vector>
+#include "vectors.h"
+typedef unsigned int uint;
+
+/// Spatial domain decomposition of the periodic box over MPI ranks. Ranks form the
+/// Cartesian grid and every rank owns atoms in its brick of the box. Atoms which have
+/// left the brick migrate to the neighbouring rank and atoms closer than the halo
+/// (rc + skin) to a face are copied to the neighbour as ghosts. Both go in three stages
+/// (x, y and z) and ghosts of earlier stages are forwarded, so atoms reach neighbours
+/// across edges and corners without diagonal messages. Between builds of the neighbor
+/// list only positions of ghosts travel the same routes and their forces return in the
+/// reverse order (every pair is evaluated by a single rank). The brick is not smaller
+/// than the halo, so single hops are enough. As in `PeriodicBox` atoms keep unwrapped
+/// positions and image indices of the last exchange, which give their wrapped positions,
+/// so both runs see the same positions.
+class Domain
+{
+private:
+    /// Grid of ranks
+    MPI_Comm world;      ///< Communicator of the run
+    MPI_Comm cart;       ///< Periodic Cartesian communicator over `world`
+    int rank;            ///< Rank in `world`
+    int ranks;           ///< Number of ranks
+    int dims[3];         ///< Number of ranks along every axis
+    int coords[3];       ///< Position of this rank in the grid
+    int neighbor[3][2];  ///< Lower and upper neighbour along every axis
+    double edge[3];      ///< Edges of the whole box (centred at the origin)
+    double low[3];       ///< Lower corner of the brick
+    double high[3];      ///< Upper corner of the brick
+    double shift[6];     ///< Shift of ghosts sent in every stage (across the periodic border)
+    double halo;         ///< Thickness of the layer of ghosts
+
+    /// Atoms of the domain followed by ghosts
+    uint N;                ///< Number of atoms of the domain
+    uint M;                ///< Number of atoms and ghosts
+    Vectors u;             ///< Unwrapped positions of atoms (integrated)
+    Vectors images;        ///< Image indices of atoms of the last exchange
+    Vectors r;             ///< Wrapped positions of atoms and ghosts
+    Vectors p;             ///< Momenta of atoms
+    Vectors F;             ///< Forces of atoms and ghosts
+    std::vector<uint> ids; ///< Global ID of every atom and ghost
+
+    /// Routes of ghosts of the last exchange, stage 2 k + 0 goes down and 2 k + 1 up the axis k
+    std::vector<uint> sent[6]; ///< Atoms (or ghosts of earlier stages) sent in every stage
+    uint first[6];             ///< First ghost received in every stage
+    uint received[6];          ///< Number of ghosts received in every stage
+
+    std::vector<double> sendBuffer; ///< Packed atoms of the current message
+    std::vector<double> recvBuffer; ///< Packed atoms received in the current message
+
+    int cell(const uint &k, const double &x) const noexcept;
+    void reserve(const uint &count);
+    uint transfer(const int &dest, const int &source, const uint &width, const bool &known);
+
+public:
+    Domain() noexcept;
+    ~Domain() noexcept;
+
+    Domain(const Domain &) = delete;
+    Domain &operator=(const Domain &) = delete;
+
+    static void grid(const int &ranks, int (&dims)[3]) noexcept;
+
+    void attach(MPI_Comm comm);
+    void setup(const double (&edges)[3], const double &halo);
+    void clear() noexcept;
+    bool contains(const double (&x)[3]) const noexcept;
+    void add(const uint &id, const double (&x)[3], const double (&px)[3]);
+
+    void update() noexcept;
+    void migrate();
+    void exchange();
+    void forward();
+    double fold();
+    void gather(const Vectors &v, Vectors &out, const bool &wrap);
+
+    void sum(double *values, const int &count) const noexcept;
+    uint64_t sum(const uint64_t &value) const noexcept;
+    bool any(const bool &flag) const noexcept;
+    double slowest(const double &value) const noexcept;
+    void barrier() const noexcept;
+
+    void getLower(double (&corner)[3]) const noexcept;
+    void getUpper(double (&corner)[3]) const noexcept;
+
+    Vectors &unwrapped() noexcept { return u; }
+    Vectors &positions() noexcept { return r; }
+    Vectors &momenta() noexcept { return p; }
+    Vectors &forces() noexcept { return F; }
+    const uint *getIds() const noexcept { return ids.data(); }
+    uint size() const noexcept { return N; }
+    uint total() const noexcept { return M; }
+    int getRank() const noexcept { return rank; }
+    int getRanks() const noexcept { return ranks; }
+    int getDims(const uint &k) const noexcept { return dims[k]; }
+};
+
+#endif // ARGON_MPI
+#endif // DOMAIN_H
@@ -0,0 +1,259 @@
+#include "forces.h"
+#include <algorithm>
+#include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+PairForces::PairForces() noexcept : N(0), threads(1), kernels(selectKernels(Isa::Scalar)),
+                                    precision(Precision::Double), exactPp{}, cutPp{}, tabulated(false),
+                                    buffers(nullptr), partialV(nullptr)
+{
+}
+
+PairForces::~PairForces() noexcept
+{
+    delete[] buffers;
+    delete[] partialV;
+}
+
+/**************************************************************************************
+ * Selects pair kernels, prepares parameters of the potential (9) and allocates force
+ * buffers of threads.
+ * @param uint number of atoms,
+ * @param double minimum of the potential,
+ * @param double distance of the minimum of the potential,
+ * @param double cutoff radius of the truncated potential,
+ * @param Isa requested instruction set,
+ * @param uint number of threads (0 means all available),
+ * @param Precision precision of the kernels.
+ * @return Nothing to return.
+ *************************************************************************************/
+void PairForces::setup(const uint &NAtoms, const double &e, const double &R, const double &rc, const Isa &isa,
+                       const uint &nThreads, const Precision &kernelsPrecision)
+{
+    N = NAtoms;
+    kernels = selectKernels(isa);
+    precision = kernelsPrecision;
+
+    if (precision == Precision::Mixed)
+        rF.resize(N);
+
+#ifdef _OPENMP
+    threads = (nThreads == 0) ? omp_get_max_threads() : nThreads;
+#else
+    threads = 1;
+#endif
+    // More threads than atoms would only add empty buffers
+    threads = std::max(1u, std::min(threads, N));
+
+    const double y = R * R / (rc * rc);
+    const double x = y * y * y;
+
+    exactPp = {e, R * R, INFINITY, 0.};
+    cutPp = {e, R * R, rc * rc, e * x * (x - 2.)};
+    tabulated = false;
+
+    delete[] buffers;
+    delete[] partialV;
+
+    buffers = new Vectors[threads];
+    partialV = new double[threads]();
+
+    for (uint t = 1; t < threads; t++)
+        buffers[t].resize(N);
+}
+
+/**************************************************************************************
+ * Tabulates the truncated and shifted potential for the Verlet list kernels from
+ * r = 0.5 R to the cutoff. Closer pairs (never reached by thermal motion) use the
+ * analytic formula.
+ * @param uint number of intervals of the table.
+ * @return TableError with the largest errors of the table.
+ *************************************************************************************/
+TableError PairForces::tabulate(const uint &size)
+{
+    const double R = std::sqrt(cutPp.R2);
+    const PairPotential potential = lennardJones(cutPp.e, R, cutPp.Vc);
+
+    table.build(potential, 0.25 * cutPp.R2, cutPp.rc2, size);
+    table.setCore(cutPp);
+    tabulated = true;
+
+    return table.error(potential, cutPp.e, R);
+}
+
+/**************************************************************************************
+ * Resizes force buffers of threads and float positions for the given number of atoms
+ * and periodic images (ghosts get forces like atoms).
+ * @param uint number of entries of positions and forces.
+ * @return Nothing to return.
+ *************************************************************************************/
+void PairForces::reserve(const uint &size)
+{
+    for (uint t = 1; t < threads; t++)
+        if (buffers[t].size() != size)
+            buffers[t].resize(size);
+
+    if (precision == Precision::Mixed && rF.size() != size)
+        rF.resize(size);
+}
+
+/**************************************************************************************
+ * Evaluates rows of the pair matrix on all threads. Thread 0 adds forces directly to
+ * F, other threads to their own buffers which are then summed atom by atom (every
+ * thread sums its slice of entries of F). Partial sums are always added in the same
+ * order.
+ * @param Vectors forces to which pair forces are added,
+ * @param Range function (t, T, begin, end) giving rows of thread t out of T,
+ * @param Row function (F, i) evaluating row i and returning its potential.
+ * @return Potential energy of all pairs.
+ *************************************************************************************/
+template <typename Range, typename Row>
+double PairForces::evaluate(Vectors &F, Range range, Row row)
+{
+    uint used = 1;
+
+#pragma omp parallel num_threads(threads) if (threads > 1)
+    {
+#ifdef _OPENMP
+        const uint T = omp_get_num_threads();
+        const uint t = omp_get_thread_num();
+#else
+        const uint T = 1;
+        const uint t = 0;
+#endif
+        Vectors &Ft = (t == 0) ? F : buffers[t];
+
+        if (t == 0)
+            used = T;
+        else
+            Ft.zero();
+
+        uint begin, end;
+        range(t, T, begin, end);
+
+        double Vt = 0.;
+        for (uint i = begin; i < end; i++)
+            Vt += row(Ft, i);
+
+        partialV[t] = Vt;
+
+#pragma omp barrier
+
+        // Reduction of buffers, every thread sums its own slice of atoms
+        const uint first = static_cast<unsigned long long>(F.size()) * t / T;
+        const uint last = static_cast<unsigned long long>(F.size()) * (t + 1) / T;
+
+        for (uint q = 1; q < T; q++)
+        {
+            const Vectors &Fq = buffers[q];
+
+            for (uint i = first; i < last; i++)
+            {
+                F.x[i] += Fq.x[i];
+                F.y[i] += Fq.y[i];
+                F.z[i] += Fq.z[i];
+            }
+        }
+    }
+
+    double V = 0.;
+    for (uint t = 0; t < used; t++)
+        V += partialV[t];
+
+    return V;
+}
+
+/**************************************************************************************
+ * Calculates pair forces and potential between all pairs of atoms. Row i of the
+ * triangular matrix has i pairs, so the first i rows contain about i^2 / 2 pairs and
+ * thread t out of T gets rows from N sqrt(t / T) to N sqrt((t + 1) / T). Mixed
+ * precision kernels read positions rounded to float once per pass.
+ * @param Vectors positions of atoms,
+ * @param Vectors forces to which pair forces are added.
+ * @return Potential energy of all pairs.
+ *************************************************************************************/
+double PairForces::exact(const Vectors &r, Vectors &F)
+{
+    auto range = [this](const uint &t, const uint &T, uint &begin, uint &end)
+    {
+        begin = std::lround(N * std::sqrt(static_cast<double>(t) / T));
+        end = std::lround(N * std::sqrt(static_cast<double>(t + 1) / T));
+    };
+
+    if (precision == Precision::Mixed)
+    {
+        rF.assign(r);
+
+        auto rowMixed = [this](Vectors &Ft, const uint &i)
+        {
+            return kernels.rowMixed(rF, Ft, i, i, exactPp);
+        };
+
+        return evaluate(F, range, rowMixed);
+    }
+
+    auto row = [this, &r](Vectors &Ft, const uint &i)
+    {
+        return kernels.row(r, Ft, i, i, exactPp);
+    };
+
+    return evaluate(F, range, row);
+}
+
+/**************************************************************************************
+ * Calculates pair forces and truncated potential between neighbours from the list.
+ * Thread t out of T gets rows which contain entries of the list from t / T to
+ * (t + 1) / T of its length. Positions and forces may continue with periodic images
+ * of atoms (neighbours of the periodic box) or ghosts from other domains, rows are
+ * only atoms 0 ... N - 1 of the list.
+ * @param Vectors positions of atoms (and ghosts),
+ * @param Vectors forces to which pair forces are added (of the same size as r),
+ * @param NeighborList up-to-date list of neighbours.
+ * @return Potential energy of all pairs.
+ *************************************************************************************/
+double PairForces::list(const Vectors &r, Vectors &F, const NeighborList &neighbors)
+{
+    const uint *offsets = neighbors.offsets();
+    const uint *list = neighbors.neighbors();
+    const uint rows = neighbors.getRows();
+
+    reserve(F.size());
+
+    auto range = [offsets, rows](const uint &t, const uint &T, uint &begin, uint &end)
+    {
+        const unsigned long long size = offsets[rows];
+        begin = (t == 0) ? 0 : std::lower_bound(offsets, offsets + rows, size * t / T) - offsets;
+        end = (t + 1 == T) ? rows : std::lower_bound(offsets, offsets + rows, size * (t + 1) / T) - offsets;
+    };
+
+    if (tabulated)
+    {
+        auto rowTable = [this, &r, offsets, list](Vectors &Ft, const uint &i)
+        {
+            return kernels.listTable(r, Ft, i, list + offsets[i], offsets[i + 1] - offsets[i], table);
+        };
+
+        return evaluate(F, range, rowTable);
+    }
+
+    if (precision == Precision::Mixed)
+    {
+        rF.assign(r);
+
+        auto rowMixed = [this, offsets, list](Vectors &Ft, const uint &i)
+        {
+            return kernels.listMixed(rF, Ft, i, list + offsets[i], offsets[i + 1] - offsets[i], cutPp);
+        };
+
+        return evaluate(F, range, rowMixed);
+    }
+
+    auto row = [this, &r, offsets, list](Vectors &Ft, const uint &i)
+    {
+        return kernels.list(r, Ft, i, list + offsets[i], offsets[i + 1] - offsets[i], cutPp);
+    };
+
+    return evaluate(F, range, row);
+}
@@ -0,0 +1,54 @@
+#ifndef FORCES_H
+#define FORCES_H
+#include "vectors.h"
+#include "kernels.h"
+#include "neighbors.h"
+#include "table.h"
+typedef unsigned int uint;
+
+/// Pair forces (9) and (13) evaluated by the SIMD kernels on several threads.
+/// Because of the Newton's third law every pair updates two atoms, so every thread
+/// accumulates forces in its own buffer and buffers are summed afterwards in a fixed
+/// order (the result does not depend on timing). Rows of the pair matrix are split
+/// between threads so that every thread gets the same number of pairs.
+class PairForces
+{
+private:
+    uint N;              ///< Number of atoms
+    uint threads;        ///< Number of threads
+    PairKernels kernels; ///< Pair kernels selected at runtime
+    Precision precision; ///< Precision of the pair kernels
+    VectorsF rF;         ///< Positions rounded to float (mixed precision)
+    PairParams exactPp;  ///< Parameters of the full potential
+    PairParams cutPp;    ///< Parameters of the truncated and shifted potential
+    PairTable table;     ///< Tabulated truncated and shifted potential
+    bool tabulated;      ///< Verlet list kernels read the potential from the table
+    Vectors *buffers;    ///< Force buffers of threads 1, 2, ... (thread 0 writes directly)
+    double *partialV;    ///< Potential energy of every thread
+
+    void reserve(const uint &size);
+
+    template <typename Range, typename Row>
+    double evaluate(Vectors &F, Range range, Row row);
+
+public:
+    PairForces() noexcept;
+    ~PairForces() noexcept;
+
+    PairForces(const PairForces &) = delete;
+    PairForces &operator=(const PairForces &) = delete;
+
+    void setup(const uint &N, const double &e, const double &R, const double &rc, const Isa &isa, const uint &threads,
+               const Precision &precision);
+    TableError tabulate(const uint &size);
+    double exact(const Vectors &r, Vectors &F);
+    double list(const Vectors &r, Vectors &F, const NeighborList &neighbors);
+
+    Isa getIsa() const noexcept { return kernels.isa; }
+    Precision getPrecision() const noexcept { return precision; }
+    uint getThreads() const noexcept { return threads; }
+    double getVc() const noexcept { return cutPp.Vc; }
+    const PairTable &getTable() const noexcept { return table; }
+};
+
+#endif // FORCES_H
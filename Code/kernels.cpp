@@ -0,0 +1,1092 @@
+#include "kernels.h"
+#include "table.h"
+#include <immintrin.h>
+
+namespace
+{
+    /**************************************************************************************
+     * Lennard-Jones interaction (9) and (13) of a single pair written with r^2 only:
+     * x = (R / r)^6 = (R^2 / r^2)^3, V = e x (x - 2), F = 12 e x (x - 1) / r^2 * (r_i - r_j).
+     * @return Potential of the pair, `Fr` is set to the force divided by the distance.
+     *************************************************************************************/
+    inline double pairScalar(const double &r2, const PairParams &pp, double &Fr) noexcept
+    {
+        if (r2 >= pp.rc2)
+        {
+            Fr = 0.;
+            return 0.;
+        }
+
+        const double inv = 1. / r2;
+        const double y = pp.R2 * inv;
+        const double x = y * y * y;
+
+        Fr = 12. * pp.e * x * (x - 1.) * inv;
+        return pp.e * x * (x - 2.) - pp.Vc;
+    }
+
+    double rowScalar(const Vectors &r, Vectors &F, const uint &i, const uint &count, const PairParams &pp)
+    {
+        const double xi = r.x[i];
+        const double yi = r.y[i];
+        const double zi = r.z[i];
+
+        double Fx = 0., Fy = 0., Fz = 0., V = 0.;
+
+        for (uint j = 0; j < count; j++)
+        {
+            const double dx = xi - r.x[j];
+            const double dy = yi - r.y[j];
+            const double dz = zi - r.z[j];
+
+            double Fr;
+            V += pairScalar(dx * dx + dy * dy + dz * dz, pp, Fr);
+
+            Fx += Fr * dx;
+            Fy += Fr * dy;
+            Fz += Fr * dz;
+            F.x[j] -= Fr * dx;
+            F.y[j] -= Fr * dy;
+            F.z[j] -= Fr * dz;
+        }
+
+        F.x[i] += Fx;
+        F.y[i] += Fy;
+        F.z[i] += Fz;
+
+        return V;
+    }
+
+    double listScalar(const Vectors &r, Vectors &F, const uint &i, const uint *js, const uint &count, const PairParams &pp)
+    {
+        const double xi = r.x[i];
+        const double yi = r.y[i];
+        const double zi = r.z[i];
+
+        double Fx = 0., Fy = 0., Fz = 0., V = 0.;
+
+        for (uint l = 0; l < count; l++)
+        {
+            const uint j = js[l];
+            const double dx = xi - r.x[j];
+            const double dy = yi - r.y[j];
+            const double dz = zi - r.z[j];
+
+            double Fr;
+            V += pairScalar(dx * dx + dy * dy + dz * dz, pp, Fr);
+
+            Fx += Fr * dx;
+            Fy += Fr * dy;
+            Fz += Fr * dz;
+            F.x[j] -= Fr * dx;
+            F.y[j] -= Fr * dy;
+            F.z[j] -= Fr * dz;
+        }
+
+        F.x[i] += Fx;
+        F.y[i] += Fy;
+        F.z[i] += Fz;
+
+        return V;
+    }
+
+    // * * * * * * * * * * * * * * * * * * AVX2 * * * * * * * * * * * * * * * * * * //
+
+    __attribute__((target("avx2,fma"))) inline double reduceAVX2(const __m256d &v) noexcept
+    {
+        const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    }
+
+    /// Four pairs at once. Returns the potential and sets `Fr` (force divided by distance).
+    __attribute__((target("avx2,fma"))) inline __m256d pairAVX2(const __m256d &r2, const PairParams &pp, __m256d &Fr) noexcept
+    {
+        const __m256d mask = _mm256_cmp_pd(r2, _mm256_set1_pd(pp.rc2), _CMP_LT_OQ);
+        const __m256d inv = _mm256_div_pd(_mm256_set1_pd(1.), r2);
+        const __m256d y = _mm256_mul_pd(_mm256_set1_pd(pp.R2), inv);
+        const __m256d x = _mm256_mul_pd(_mm256_mul_pd(y, y), y);
+        const __m256d ex = _mm256_mul_pd(_mm256_set1_pd(pp.e), x);
+
+        Fr = _mm256_and_pd(mask, _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(12.), ex),
+                                               _mm256_mul_pd(_mm256_sub_pd(x, _mm256_set1_pd(1.)), inv)));
+
+        return _mm256_and_pd(mask, _mm256_fmsub_pd(ex, _mm256_sub_pd(x, _mm256_set1_pd(2.)), _mm256_set1_pd(pp.Vc)));
+    }
+
+    __attribute__((target("avx2,fma"))) double rowAVX2(const Vectors &r, Vectors &F, const uint &i, const uint &count,
+                                                       const PairParams &pp)
+    {
+        const __m256d xi = _mm256_set1_pd(r.x[i]);
+        const __m256d yi = _mm256_set1_pd(r.y[i]);
+        const __m256d zi = _mm256_set1_pd(r.z[i]);
+
+        __m256d Fx = _mm256_setzero_pd(), Fy = _mm256_setzero_pd(), Fz = _mm256_setzero_pd(), V = _mm256_setzero_pd();
+
+        uint j = 0;
+
+        // Arrays are aligned and j is a multiple of 4, so aligned loads and stores are used
+        for (; j + 4 <= count; j += 4)
+        {
+            const __m256d dx = _mm256_sub_pd(xi, _mm256_load_pd(r.x + j));
+            const __m256d dy = _mm256_sub_pd(yi, _mm256_load_pd(r.y + j));
+            const __m256d dz = _mm256_sub_pd(zi, _mm256_load_pd(r.z + j));
+            const __m256d r2 = _mm256_fmadd_pd(dz, dz, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dx, dx)));
+
+            __m256d Fr;
+            V = _mm256_add_pd(V, pairAVX2(r2, pp, Fr));
+
+            const __m256d fx = _mm256_mul_pd(Fr, dx);
+            const __m256d fy = _mm256_mul_pd(Fr, dy);
+            const __m256d fz = _mm256_mul_pd(Fr, dz);
+
+            Fx = _mm256_add_pd(Fx, fx);
+            Fy = _mm256_add_pd(Fy, fy);
+            Fz = _mm256_add_pd(Fz, fz);
+            _mm256_store_pd(F.x + j, _mm256_sub_pd(_mm256_load_pd(F.x + j), fx));
+            _mm256_store_pd(F.y + j, _mm256_sub_pd(_mm256_load_pd(F.y + j), fy));
+            _mm256_store_pd(F.z + j, _mm256_sub_pd(_mm256_load_pd(F.z + j), fz));
+        }
+
+        double Vi = reduceAVX2(V);
+        double Fxi = reduceAVX2(Fx), Fyi = reduceAVX2(Fy), Fzi = reduceAVX2(Fz);
+
+        // Remaining pairs
+        for (; j < count; j++)
+        {
+            const double dx = r.x[i] - r.x[j];
+            const double dy = r.y[i] - r.y[j];
+            const double dz = r.z[i] - r.z[j];
+
+            double Fr;
+            Vi += pairScalar(dx * dx + dy * dy + dz * dz, pp, Fr);
+
+            Fxi += Fr * dx;
+            Fyi += Fr * dy;
+            Fzi += Fr * dz;
+            F.x[j] -= Fr * dx;
+            F.y[j] -= Fr * dy;
+            F.z[j] -= Fr * dz;
+        }
+
+        F.x[i] += Fxi;
+        F.y[i] += Fyi;
+        F.z[i] += Fzi;
+
+        return Vi;
+    }
+
+    __attribute__((target("avx2,fma"))) double listAVX2(const Vectors &r, Vectors &F, const uint &i, const uint *js,
+                                                        const uint &count, const PairParams &pp)
+    {
+        const __m256d xi = _mm256_set1_pd(r.x[i]);
+        const __m256d yi = _mm256_set1_pd(r.y[i]);
+        const __m256d zi = _mm256_set1_pd(r.z[i]);
+
+        __m256d Fx = _mm256_setzero_pd(), Fy = _mm256_setzero_pd(), Fz = _mm256_setzero_pd(), V = _mm256_setzero_pd();
+        alignas(32) double fx[4], fy[4], fz[4];
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+        uint l = 0;
+
+        for (; l + 4 <= count; l += 4)
+        {
+            // Neighbours are scattered in memory, so their positions are gathered
+            const __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(js + l));
+            const __m256d dx = _mm256_sub_pd(xi, _mm256_mask_i32gather_pd(zero, r.x, idx, all, 8));
+            const __m256d dy = _mm256_sub_pd(yi, _mm256_mask_i32gather_pd(zero, r.y, idx, all, 8));
+            const __m256d dz = _mm256_sub_pd(zi, _mm256_mask_i32gather_pd(zero, r.z, idx, all, 8));
+            const __m256d r2 = _mm256_fmadd_pd(dz, dz, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dx, dx)));
+
+            __m256d Fr;
+            V = _mm256_add_pd(V, pairAVX2(r2, pp, Fr));
+
+            const __m256d Fpx = _mm256_mul_pd(Fr, dx);
+            const __m256d Fpy = _mm256_mul_pd(Fr, dy);
+            const __m256d Fpz = _mm256_mul_pd(Fr, dz);
+
+            Fx = _mm256_add_pd(Fx, Fpx);
+            Fy = _mm256_add_pd(Fy, Fpy);
+            Fz = _mm256_add_pd(Fz, Fpz);
+
+            // AVX2 has no scatter, neighbours of a single atom are distinct so the order does not matter
+            _mm256_store_pd(fx, Fpx);
+            _mm256_store_pd(fy, Fpy);
+            _mm256_store_pd(fz, Fpz);
+
+            for (uint q = 0; q < 4; q++)
+            {
+                const uint j = js[l + q];
+                F.x[j] -= fx[q];
+                F.y[j] -= fy[q];
+                F.z[j] -= fz[q];
+            }
+        }
+
+        double Vi = reduceAVX2(V);
+        double Fxi = reduceAVX2(Fx), Fyi = reduceAVX2(Fy), Fzi = reduceAVX2(Fz);
+
+        for (; l < count; l++)
+        {
+            const uint j = js[l];
+            const double dx = r.x[i] - r.x[j];
+            const double dy = r.y[i] - r.y[j];
+            const double dz = r.z[i] - r.z[j];
+
+            double Fr;
+            Vi += pairScalar(dx * dx + dy * dy + dz * dz, pp, Fr);
+
+            Fxi += Fr * dx;
+            Fyi += Fr * dy;
+            Fzi += Fr * dz;
+            F.x[j] -= Fr * dx;
+            F.y[j] -= Fr * dy;
+            F.z[j] -= Fr * dz;
+        }
+
+        F.x[i] += Fxi;
+        F.y[i] += Fyi;
+        F.z[i] += Fzi;
+
+        return Vi;
+    }
+
+    // * * * * * * * * * * * * * * * * * * AVX-512 * * * * * * * * * * * * * * * * * //
+
+    __attribute__((target("avx512f"))) inline double reduceAVX512(const __m512d &v) noexcept
+    {
+        // Pairwise sum of lanes, done once per atom i so the store does not matter
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, v);
+        return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+    }
+
+    /// Eight pairs at once, lanes outside of `active` give zero.
+    __attribute__((target("avx512f"))) inline __m512d pairAVX512(const __m512d &r2, const __mmask8 &active, const PairParams &pp,
+                                                                __m512d &Fr) noexcept
+    {
+        const __mmask8 mask = _mm512_mask_cmp_pd_mask(active, r2, _mm512_set1_pd(pp.rc2), _CMP_LT_OQ);
+        const __m512d inv = _mm512_maskz_div_pd(mask, _mm512_set1_pd(1.), r2);
+        const __m512d y = _mm512_mul_pd(_mm512_set1_pd(pp.R2), inv);
+        const __m512d x = _mm512_mul_pd(_mm512_mul_pd(y, y), y);
+        const __m512d ex = _mm512_mul_pd(_mm512_set1_pd(pp.e), x);
+
+        Fr = _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(12.), ex), _mm512_mul_pd(_mm512_sub_pd(x, _mm512_set1_pd(1.)), inv));
+
+        return _mm512_maskz_mov_pd(mask, _mm512_fmsub_pd(ex, _mm512_sub_pd(x, _mm512_set1_pd(2.)), _mm512_set1_pd(pp.Vc)));
+    }
+
+    __attribute__((target("avx512f"))) double rowAVX512(const Vectors &r, Vectors &F, const uint &i, const uint &count,
+                                                        const PairParams &pp)
+    {
+        const __m512d xi = _mm512_set1_pd(r.x[i]);
+        const __m512d yi = _mm512_set1_pd(r.y[i]);
+        const __m512d zi = _mm512_set1_pd(r.z[i]);
+
+        __m512d Fx = _mm512_setzero_pd(), Fy = _mm512_setzero_pd(), Fz = _mm512_setzero_pd(), V = _mm512_setzero_pd();
+
+        // The tail is handled by masked loads and stores, so there is no scalar loop
+        for (uint j = 0; j < count; j += 8)
+        {
+            const __mmask8 active = (count - j >= 8) ? 0xFF : static_cast<__mmask8>((1u << (count - j)) - 1u);
+
+            const __m512d dx = _mm512_sub_pd(xi, _mm512_maskz_load_pd(active, r.x + j));
+            const __m512d dy = _mm512_sub_pd(yi, _mm512_maskz_load_pd(active, r.y + j));
+            const __m512d dz = _mm512_sub_pd(zi, _mm512_maskz_load_pd(active, r.z + j));
+            const __m512d r2 = _mm512_fmadd_pd(dz, dz, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dx, dx)));
+
+            __m512d Fr;
+            V = _mm512_add_pd(V, pairAVX512(r2, active, pp, Fr));
+
+            const __m512d fx = _mm512_mul_pd(Fr, dx);
+            const __m512d fy = _mm512_mul_pd(Fr, dy);
+            const __m512d fz = _mm512_mul_pd(Fr, dz);
+
+            Fx = _mm512_add_pd(Fx, fx);
+            Fy = _mm512_add_pd(Fy, fy);
+            Fz = _mm512_add_pd(Fz, fz);
+            _mm512_mask_store_pd(F.x + j, active, _mm512_sub_pd(_mm512_maskz_load_pd(active, F.x + j), fx));
+            _mm512_mask_store_pd(F.y + j, active, _mm512_sub_pd(_mm512_maskz_load_pd(active, F.y + j), fy));
+            _mm512_mask_store_pd(F.z + j, active, _mm512_sub_pd(_mm512_maskz_load_pd(active, F.z + j), fz));
+        }
+
+        F.x[i] += reduceAVX512(Fx);
+        F.y[i] += reduceAVX512(Fy);
+        F.z[i] += reduceAVX512(Fz);
+
+        return reduceAVX512(V);
+    }
+
+    __attribute__((target("avx512f"))) double listAVX512(const Vectors &r, Vectors &F, const uint &i, const uint *js,
+                                                         const uint &count, const PairParams &pp)
+    {
+        const __m512d xi = _mm512_set1_pd(r.x[i]);
+        const __m512d yi = _mm512_set1_pd(r.y[i]);
+        const __m512d zi = _mm512_set1_pd(r.z[i]);
+
+        __m512d Fx = _mm512_setzero_pd(), Fy = _mm512_setzero_pd(), Fz = _mm512_setzero_pd(), V = _mm512_setzero_pd();
+
+        alignas(32) uint tail[8];
+
+        for (uint l = 0; l < count; l += 8)
+        {
+            const __mmask8 active = (count - l >= 8) ? 0xFF : static_cast<__mmask8>((1u << (count - l)) - 1u);
+
+            // Indices of the last incomplete block are copied, so nothing is read past the list
+            if (active != 0xFF)
+            {
+                for (uint q = 0; q < 8; q++)
+                    tail[q] = (l + q < count) ? js[l + q] : 0;
+            }
+
+            const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(active == 0xFF ? js + l : tail));
+
+            const __m512d dx = _mm512_sub_pd(xi, _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, r.x, 8));
+            const __m512d dy = _mm512_sub_pd(yi, _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, r.y, 8));
+            const __m512d dz = _mm512_sub_pd(zi, _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, r.z, 8));
+            const __m512d r2 = _mm512_fmadd_pd(dz, dz, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dx, dx)));
+
+            __m512d Fr;
+            V = _mm512_add_pd(V, pairAVX512(r2, active, pp, Fr));
+
+            const __m512d fx = _mm512_mul_pd(Fr, dx);
+            const __m512d fy = _mm512_mul_pd(Fr, dy);
+            const __m512d fz = _mm512_mul_pd(Fr, dz);
+
+            Fx = _mm512_add_pd(Fx, fx);
+            Fy = _mm512_add_pd(Fy, fy);
+            Fz = _mm512_add_pd(Fz, fz);
+
+            // Neighbours of a single atom are distinct, so the scatter has no conflicts
+            const __m512d Fjx = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, F.x, 8);
+            const __m512d Fjy = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, F.y, 8);
+            const __m512d Fjz = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, F.z, 8);
+            _mm512_mask_i32scatter_pd(F.x, active, idx, _mm512_sub_pd(Fjx, fx), 8);
+            _mm512_mask_i32scatter_pd(F.y, active, idx, _mm512_sub_pd(Fjy, fy), 8);
+            _mm512_mask_i32scatter_pd(F.z, active, idx, _mm512_sub_pd(Fjz, fz), 8);
+        }
+
+        F.x[i] += reduceAVX512(Fx);
+        F.y[i] += reduceAVX512(Fy);
+        F.z[i] += reduceAVX512(Fz);
+
+        return reduceAVX512(V);
+    }
+
+    // * * * * * * * * * * * * * * * * * Mixed precision * * * * * * * * * * * * * * * * //
+    // Distances and Lennard-Jones terms are evaluated in float from positions rounded to
+    // float, every pair contribution is converted to double before it is summed, so sums
+    // over many pairs do not lose precision.
+
+    /// Parameters of the potential rounded to float
+    struct PairParamsF
+    {
+        float e;
+        float R2;
+        float rc2;
+        float Vc;
+
+        explicit PairParamsF(const PairParams &pp) noexcept : e(pp.e), R2(pp.R2), rc2(pp.rc2), Vc(pp.Vc) {}
+    };
+
+    inline float pairScalarMixed(const float &r2, const PairParamsF &pp, float &Fr) noexcept
+    {
+        if (r2 >= pp.rc2)
+        {
+            Fr = 0.f;
+            return 0.f;
+        }
+
+        const float inv = 1.f / r2;
+        const float y = pp.R2 * inv;
+        const float x = y * y * y;
+
+        Fr = 12.f * pp.e * x * (x - 1.f) * inv;
+        return pp.e * x * (x - 2.f) - pp.Vc;
+    }
+
+    /// Pair of atoms i and j: adds the force to (Fx, Fy, Fz), subtracts it from atom j
+    inline double pairMixed(const VectorsF &r, Vectors &F, const uint &i, const uint &j, const PairParamsF &pp, double &Fx,
+                            double &Fy, double &Fz) noexcept
+    {
+        const float dx = r.x[i] - r.x[j];
+        const float dy = r.y[i] - r.y[j];
+        const float dz = r.z[i] - r.z[j];
+
+        float Fr;
+        const double V = pairScalarMixed(dx * dx + dy * dy + dz * dz, pp, Fr);
+
+        const double fx = Fr * dx;
+        const double fy = Fr * dy;
+        const double fz = Fr * dz;
+
+        Fx += fx;
+        Fy += fy;
+        Fz += fz;
+        F.x[j] -= fx;
+        F.y[j] -= fy;
+        F.z[j] -= fz;
+
+        return V;
+    }
+
+    double rowScalarMixed(const VectorsF &r, Vectors &F, const uint &i, const uint &count, const PairParams &pp)
+    {
+        const PairParamsF ppf(pp);
+        double Fx = 0., Fy = 0., Fz = 0., V = 0.;
+
+        for (uint j = 0; j < count; j++)
+            V += pairMixed(r, F, i, j, ppf, Fx, Fy, Fz);
+
+        F.x[i] += Fx;
+        F.y[i] += Fy;
+        F.z[i] += Fz;
+
+        return V;
+    }
+
+    double listScalarMixed(const VectorsF &r, Vectors &F, const uint &i, const uint *js, const uint &count,
+                           const PairParams &pp)
+    {
+        const PairParamsF ppf(pp);
+        double Fx = 0., Fy = 0., Fz = 0., V = 0.;
+
+        for (uint l = 0; l < count; l++)
+            V += pairMixed(r, F, i, js[l], ppf, Fx, Fy, Fz);
+
+        F.x[i] += Fx;
+        F.y[i] += Fy;
+        F.z[i] += Fz;
+
+        return V;
+    }
+
+    /// Lower and upper four lanes converted to double
+    __attribute__((target("avx2,fma"))) inline __m256d lowAVX2(const __m256 &v) noexcept
+    {
+        return _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+    }
+
+    __attribute__((target("avx2,fma"))) inline __m256d highAVX2(const __m256 &v) noexcept
+    {
+        return _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+    }
+
+    /// Eight pairs at once in float
+    __attribute__((target("avx2,fma"))) inline __m256 pairAVX2Mixed(const __m256 &r2, const PairParamsF &pp, __m256 &Fr) noexcept
+    {
+        const __m256 mask = _mm256_cmp_ps(r2, _mm256_set1_ps(pp.rc2), _CMP_LT_OQ);
+        const __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.f), r2);
+        const __m256 y = _mm256_mul_ps(_mm256_set1_ps(pp.R2), inv);
+        const __m256 x = _mm256_mul_ps(_mm256_mul_ps(y, y), y);
+        const __m256 ex = _mm256_mul_ps(_mm256_set1_ps(pp.e), x);
+
+        Fr = _mm256_and_ps(mask, _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(12.f), ex),
+                                               _mm256_mul_ps(_mm256_sub_ps(x, _mm256_set1_ps(1.f)), inv)));
+
+        return _mm256_and_ps(mask, _mm256_fmsub_ps(ex, _mm256_sub_ps(x, _mm256_set1_ps(2.f)), _mm256_set1_ps(pp.Vc)));
+    }
+
+    __attribute__((target("avx2,fma"))) double rowAVX2Mixed(const VectorsF &r, Vectors &F, const uint &i, const uint &count,
+                                                            const PairParams &pp)
+    {
+        const PairParamsF ppf(pp);
+        const __m256 xi = _mm256_set1_ps(r.x[i]);
+        const __m256 yi = _mm256_set1_ps(r.y[i]);
+        const __m256 zi = _mm256_set1_ps(r.z[i]);
+
+        __m256d Fx = _mm256_setzero_pd(), Fy = _mm256_setzero_pd(), Fz = _mm256_setzero_pd(), V = _mm256_setzero_pd();
+
+        uint j = 0;
+
+        for (; j + 8 <= count; j += 8)
+        {
+            const __m256 dx = _mm256_sub_ps(xi, _mm256_load_ps(r.x + j));
+            const __m256 dy = _mm256_sub_ps(yi, _mm256_load_ps(r.y + j));
+            const __m256 dz = _mm256_sub_ps(zi, _mm256_load_ps(r.z + j));
+            const __m256 r2 = _mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)));
+
+            __m256 Fr;
+            const __m256 Vp = pairAVX2Mixed(r2, ppf, Fr);
+            V = _mm256_add_pd(V, _mm256_add_pd(lowAVX2(Vp), highAVX2(Vp)));
+
+            const __m256 fx = _mm256_mul_ps(Fr, dx);
+            const __m256 fy = _mm256_mul_ps(Fr, dy);
+            const __m256 fz = _mm256_mul_ps(Fr, dz);
+            const __m256d fx0 = lowAVX2(fx), fx1 = highAVX2(fx);
+            const __m256d fy0 = lowAVX2(fy), fy1 = highAVX2(fy);
+            const __m256d fz0 = lowAVX2(fz), fz1 = highAVX2(fz);
+
+            Fx = _mm256_add_pd(Fx, _mm256_add_pd(fx0, fx1));
+            Fy = _mm256_add_pd(Fy, _mm256_add_pd(fy0, fy1));
+            Fz = _mm256_add_pd(Fz, _mm256_add_pd(fz0, fz1));
+            _mm256_store_pd(F.x + j, _mm256_sub_pd(_mm256_load_pd(F.x + j), fx0));
+            _mm256_store_pd(F.x + j + 4, _mm256_sub_pd(_mm256_load_pd(F.x + j + 4), fx1));
+            _mm256_store_pd(F.y + j, _mm256_sub_pd(_mm256_load_pd(F.y + j), fy0));
+            _mm256_store_pd(F.y + j + 4, _mm256_sub_pd(_mm256_load_pd(F.y + j + 4), fy1));
+            _mm256_store_pd(F.z + j, _mm256_sub_pd(_mm256_load_pd(F.z + j), fz0));
+            _mm256_store_pd(F.z + j + 4, _mm256_sub_pd(_mm256_load_pd(F.z + j + 4), fz1));
+        }
+
+        double Vi = reduceAVX2(V);
+        double Fxi = reduceAVX2(Fx), Fyi = reduceAVX2(Fy), Fzi = reduceAVX2(Fz);
+
+        for (; j < count; j++)
+            Vi += pairMixed(r, F, i, j, ppf, Fxi, Fyi, Fzi);
+
+        F.x[i] += Fxi;
+        F.y[i] += Fyi;
+        F.z[i] += Fzi;
+
+        return Vi;
+    }
+
+    __attribute__((target("avx2,fma"))) double listAVX2Mixed(const VectorsF &r, Vectors &F, const uint &i, const uint *js,
+                                                             const uint &count, const PairParams &pp)
+    {
+        const PairParamsF ppf(pp);
+        const __m256 xi = _mm256_set1_ps(r.x[i]);
+        const __m256 yi = _mm256_set1_ps(r.y[i]);
+        const __m256 zi = _mm256_set1_ps(r.z[i]);
+
+        __m256d Fx = _mm256_setzero_pd(), Fy = _mm256_setzero_pd(), Fz = _mm256_setzero_pd(), V = _mm256_setzero_pd();
+        alignas(32) float fx[8], fy[8], fz[8];
+
+        uint l = 0;
+
+        for (; l + 8 <= count; l += 8)
+        {
+            const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(js + l));
+            const __m256 dx = _mm256_sub_ps(xi, _mm256_i32gather_ps(r.x, idx, 4));
+            const __m256 dy = _mm256_sub_ps(yi, _mm256_i32gather_ps(r.y, idx, 4));
+            const __m256 dz = _mm256_sub_ps(zi, _mm256_i32gather_ps(r.z, idx, 4));
+            const __m256 r2 = _mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)));
+
+            __m256 Fr;
+            const __m256 Vp = pairAVX2Mixed(r2, ppf, Fr);
+            V = _mm256_add_pd(V, _mm256_add_pd(lowAVX2(Vp), highAVX2(Vp)));
+
+            const __m256 Fpx = _mm256_mul_ps(Fr, dx);
+            const __m256 Fpy = _mm256_mul_ps(Fr, dy);
+            const __m256 Fpz = _mm256_mul_ps(Fr, dz);
+
+            Fx = _mm256_add_pd(Fx, _mm256_add_pd(lowAVX2(Fpx), highAVX2(Fpx)));
+            Fy = _mm256_add_pd(Fy, _mm256_add_pd(lowAVX2(Fpy), highAVX2(Fpy)));
+            Fz = _mm256_add_pd(Fz, _mm256_add_pd(lowAVX2(Fpz), highAVX2(Fpz)));
+
+            _mm256_store_ps(fx, Fpx);
+            _mm256_store_ps(fy, Fpy);
+            _mm256_store_ps(fz, Fpz);
+
+            for (uint q = 0; q < 8; q++)
+            {
+                const uint j = js[l + q];
+                F.x[j] -= fx[q];
+                F.y[j] -= fy[q];
+                F.z[j] -= fz[q];
+            }
+        }
+
+        double Vi = reduceAVX2(V);
+        double Fxi = reduceAVX2(Fx), Fyi = reduceAVX2(Fy), Fzi = reduceAVX2(Fz);
+
+        for (; l < count; l++)
+            Vi += pairMixed(r, F, i, js[l], ppf, Fxi, Fyi, Fzi);
+
+        F.x[i] += Fxi;
+        F.y[i] += Fyi;
+        F.z[i] += Fzi;
+
+        return Vi;
+    }
+
+    /// Lower and upper eight lanes converted to double (zero-masked forms avoid false warnings of GCC
+    /// about undefined sources of casts)
+    __attribute__((target("avx512f"))) inline __m512d lowAVX512(const __m512 &v) noexcept
+    {
+        return _mm512_maskz_cvtps_pd(0xFF, _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xFF, _mm512_castps_pd(v), 0)));
+    }
+
+    __attribute__((target("avx512f"))) inline __m512d highAVX512(const __m512 &v) noexcept
+    {
+        return _mm512_maskz_cvtps_pd(0xFF, _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xFF, _mm512_castps_pd(v), 1)));
+    }
+
+    /// Sixteen pairs at once in float, lanes outside of `active` give zero
+    __attribute__((target("avx512f"))) inline __m512 pairAVX512Mixed(const __m512 &r2, const __mmask16 &active,
+                                                                    const PairParamsF &pp, __m512 &Fr) noexcept
+    {
+        const __mmask16 mask = _mm512_mask_cmp_ps_mask(active, r2, _mm512_set1_ps(pp.rc2), _CMP_LT_OQ);
+        const __m512 inv = _mm512_maskz_div_ps(mask, _mm512_set1_ps(1.f), r2);
+        const __m512 y = _mm512_mul_ps(_mm512_set1_ps(pp.R2), inv);
+        const __m512 x = _mm512_mul_ps(_mm512_mul_ps(y, y), y);
+        const __m512 ex = _mm512_mul_ps(_mm512_set1_ps(pp.e), x);
+
+        Fr = _mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(12.f), ex), _mm512_mul_ps(_mm512_sub_ps(x, _mm512_set1_ps(1.f)), inv));
+
+        return _mm512_maskz_mov_ps(mask, _mm512_fmsub_ps(ex, _mm512_sub_ps(x, _mm512_set1_ps(2.f)), _mm512_set1_ps(pp.Vc)));
+    }
+
+    __attribute__((target("avx512f"))) double rowAVX512Mixed(const VectorsF &r, Vectors &F, const uint &i, const uint &count,
+                                                             const PairParams &pp)
+    {
+        const PairParamsF ppf(pp);
+        const __m512 xi = _mm512_set1_ps(r.x[i]);
+        const __m512 yi = _mm512_set1_ps(r.y[i]);
+        const __m512 zi = _mm512_set1_ps(r.z[i]);
+
+        __m512d Fx = _mm512_setzero_pd(), Fy = _mm512_setzero_pd(), Fz = _mm512_setzero_pd(), V = _mm512_setzero_pd();
+
+        for (uint j = 0; j < count; j += 16)
+        {
+            const __mmask16 active = (count - j >= 16) ? 0xFFFF : static_cast<__mmask16>((1u << (count - j)) - 1u);
+            const __mmask8 active0 = static_cast<__mmask8>(active);
+            const __mmask8 active1 = static_cast<__mmask8>(active >> 8);
+
+            const __m512 dx = _mm512_sub_ps(xi, _mm512_maskz_load_ps(active, r.x + j));
+            const __m512 dy = _mm512_sub_ps(yi, _mm512_maskz_load_ps(active, r.y + j));
+            const __m512 dz = _mm512_sub_ps(zi, _mm512_maskz_load_ps(active, r.z + j));
+            const __m512 r2 = _mm512_fmadd_ps(dz, dz, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dx, dx)));
+
+            __m512 Fr;
+            const __m512 Vp = pairAVX512Mixed(r2, active, ppf, Fr);
+            V = _mm512_add_pd(V, _mm512_add_pd(lowAVX512(Vp), highAVX512(Vp)));
+
+            const __m512 fx = _mm512_mul_ps(Fr, dx);
+            const __m512 fy = _mm512_mul_ps(Fr, dy);
+            const __m512 fz = _mm512_mul_ps(Fr, dz);
+            const __m512d fx0 = lowAVX512(fx), fx1 = highAVX512(fx);
+            const __m512d fy0 = lowAVX512(fy), fy1 = highAVX512(fy);
+            const __m512d fz0 = lowAVX512(fz), fz1 = highAVX512(fz);
+
+            Fx = _mm512_add_pd(Fx, _mm512_add_pd(fx0, fx1));
+            Fy = _mm512_add_pd(Fy, _mm512_add_pd(fy0, fy1));
+            Fz = _mm512_add_pd(Fz, _mm512_add_pd(fz0, fz1));
+            _mm512_mask_store_pd(F.x + j, active0, _mm512_sub_pd(_mm512_maskz_load_pd(active0, F.x + j), fx0));
+            _mm512_mask_store_pd(F.x + j + 8, active1, _mm512_sub_pd(_mm512_maskz_load_pd(active1, F.x + j + 8), fx1));
+            _mm512_mask_store_pd(F.y + j, active0, _mm512_sub_pd(_mm512_maskz_load_pd(active0, F.y + j), fy0));
+            _mm512_mask_store_pd(F.y + j + 8, active1, _mm512_sub_pd(_mm512_maskz_load_pd(active1, F.y + j + 8), fy1));
+            _mm512_mask_store_pd(F.z + j, active0, _mm512_sub_pd(_mm512_maskz_load_pd(active0, F.z + j), fz0));
+            _mm512_mask_store_pd(F.z + j + 8, active1, _mm512_sub_pd(_mm512_maskz_load_pd(active1, F.z + j + 8), fz1));
+        }
+
+        F.x[i] += reduceAVX512(Fx);
+        F.y[i] += reduceAVX512(Fy);
+        F.z[i] += reduceAVX512(Fz);
+
+        return reduceAVX512(V);
+    }
+
+    __attribute__((target("avx512f"))) double listAVX512Mixed(const VectorsF &r, Vectors &F, const uint &i, const uint *js,
+                                                              const uint &count, const PairParams &pp)
+    {
+        const PairParamsF ppf(pp);
+        const __m512 xi = _mm512_set1_ps(r.x[i]);
+        const __m512 yi = _mm512_set1_ps(r.y[i]);
+        const __m512 zi = _mm512_set1_ps(r.z[i]);
+
+        __m512d Fx = _mm512_setzero_pd(), Fy = _mm512_setzero_pd(), Fz = _mm512_setzero_pd(), V = _mm512_setzero_pd();
+
+        alignas(64) uint tail[16];
+
+        for (uint l = 0; l < count; l += 16)
+        {
+            const __mmask16 active = (count - l >= 16) ? 0xFFFF : static_cast<__mmask16>((1u << (count - l)) - 1u);
+            const __mmask8 active0 = static_cast<__mmask8>(active);
+            const __mmask8 active1 = static_cast<__mmask8>(active >> 8);
+
+            if (active != 0xFFFF)
+            {
+                for (uint q = 0; q < 16; q++)
+                    tail[q] = (l + q < count) ? js[l + q] : 0;
+            }
+
+            const __m512i idx = _mm512_loadu_si512(active == 0xFFFF ? js + l : tail);
+            const __m256i idx0 = _mm512_maskz_extracti64x4_epi64(0xFF, idx, 0);
+            const __m256i idx1 = _mm512_maskz_extracti64x4_epi64(0xFF, idx, 1);
+
+            const __m512 dx = _mm512_sub_ps(xi, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), active, idx, r.x, 4));
+            const __m512 dy = _mm512_sub_ps(yi, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), active, idx, r.y, 4));
+            const __m512 dz = _mm512_sub_ps(zi, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), active, idx, r.z, 4));
+            const __m512 r2 = _mm512_fmadd_ps(dz, dz, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dx, dx)));
+
+            __m512 Fr;
+            const __m512 Vp = pairAVX512Mixed(r2, active, ppf, Fr);
+            V = _mm512_add_pd(V, _mm512_add_pd(lowAVX512(Vp), highAVX512(Vp)));
+
+            const __m512 fx = _mm512_mul_ps(Fr, dx);
+            const __m512 fy = _mm512_mul_ps(Fr, dy);
+            const __m512 fz = _mm512_mul_ps(Fr, dz);
+            const __m512d fx0 = lowAVX512(fx), fx1 = highAVX512(fx);
+            const __m512d fy0 = lowAVX512(fy), fy1 = highAVX512(fy);
+            const __m512d fz0 = lowAVX512(fz), fz1 = highAVX512(fz);
+
+            Fx = _mm512_add_pd(Fx, _mm512_add_pd(fx0, fx1));
+            Fy = _mm512_add_pd(Fy, _mm512_add_pd(fy0, fy1));
+            Fz = _mm512_add_pd(Fz, _mm512_add_pd(fz0, fz1));
+
+            // Forces of neighbours stay in double, so they are scattered by halves
+            const __m512d zero = _mm512_setzero_pd();
+            _mm512_mask_i32scatter_pd(F.x, active0, idx0, _mm512_sub_pd(_mm512_mask_i32gather_pd(zero, active0, idx0, F.x, 8), fx0), 8);
+            _mm512_mask_i32scatter_pd(F.x, active1, idx1, _mm512_sub_pd(_mm512_mask_i32gather_pd(zero, active1, idx1, F.x, 8), fx1), 8);
+            _mm512_mask_i32scatter_pd(F.y, active0, idx0, _mm512_sub_pd(_mm512_mask_i32gather_pd(zero, active0, idx0, F.y, 8), fy0), 8);
+            _mm512_mask_i32scatter_pd(F.y, active1, idx1, _mm512_sub_pd(_mm512_mask_i32gather_pd(zero, active1, idx1, F.y, 8), fy1), 8);
+            _mm512_mask_i32scatter_pd(F.z, active0, idx0, _mm512_sub_pd(_mm512_mask_i32gather_pd(zero, active0, idx0, F.z, 8), fz0), 8);
+            _mm512_mask_i32scatter_pd(F.z, active1, idx1, _mm512_sub_pd(_mm512_mask_i32gather_pd(zero, active1, idx1, F.z, 8), fz1), 8);
+        }
+
+        F.x[i] += reduceAVX512(Fx);
+        F.y[i] += reduceAVX512(Fy);
+        F.z[i] += reduceAVX512(Fz);
+
+        return reduceAVX512(V);
+    }
+
+    // * * * * * * * * * * * * * * * * * Tabulated potential * * * * * * * * * * * * * * * //
+    // Pairs inside the table are interpolated from 4 coefficients of their interval,
+    // closer pairs (rare) use the analytic formula and pairs beyond the cutoff give zero.
+
+    inline double pairTableScalar(const double &r2, const PairTable &table, double &Fr) noexcept
+    {
+        if (r2 >= table.getS1())
+        {
+            Fr = 0.;
+            return 0.;
+        }
+
+        if (r2 < table.getS0())
+            return pairScalar(r2, table.getCore(), Fr);
+
+        return table.interpolate(r2, Fr);
+    }
+
+    double listTableScalar(const Vectors &r, Vectors &F, const uint &i, const uint *js, const uint &count,
+                           const PairTable &table)
+    {
+        const double xi = r.x[i];
+        const double yi = r.y[i];
+        const double zi = r.z[i];
+
+        double Fx = 0., Fy = 0., Fz = 0., V = 0.;
+
+        for (uint l = 0; l < count; l++)
+        {
+            const uint j = js[l];
+            const double dx = xi - r.x[j];
+            const double dy = yi - r.y[j];
+            const double dz = zi - r.z[j];
+
+            double Fr;
+            V += pairTableScalar(dx * dx + dy * dy + dz * dz, table, Fr);
+
+            Fx += Fr * dx;
+            Fy += Fr * dy;
+            Fz += Fr * dz;
+            F.x[j] -= Fr * dx;
+            F.y[j] -= Fr * dy;
+            F.z[j] -= Fr * dz;
+        }
+
+        F.x[i] += Fx;
+        F.y[i] += Fy;
+        F.z[i] += Fz;
+
+        return V;
+    }
+
+    /// Four pairs of the table at once
+    __attribute__((target("avx2,fma"))) inline __m256d pairTableAVX2(const __m256d &r2, const PairTable &table,
+                                                                    __m256d &Fr) noexcept
+    {
+        const __m256d s0 = _mm256_set1_pd(table.getS0());
+        const __m256d inside = _mm256_cmp_pd(r2, _mm256_set1_pd(table.getS1()), _CMP_LT_OQ);
+        const __m256d core = _mm256_and_pd(inside, _mm256_cmp_pd(r2, s0, _CMP_LT_OQ));
+        const __m256d tab = _mm256_andnot_pd(core, inside);
+
+        // Lanes outside of the table read the first interval and are cleared at the end
+        const __m256d u = _mm256_and_pd(tab, _mm256_mul_pd(_mm256_sub_pd(r2, s0), _mm256_set1_pd(table.getInvDs())));
+        const __m128i k = _mm256_cvttpd_epi32(u);
+        const __m256d t = _mm256_sub_pd(u, _mm256_cvtepi32_pd(k));
+        const __m128i k4 = _mm_slli_epi32(k, 2);
+        const double *c = table.coefficients();
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+        const __m256d c0 = _mm256_mask_i32gather_pd(zero, c, k4, all, 8);
+        const __m256d c1 = _mm256_mask_i32gather_pd(zero, c + 1, k4, all, 8);
+        const __m256d c2 = _mm256_mask_i32gather_pd(zero, c + 2, k4, all, 8);
+        const __m256d c3 = _mm256_mask_i32gather_pd(zero, c + 3, k4, all, 8);
+
+        __m256d V = _mm256_fmadd_pd(_mm256_fmadd_pd(_mm256_fmadd_pd(c3, t, c2), t, c1), t, c0);
+        __m256d dV = _mm256_fmadd_pd(_mm256_fmadd_pd(_mm256_mul_pd(_mm256_set1_pd(3.), c3), t,
+                                                      _mm256_add_pd(c2, c2)),
+                                     t, c1);
+
+        V = _mm256_and_pd(tab, V);
+        Fr = _mm256_and_pd(tab, _mm256_mul_pd(_mm256_set1_pd(-2. * table.getInvDs()), dV));
+
+        if (_mm256_movemask_pd(core) != 0)
+        {
+            __m256d Frc;
+            const __m256d Vc = pairAVX2(r2, table.getCore(), Frc);
+            V = _mm256_blendv_pd(V, Vc, core);
+            Fr = _mm256_blendv_pd(Fr, Frc, core);
+        }
+
+        return V;
+    }
+
+    __attribute__((target("avx2,fma"))) double listTableAVX2(const Vectors &r, Vectors &F, const uint &i, const uint *js,
+                                                             const uint &count, const PairTable &table)
+    {
+        const __m256d xi = _mm256_set1_pd(r.x[i]);
+        const __m256d yi = _mm256_set1_pd(r.y[i]);
+        const __m256d zi = _mm256_set1_pd(r.z[i]);
+
+        __m256d Fx = _mm256_setzero_pd(), Fy = _mm256_setzero_pd(), Fz = _mm256_setzero_pd(), V = _mm256_setzero_pd();
+        alignas(32) double fx[4], fy[4], fz[4];
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+        uint l = 0;
+
+        for (; l + 4 <= count; l += 4)
+        {
+            const __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(js + l));
+            const __m256d dx = _mm256_sub_pd(xi, _mm256_mask_i32gather_pd(zero, r.x, idx, all, 8));
+            const __m256d dy = _mm256_sub_pd(yi, _mm256_mask_i32gather_pd(zero, r.y, idx, all, 8));
+            const __m256d dz = _mm256_sub_pd(zi, _mm256_mask_i32gather_pd(zero, r.z, idx, all, 8));
+            const __m256d r2 = _mm256_fmadd_pd(dz, dz, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dx, dx)));
+
+            __m256d Fr;
+            V = _mm256_add_pd(V, pairTableAVX2(r2, table, Fr));
+
+            const __m256d Fpx = _mm256_mul_pd(Fr, dx);
+            const __m256d Fpy = _mm256_mul_pd(Fr, dy);
+            const __m256d Fpz = _mm256_mul_pd(Fr, dz);
+
+            Fx = _mm256_add_pd(Fx, Fpx);
+            Fy = _mm256_add_pd(Fy, Fpy);
+            Fz = _mm256_add_pd(Fz, Fpz);
+
+            _mm256_store_pd(fx, Fpx);
+            _mm256_store_pd(fy, Fpy);
+            _mm256_store_pd(fz, Fpz);
+
+            for (uint q = 0; q < 4; q++)
+            {
+                const uint j = js[l + q];
+                F.x[j] -= fx[q];
+                F.y[j] -= fy[q];
+                F.z[j] -= fz[q];
+            }
+        }
+
+        double Vi = reduceAVX2(V);
+        double Fxi = reduceAVX2(Fx), Fyi = reduceAVX2(Fy), Fzi = reduceAVX2(Fz);
+
+        for (; l < count; l++)
+        {
+            const uint j = js[l];
+            const double dx = r.x[i] - r.x[j];
+            const double dy = r.y[i] - r.y[j];
+            const double dz = r.z[i] - r.z[j];
+
+            double Fr;
+            Vi += pairTableScalar(dx * dx + dy * dy + dz * dz, table, Fr);
+
+            Fxi += Fr * dx;
+            Fyi += Fr * dy;
+            Fzi += Fr * dz;
+            F.x[j] -= Fr * dx;
+            F.y[j] -= Fr * dy;
+            F.z[j] -= Fr * dz;
+        }
+
+        F.x[i] += Fxi;
+        F.y[i] += Fyi;
+        F.z[i] += Fzi;
+
+        return Vi;
+    }
+
+    /// Eight pairs of the table at once, lanes outside of `active` give zero
+    __attribute__((target("avx512f"))) inline __m512d pairTableAVX512(const __m512d &r2, const __mmask8 &active,
+                                                                     const PairTable &table, __m512d &Fr) noexcept
+    {
+        const __m512d s0 = _mm512_set1_pd(table.getS0());
+        const __mmask8 inside = _mm512_mask_cmp_pd_mask(active, r2, _mm512_set1_pd(table.getS1()), _CMP_LT_OQ);
+        const __mmask8 core = _mm512_mask_cmp_pd_mask(inside, r2, s0, _CMP_LT_OQ);
+        const __mmask8 tab = inside & ~core;
+
+        const __m512d u = _mm512_maskz_mul_pd(tab, _mm512_sub_pd(r2, s0), _mm512_set1_pd(table.getInvDs()));
+        const __m256i k = _mm512_maskz_cvttpd_epi32(0xFF, u);
+        const __m512d t = _mm512_sub_pd(u, _mm512_maskz_cvtepi32_pd(0xFF, k));
+        const double *c = table.coefficients();
+
+        // Coefficients of every interval are contiguous, so 8 rows are loaded and transposed
+        alignas(32) int ks[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(ks), k);
+
+        const __m512d r01 = _mm512_mask_broadcast_f64x4(_mm512_maskz_broadcast_f64x4(0x0F, _mm256_loadu_pd(c + 4 * ks[0])), 0xF0,
+                                                          _mm256_loadu_pd(c + 4 * ks[1]));
+        const __m512d r23 = _mm512_mask_broadcast_f64x4(_mm512_maskz_broadcast_f64x4(0x0F, _mm256_loadu_pd(c + 4 * ks[2])), 0xF0,
+                                                          _mm256_loadu_pd(c + 4 * ks[3]));
+        const __m512d r45 = _mm512_mask_broadcast_f64x4(_mm512_maskz_broadcast_f64x4(0x0F, _mm256_loadu_pd(c + 4 * ks[4])), 0xF0,
+                                                          _mm256_loadu_pd(c + 4 * ks[5]));
+        const __m512d r67 = _mm512_mask_broadcast_f64x4(_mm512_maskz_broadcast_f64x4(0x0F, _mm256_loadu_pd(c + 4 * ks[6])), 0xF0,
+                                                          _mm256_loadu_pd(c + 4 * ks[7]));
+        const __m512i low = _mm512_setr_epi64(0, 4, 8, 12, 1, 5, 9, 13);
+        const __m512i high = _mm512_setr_epi64(2, 6, 10, 14, 3, 7, 11, 15);
+        const __m512d a01 = _mm512_permutex2var_pd(r01, low, r23), a23 = _mm512_permutex2var_pd(r01, high, r23);
+        const __m512d b01 = _mm512_permutex2var_pd(r45, low, r67), b23 = _mm512_permutex2var_pd(r45, high, r67);
+        const __m512i first = _mm512_setr_epi64(0, 1, 2, 3, 8, 9, 10, 11);
+        const __m512i second = _mm512_setr_epi64(4, 5, 6, 7, 12, 13, 14, 15);
+
+        // Lanes outside of the table read the first interval, their coefficients (so V and F) are zero
+        const __m512d c0 = _mm512_maskz_permutex2var_pd(tab, a01, first, b01);
+        const __m512d c1 = _mm512_maskz_permutex2var_pd(tab, a01, second, b01);
+        const __m512d c2 = _mm512_maskz_permutex2var_pd(tab, a23, first, b23);
+        const __m512d c3 = _mm512_maskz_permutex2var_pd(tab, a23, second, b23);
+
+        __m512d V = _mm512_fmadd_pd(_mm512_fmadd_pd(_mm512_fmadd_pd(c3, t, c2), t, c1), t, c0);
+        const __m512d dV = _mm512_fmadd_pd(_mm512_fmadd_pd(_mm512_mul_pd(_mm512_set1_pd(3.), c3), t,
+                                                           _mm512_add_pd(c2, c2)),
+                                           t, c1);
+        Fr = _mm512_mul_pd(_mm512_set1_pd(-2. * table.getInvDs()), dV);
+
+        if (core != 0)
+        {
+            __m512d Frc;
+            const __m512d Vc = pairAVX512(r2, core, table.getCore(), Frc);
+            V = _mm512_mask_mov_pd(V, core, Vc);
+            Fr = _mm512_mask_mov_pd(Fr, core, Frc);
+        }
+
+        return V;
+    }
+
+    __attribute__((target("avx512f"))) double listTableAVX512(const Vectors &r, Vectors &F, const uint &i, const uint *js,
+                                                              const uint &count, const PairTable &table)
+    {
+        const __m512d xi = _mm512_set1_pd(r.x[i]);
+        const __m512d yi = _mm512_set1_pd(r.y[i]);
+        const __m512d zi = _mm512_set1_pd(r.z[i]);
+
+        __m512d Fx = _mm512_setzero_pd(), Fy = _mm512_setzero_pd(), Fz = _mm512_setzero_pd(), V = _mm512_setzero_pd();
+
+        alignas(32) uint tail[8];
+
+        for (uint l = 0; l < count; l += 8)
+        {
+            const __mmask8 active = (count - l >= 8) ? 0xFF : static_cast<__mmask8>((1u << (count - l)) - 1u);
+
+            if (active != 0xFF)
+            {
+                for (uint q = 0; q < 8; q++)
+                    tail[q] = (l + q < count) ? js[l + q] : 0;
+            }
+
+            const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(active == 0xFF ? js + l : tail));
+
+            const __m512d dx = _mm512_sub_pd(xi, _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, r.x, 8));
+            const __m512d dy = _mm512_sub_pd(yi, _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, r.y, 8));
+            const __m512d dz = _mm512_sub_pd(zi, _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, r.z, 8));
+            const __m512d r2 = _mm512_fmadd_pd(dz, dz, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dx, dx)));
+
+            __m512d Fr;
+            V = _mm512_add_pd(V, pairTableAVX512(r2, active, table, Fr));
+
+            const __m512d fx = _mm512_mul_pd(Fr, dx);
+            const __m512d fy = _mm512_mul_pd(Fr, dy);
+            const __m512d fz = _mm512_mul_pd(Fr, dz);
+
+            Fx = _mm512_add_pd(Fx, fx);
+            Fy = _mm512_add_pd(Fy, fy);
+            Fz = _mm512_add_pd(Fz, fz);
+
+            const __m512d Fjx = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, F.x, 8);
+            const __m512d Fjy = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, F.y, 8);
+            const __m512d Fjz = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), active, idx, F.z, 8);
+            _mm512_mask_i32scatter_pd(F.x, active, idx, _mm512_sub_pd(Fjx, fx), 8);
+            _mm512_mask_i32scatter_pd(F.y, active, idx, _mm512_sub_pd(Fjy, fy), 8);
+            _mm512_mask_i32scatter_pd(F.z, active, idx, _mm512_sub_pd(Fjz, fz), 8);
+        }
+
+        F.x[i] += reduceAVX512(Fx);
+        F.y[i] += reduceAVX512(Fy);
+        F.z[i] += reduceAVX512(Fz);
+
+        return reduceAVX512(V);
+    }
+} // namespace
+
+/**************************************************************************************
+ * Detects the widest instruction set of pair kernels supported by the CPU (CPUID).
+ * @return Instruction set.
+ *************************************************************************************/
+Isa detectIsa() noexcept
+{
+    if (isaSupported(Isa::AVX512))
+        return Isa::AVX512;
+    if (isaSupported(Isa::AVX2))
+        return Isa::AVX2;
+
+    return Isa::Scalar;
+}
+
+/**************************************************************************************
+ * Checks if the CPU supports the given instruction set.
+ * @param Isa instruction set.
+ * @return True if kernels of that instruction set may be used.
+ *************************************************************************************/
+bool isaSupported(const Isa &isa) noexcept
+{
+    __builtin_cpu_init();
+
+    switch (isa)
+    {
+    case Isa::AVX512:
+        return __builtin_cpu_supports("avx512f");
+    case Isa::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    default:
+        return true;
+    }
+}
+
+/**************************************************************************************
+ * Returns the kernels of the given instruction set. `Isa::Auto` and instruction sets
+ * not supported by the CPU fall back to the widest supported one.
+ * @param Isa requested instruction set.
+ * @return Set of kernels.
+ *************************************************************************************/
+PairKernels selectKernels(const Isa &isa) noexcept
+{
+    const Isa use = (isa == Isa::Auto || !isaSupported(isa)) ? detectIsa() : isa;
+
+    switch (use)
+    {
+    case Isa::AVX512:
+        return {Isa::AVX512, rowAVX512, listAVX512, rowAVX512Mixed, listAVX512Mixed, listTableAVX512};
+    case Isa::AVX2:
+        return {Isa::AVX2, rowAVX2, listAVX2, rowAVX2Mixed, listAVX2Mixed, listTableAVX2};
+    default:
+        return {Isa::Scalar, rowScalar, listScalar, rowScalarMixed, listScalarMixed, listTableScalar};
+    }
+}
+
+const char *isaName(const Isa &isa) noexcept
+{
+    switch (isa)
+    {
+    case Isa::AVX512:
+        return "avx512";
+    case Isa::AVX2:
+        return "avx2";
+    case Isa::Scalar:
+        return "scalar";
+    default:
+        return "auto";
+    }
+}
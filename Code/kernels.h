@@ -0,0 +1,79 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+#include "vectors.h"
+typedef unsigned int uint;
+
+class PairTable;
+
+/// Instruction sets of the pair kernels
+enum class Isa : unsigned short int
+{
+    Scalar, ///< Portable C++ (reference)
+    AVX2,   ///< 4 pairs at a time (AVX2 + FMA)
+    AVX512, ///< 8 pairs at a time (AVX-512F)
+    Auto,   ///< The widest instruction set supported by the CPU
+};
+
+/// Precision of the pair kernels
+enum class Precision : unsigned short int
+{
+    Double, ///< All arithmetic in double
+    Mixed,  ///< Distances and Lennard-Jones terms in float, sums of forces and potential in double
+};
+
+/// Parameters of the Lennard-Jones potential (9) required by the kernels
+struct PairParams
+{
+    double e;   ///< Minimum of the potential
+    double R2;  ///< Squared distance of the minimum of the potential
+    double rc2; ///< Squared cutoff radius (infinity means no cutoff)
+    double Vc;  ///< Potential at the cutoff radius subtracted from every interacting pair
+};
+
+/// Interaction of atom i with atoms 0 ... count - 1 (row of the triangular pair matrix).
+/// Adds forces to atom i, subtracts them from atoms j and returns the potential energy.
+typedef double (*RowKernel)(const Vectors &r, Vectors &F, const uint &i, const uint &count, const PairParams &pp);
+
+/// Interaction of atom i with atoms js[0] ... js[count - 1] (row of the neighbor list).
+typedef double (*ListKernel)(const Vectors &r, Vectors &F, const uint &i, const uint *js, const uint &count,
+                             const PairParams &pp);
+
+/// Mixed precision row kernel, positions are rounded to float
+typedef double (*RowKernelMixed)(const VectorsF &r, Vectors &F, const uint &i, const uint &count, const PairParams &pp);
+
+/// Mixed precision list kernel, positions are rounded to float
+typedef double (*ListKernelMixed)(const VectorsF &r, Vectors &F, const uint &i, const uint *js, const uint &count,
+                                  const PairParams &pp);
+
+/// List kernel of the tabulated potential
+typedef double (*ListKernelTable)(const Vectors &r, Vectors &F, const uint &i, const uint *js, const uint &count,
+                                  const PairTable &table);
+
+/// Set of kernels for one instruction set
+struct PairKernels
+{
+    Isa isa;
+    RowKernel row;
+    ListKernel list;
+    RowKernelMixed rowMixed;
+    ListKernelMixed listMixed;
+    ListKernelTable listTable;
+};
+
+// All kernels use only r^2 (no sqrt) and a single division per pair. Vectorized kernels
+// sum contributions in a different order than the scalar one, so the potential energy
+// and forces differ from the scalar kernel by rounding only (relative 1e-15 in practice).
+// `./main --bench-kernels` checks that the difference does not exceed this tolerance.
+constexpr double PairKernelTolerance = 1e-10;
+
+// Mixed precision kernels round positions and evaluate pairs in float (relative 6e-8),
+// errors of distances are amplified by the steep repulsion, so they are compared with
+// the scalar double kernel within this (relative) tolerance.
+constexpr double MixedKernelTolerance = 1e-4;
+
+Isa detectIsa() noexcept;
+bool isaSupported(const Isa &isa) noexcept;
+PairKernels selectKernels(const Isa &isa) noexcept;
+const char *isaName(const Isa &isa) noexcept;
+
+#endif // KERNELS_H
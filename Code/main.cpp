@@ -11,14 +11,198 @@
 // Run this: ./main parameters.txt r0_init.txt p0_init.txt htp_init.txt rt_sim.txt htp_sim.txt hist.txt
 // Or compile and run:
 // c++ @flags.inp && ./main parameters.txt r0_init.txt p0_init.txt htp_init.txt rt_sim.txt htp_sim.txt hist.txt
+// Benchmark of the memory layout: ./main --bench-layout
+// Benchmark and validation of the SIMD pair kernels: ./main --bench-kernels
+// Strong scaling of the threaded pair forces: ./main --bench-threads
+// Multiple time step integrator against velocity Verlet: ./main --bench-respa
+// Validation of mixed precision pair kernels against double: ./main --bench-precision
+// Tabulated potential against the analytic one: ./main --bench-table
+// Thermalisation with thermostats: ./main --bench-thermostat
+// Benchmark of the integrator, CSV or JSON saved in `Out` folder: ./main --bench [bench.csv]
+// Replicas from the batch file on a thread pool: ./main --batch batch.txt summary.txt [workers]
+// Continue interrupted run from the checkpoint: ./main --restart parameters.txt checkpoint.bin rt_sim.txt htp_sim.txt
+// Timing of phases: c++ @flags.inp -DARGON_PROFILE, optional timeline: ARGON_TRACE=trace.json ./main ...
+// Conversion of binary trajectory to XYZ text for Jmol: ./main --to-xyz rt_sim.bin rt_sim.txt
+// Domain decomposition over MPI ranks: mpicxx @flags.inp -DARGON_MPI, run: mpirun -np 4 ./main parameters.txt ...
+// Weak scaling over MPI ranks: mpirun -np 4 ./main --bench-mpi
 
 #include "argon.h"
 #include "stats.h"
+#include "bench.h"
+#include "trajectory.h"
+#include "profile.h"
+#include "batch.h"
 #include <iostream>
 #include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
 
 int main(int argc, char *argv[])
 {
+    int rank = 0;
+
+#ifdef ARGON_MPI
+    // Every exit of the program finalizes MPI
+    MPI_Init(&argc, &argv);
+    std::atexit([]() { MPI_Finalize(); });
+
+    int ranks = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    if (argc > 1 && std::string(argv[1]) == "--bench-mpi")
+    {
+        benchMPI();
+        return EXIT_SUCCESS;
+    }
+
+    // Other modes would run the same work on every rank
+    if (ranks > 1 && argc > 1 && std::string(argv[1]).compare(0, 2, "--") == 0)
+    {
+        if (rank == 0)
+            std::cerr << "`main()` >: Only the simulation and --bench-mpi run on several MPI ranks.\n";
+        exit(1);
+    }
+#endif
+
+    // Benchmarks do not require any files
+    if (argc > 1 && std::string(argv[1]) == "--bench-layout")
+    {
+        benchLayout();
+        return EXIT_SUCCESS;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--bench-kernels")
+    {
+        benchKernels();
+        return EXIT_SUCCESS;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--bench-threads")
+    {
+        benchThreads();
+        return EXIT_SUCCESS;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--bench-respa")
+    {
+        benchRespa();
+        return EXIT_SUCCESS;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--bench-precision")
+    {
+        benchPrecision();
+        return EXIT_SUCCESS;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--bench-table")
+    {
+        benchTable();
+        return EXIT_SUCCESS;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--bench-thermostat")
+    {
+        benchThermostat();
+        return EXIT_SUCCESS;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--bench-sort")
+    {
+        benchSort();
+        return EXIT_SUCCESS;
+    }
+
+    // Optional file with results is in `Out` folder
+    if (argc > 1 && std::string(argv[1]) == "--bench")
+    {
+        benchSuite(argc > 2 ? argv[2] : nullptr);
+        return EXIT_SUCCESS;
+    }
+
+    // Both files are in `Out` folder
+    if (argc > 1 && std::string(argv[1]) == "--to-xyz")
+    {
+        if (argc < 4)
+        {
+            std::cerr << "Usage: ./main --to-xyz <binary trajectory> <xyz text>\n";
+            exit(1);
+        }
+
+        const bool converted = convertTrajectoryToXYZ(("../Out/" + std::string(argv[2])).c_str(), ("../Out/" + std::string(argv[3])).c_str());
+        return converted ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Batch file is in `Config` folder, summary and outputs of replicas in `Out` folder
+    if (argc > 1 && std::string(argv[1]) == "--batch")
+    {
+        if (argc < 4)
+        {
+            std::cerr << "Usage: ./main --batch <batch file> <summary> [workers]\n";
+            exit(1);
+        }
+
+        int workers = 0;
+
+        if (argc > 4)
+        {
+            std::size_t end = 0;
+
+            try
+            {
+                workers = std::stoi(argv[4], &end);
+            }
+            catch (const std::logic_error &)
+            {
+                end = 0;
+            }
+
+            if (end == 0 || argv[4][end] != '\0' || workers < 0)
+            {
+                std::cerr << "Usage: ./main --batch <batch file> <summary> [workers]\n";
+                exit(1);
+            }
+        }
+
+        const bool finished = runBatch(argv[2], argv[3], workers);
+        ARGON_PROFILE_REPORT(std::cout);
+
+        return finished ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Checkpoint and output files are in `Out` folder
+    if (argc > 1 && std::string(argv[1]) == "--restart")
+    {
+        if (argc < 7)
+        {
+            std::cerr << "Usage: ./main --restart <parameters> <checkpoint> <positions> <H, T, P> <histogram>\n";
+            exit(1);
+        }
+
+        Argon *A = new Argon;
+        A->setParameters(argv[2]);
+        A->checkParameters();
+
+        // The histogram accumulated before the checkpoint is restored into `S`
+        Stats *S = new Stats;
+        A->attachStats(S);
+
+        const bool restarted = A->restart(argv[3], argv[4], argv[5]);
+
+        delete A;
+
+        if (restarted)
+            S->evaluateHist(argv[6]);
+
+        delete S;
+        ARGON_PROFILE_REPORT(std::cout);
+
+        return restarted ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     if (argc < 8)
     {
         std::cerr << "Usage: ./main <1> <2> <3> <4> <5> <6> <7>\n";
@@ -29,7 +213,20 @@ int main(int argc, char *argv[])
         std::cerr << "<4> - output file with initial momenta to save in `Out` folder e.g. p0_init.txt\n";
         std::cerr << "<5> - output file with positions from the whole simulation to save in `Out` folder e.g. rt_sim.txt\n";
         std::cerr << "<6> - output file with H, T and P from the whole simulation to save in `Out` folder e.g. htp_sim.txt\n";
-        std::cerr << "<7> - output file with initial momentum histogram to save in `Out` folder e.g. hist.txt\n";
+        std::cerr << "<7> - output file with momentum histogram of the production to save in `Out` folder e.g. hist.txt\n";
+        std::cerr << "Or: ./main --bench-layout to compare memory layouts of the particles arrays\n";
+        std::cerr << "Or: ./main --bench-kernels to compare and validate SIMD pair kernels\n";
+        std::cerr << "Or: ./main --bench-threads to measure strong scaling of the pair forces\n";
+        std::cerr << "Or: ./main --bench-respa to compare r-RESPA with velocity Verlet\n";
+        std::cerr << "Or: ./main --bench-precision to validate mixed precision pair kernels against double\n";
+        std::cerr << "Or: ./main --bench-table to compare the tabulated potential with the analytic one\n";
+        std::cerr << "Or: ./main --bench-thermostat to compare thermalisation with thermostats\n";
+        std::cerr << "Or: ./main --bench-sort to compare sorting of atoms along space-filling curves\n";
+        std::cerr << "Or: ./main --bench [<1>] to benchmark the integrator and save results (.csv or .json) in `Out` folder\n";
+        std::cerr << "Or: ./main --batch <1> <2> [workers] to run replicas from batch file <1> and save summary <2>\n";
+        std::cerr << "Or: ./main --restart <1> <2> <5> <6> to continue the run from checkpoint <2> in `Out` folder\n";
+        std::cerr << "Or: ./main --to-xyz <1> <2> to convert binary trajectory <1> to XYZ text <2> in `Out` folder\n";
+        std::cerr << "Or: mpirun -np <ranks> ./main --bench-mpi to measure weak scaling of the domain decomposition (-DARGON_MPI)\n";
         exit(1);
     }
 
@@ -48,11 +245,10 @@ int main(int argc, char *argv[])
     // Call function `initialState()` is required if you want to get to simulation.
     A->initialState(argv[2], argv[3], argv[4]);
 
-    // Get absolute values of momenta, its size and calculated temperature
-    // is required if you want to calculate statistics.
-    usint N;
-    double *pAbs, T, k, m;
-    std::tie(pAbs, N, T, k, m) = A->getMomentumAbs();
+    // Statistics of momenta are accumulated every `Sout` steps of the production
+    // if you want to compare them with Maxwell-Boltzmann distribution.
+    Stats *S = new Stats;
+    A->attachStats(S);
 
     // Call function `simulateDynamics()` is optional.
     // But obviously it is the core of entertainment and playing with the system.
@@ -63,13 +259,25 @@ int main(int argc, char *argv[])
     // --------------------------------------
     std::chrono::high_resolution_clock::time_point tk = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> ms_double(tk - tp);
-    std::cout << "`main()` >: Argon execution time on CPU: " << ms_double.count() << " ms.\n";
 
-    // Calculate statistics from Maxwell-Boltzmann distribution
-    Stats *S = new Stats;
-    S->setInputFromArgon(pAbs, N, T, k, m);
-    S->evaluateHist(argv[7]);
+    // With several MPI ranks rank 0 has gathered the statistics of the whole system
+    if (rank == 0)
+    {
+        std::cout << "`main()` >: Argon execution time on CPU: " << ms_double.count() << " ms.\n";
+
+        // Peak resident memory of the process (ru_maxrss is given in kilobytes on Linux)
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        std::cout << "`main()` >: Peak memory usage: " << usage.ru_maxrss / 1024. << " MB.\n";
+
+        // Compare statistics with Maxwell-Boltzmann distribution
+        S->evaluateHist(argv[7]);
+    }
+
     delete S;
 
+    // Per-phase timing if compiled with -DARGON_PROFILE
+    ARGON_PROFILE_REPORT(std::cout);
+
     return EXIT_SUCCESS;
 }
\ No newline at end of file
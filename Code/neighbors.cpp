@@ -0,0 +1,296 @@
+#include "neighbors.h"
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+
+NeighborList::NeighborList() noexcept : N(0), M(0), rc(0.), skin(0.), low{0., 0., 0.}, nc{1, 1, 1}, cellSize{0., 0., 0.},
+                                        rebuilds(0)
+{
+}
+
+/**************************************************************************************
+ * This function prepares the linked-cell grid. The grid covers the cube [-L, L]^3
+ * circumscribed on the confining sphere. Edge of the single cell is not smaller than
+ * rc + skin, so neighbours of an atom are always in the same or in adjacent cells.
+ * Atoms which escaped from the cube are assigned to the border cells.
+ * @param uint number of atoms,
+ * @param double cutoff radius of the pair potential,
+ * @param double thickness of the Verlet skin,
+ * @param double radius of the confining sphere.
+ * @return Nothing to return.
+ *************************************************************************************/
+void NeighborList::setup(const uint &NAtoms, const double &rCut, const double &rSkin, const double &rSphere)
+{
+    setup(NAtoms, rCut, rSkin, {-rSphere, -rSphere, -rSphere}, {rSphere, rSphere, rSphere});
+}
+
+/**************************************************************************************
+ * Prepares the linked-cell grid over the given box, e.g. the periodic box extended by
+ * the layers of ghosts. Cells are not smaller than rc + skin along every axis.
+ * @param uint number of atoms,
+ * @param double cutoff radius of the pair potential,
+ * @param double thickness of the Verlet skin,
+ * @param double[3] lower corner of the box,
+ * @param double[3] upper corner of the box.
+ * @return Nothing to return.
+ *************************************************************************************/
+void NeighborList::setup(const uint &NAtoms, const double &rCut, const double &rSkin, const double (&lower)[3],
+                         const double (&upper)[3])
+{
+    N = NAtoms;
+    M = N;
+    rc = rCut;
+    skin = rSkin;
+
+    for (uint k = 0; k < 3; k++)
+    {
+        low[k] = lower[k];
+        nc[k] = std::max(1u, static_cast<uint>((upper[k] - lower[k]) / (rc + skin)));
+    }
+
+    // Do not allow the grid to be much larger than the number of atoms (e.g. huge sphere)
+    while (static_cast<double>(nc[0]) * nc[1] * nc[2] > 8. * N + 27.)
+    {
+        const uint largest = std::max({nc[0], nc[1], nc[2]});
+
+        if (largest == 1)
+            break;
+
+        for (uint k = 0; k < 3; k++)
+            nc[k] -= (nc[k] == largest);
+    }
+
+    for (uint k = 0; k < 3; k++)
+        cellSize[k] = (upper[k] - lower[k]) / nc[k];
+
+    head.assign(nc[0] * nc[1] * nc[2], N);
+    next.assign(N, N);
+    start.assign(N + 1, 0);
+    r0.resize(N);
+    list.clear();
+    rebuilds = 0;
+}
+
+/**************************************************************************************
+ * Calculates index of the cell along single axis for the given coordinate.
+ * @param double coordinate,
+ * @param uint axis.
+ * @return Index of the cell clamped to the grid.
+ *************************************************************************************/
+inline uint NeighborList::cellIndex(const double &x, const uint &k) const noexcept
+{
+    const double c = std::floor((x - low[k]) / cellSize[k]);
+
+    if (c < 0.)
+        return 0;
+    if (c >= nc[k])
+        return nc[k] - 1;
+
+    return static_cast<uint>(c);
+}
+
+/**************************************************************************************
+ * Checks if some atom has moved more than half of the skin since the last build.
+ * Only then a pair which was beyond rc + skin could have come closer than rc.
+ * @param Vectors current positions of atoms.
+ * @return True if the list has to be rebuilt, otherwise false.
+ *************************************************************************************/
+bool NeighborList::needsRebuild(const Vectors &r) const noexcept
+{
+    if (rebuilds == 0)
+        return true;
+
+    const double limit = 0.25 * skin * skin;
+
+    for (uint i = 0; i < N; i++)
+    {
+        const double dx = r.x[i] - r0.x[i];
+        const double dy = r.y[i] - r0.y[i];
+        const double dz = r.z[i] - r0.z[i];
+
+        if (dx * dx + dy * dy + dz * dz > limit)
+            return true;
+    }
+
+    return false;
+}
+
+/**************************************************************************************
+ * Sorts atoms into the cells and then collects all pairs closer than rc + skin
+ * by scanning only the adjacent cells. The cost is O(N).
+ * @param Vectors current positions of atoms.
+ * @return Nothing to return.
+ *************************************************************************************/
+void NeighborList::build(const Vectors &r)
+{
+    build(r, N, nullptr);
+}
+
+/**************************************************************************************
+ * Builds the list of atoms and their periodic images. Entries N ... M - 1 of r are
+ * images (ghosts) of atoms owner[j - N]. The pair of atom i with the ghost j is stored
+ * only for i < owner[j - N], so every pair of the periodic system is stored once.
+ * @param Vectors current positions of atoms followed by ghosts,
+ * @param uint number of atoms and ghosts,
+ * @param uint* owners of ghosts (nullptr without ghosts).
+ * @return Nothing to return.
+ *************************************************************************************/
+void NeighborList::build(const Vectors &r, const uint &MAtoms, const uint *owner)
+{
+    M = MAtoms;
+
+    collect(r, [this, owner](const uint &i, const uint &j) { return j <= i || (j >= N && owner[j - N] <= i); });
+}
+
+/**************************************************************************************
+ * Builds the list of N atoms of the domain followed by ghosts, i.e. atoms of other
+ * domains (or periodic images), which are given by their global IDs. The pair of atom i
+ * with the ghost j is stored only for ids[i] < ids[j], so the domain of the other atom
+ * skips the same pair and every pair is evaluated once over all domains. The number of
+ * atoms may change between builds (atoms migrate between domains).
+ * @param Vectors current positions of atoms followed by ghosts,
+ * @param uint number of atoms (rows of the list),
+ * @param uint number of atoms and ghosts,
+ * @param uint* global ID of every atom and ghost.
+ * @return Nothing to return.
+ *************************************************************************************/
+void NeighborList::build(const Vectors &r, const uint &NAtoms, const uint &MAtoms, const uint *ids)
+{
+    N = NAtoms;
+    M = MAtoms;
+
+    // Some spare room, the number of atoms fluctuates between builds
+    if (r0.size() < N)
+        r0.resize(N + N / 8);
+
+    start.resize(N + 1);
+
+    collect(r, [this, ids](const uint &i, const uint &j) { return (j < N) ? j <= i : ids[j] <= ids[i]; });
+}
+
+/**************************************************************************************
+ * Fills the linked cells with atoms and ghosts and collects pairs of every atom closer
+ * than rc + skin, except those skipped by the given rule.
+ * @param Vectors current positions of atoms followed by ghosts,
+ * @param Skip function (i, j) which is true if the pair is not stored in the row i.
+ * @return Nothing to return.
+ *************************************************************************************/
+template <typename Skip>
+void NeighborList::collect(const Vectors &r, Skip skip)
+{
+
+    if (next.size() < M)
+        next.resize(M);
+
+    std::fill(head.begin(), head.end(), M);
+
+    // Fill the linked cells
+    for (uint i = 0; i < M; i++)
+    {
+        const uint c = cellIndex(r.x[i], 0) + nc[0] * (cellIndex(r.y[i], 1) + nc[1] * cellIndex(r.z[i], 2));
+        next[i] = head[c];
+        head[c] = i;
+    }
+
+    const double rl2 = (rc + skin) * (rc + skin);
+    list.clear();
+
+    for (uint i = 0; i < N; i++)
+    {
+        start[i] = list.size();
+
+        const uint cx = cellIndex(r.x[i], 0);
+        const uint cy = cellIndex(r.y[i], 1);
+        const uint cz = cellIndex(r.z[i], 2);
+
+        // Adjacent cells without wrapping, so no cell is visited twice
+        for (uint z = (cz > 0 ? cz - 1 : 0); z <= std::min(cz + 1, nc[2] - 1); z++)
+        {
+            for (uint y = (cy > 0 ? cy - 1 : 0); y <= std::min(cy + 1, nc[1] - 1); y++)
+            {
+                for (uint x = (cx > 0 ? cx - 1 : 0); x <= std::min(cx + 1, nc[0] - 1); x++)
+                {
+                    for (uint j = head[x + nc[0] * (y + nc[1] * z)]; j != M; j = next[j])
+                    {
+                        if (skip(i, j))
+                            continue;
+
+                        const double dx = r.x[i] - r.x[j];
+                        const double dy = r.y[i] - r.y[j];
+                        const double dz = r.z[i] - r.z[j];
+
+                        if (dx * dx + dy * dy + dz * dz < rl2)
+                            list.push_back(j);
+                    }
+                }
+            }
+        }
+    }
+
+    start[N] = list.size();
+
+    // Remember positions to check displacements later
+    for (uint i = 0; i < N; i++)
+    {
+        r0.x[i] = r.x[i];
+        r0.y[i] = r.y[i];
+        r0.z[i] = r.z[i];
+    }
+
+    ++rebuilds;
+}
+
+/**************************************************************************************
+ * Restores the list saved in the checkpoint. The list is built from the positions of
+ * the last build, so it is exactly the same as before and later rebuilds occur in
+ * the same steps.
+ * @param Vectors positions of atoms at the moment of the last build,
+ * @param uint number of builds.
+ * @return Nothing to return.
+ *************************************************************************************/
+void NeighborList::restore(const Vectors &reference, const uint &nRebuilds)
+{
+    build(reference);
+    rebuilds = nRebuilds;
+}
+
+/**************************************************************************************
+ * Restores the list of atoms and their periodic images saved in the checkpoint.
+ * @param Vectors positions of atoms and ghosts at the moment of the last build,
+ * @param uint number of atoms and ghosts,
+ * @param uint* owners of ghosts,
+ * @param uint number of builds.
+ * @return Nothing to return.
+ *************************************************************************************/
+void NeighborList::restore(const Vectors &reference, const uint &MAtoms, const uint *owner, const uint &nRebuilds)
+{
+    build(reference, MAtoms, owner);
+    rebuilds = nRebuilds;
+}
+
+/**************************************************************************************
+ * Mean distance |i - j| in memory (in atoms) of listed pairs of atoms, a measure of
+ * locality of the order of atoms: the pair kernels read neighbours j of the row i,
+ * which come from the cache only if atoms near each other in space are near each other
+ * in memory. Ghosts are left out, they are stored after all atoms.
+ * @return Mean |i - j| over pairs of atoms (0 without pairs).
+ *************************************************************************************/
+double NeighborList::span() const noexcept
+{
+    double sum = 0.;
+    uint64_t pairs = 0;
+
+    for (uint i = 0; i < N; i++)
+    {
+        for (uint q = start[i]; q < start[i + 1]; q++)
+        {
+            if (list[q] < N)
+            {
+                sum += list[q] - i;
+                pairs++;
+            }
+        }
+    }
+
+    return (pairs == 0) ? 0. : sum / pairs;
+}
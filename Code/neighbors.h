@@ -0,0 +1,62 @@
+#ifndef NEIGHBORS_H
+#define NEIGHBORS_H
+#include <vector>
+#include "vectors.h"
+typedef unsigned short int usint;
+typedef unsigned int uint;
+
+class NeighborList
+{
+private:
+    /// Parameters of the list
+    uint N;         ///< Number of atoms (rows of the list)
+    uint M;         ///< Number of atoms and periodic images in the grid
+    double rc;      ///< Cutoff radius of the pair potential
+    double skin;    ///< Thickness of the Verlet skin
+    double low[3];  ///< Lower corner of the box covered by the cell grid
+
+    /// Linked-cell grid
+    uint nc[3];             ///< Number of cells along every edge of the grid
+    double cellSize[3];     ///< Edges of the single cell
+    std::vector<uint> head; ///< First atom in every cell (M means empty cell)
+    std::vector<uint> next; ///< Next atom in the same cell (M means end of the chain)
+
+    /// Verlet list in compressed row format (half list, every pair is stored once)
+    std::vector<uint> start; ///< Index in `list` where the neighbours of atom i begin
+    std::vector<uint> list;  ///< Neighbours j > i of every atom i
+    Vectors r0;              ///< Positions of atoms at the moment of the last build
+
+    uint rebuilds; ///< Number of builds since `setup()`
+
+    uint cellIndex(const double &x, const uint &k) const noexcept;
+    template <typename Skip>
+    void collect(const Vectors &r, Skip skip);
+
+public:
+    NeighborList() noexcept;
+
+    void setup(const uint &N, const double &rc, const double &skin, const double &L);
+    void setup(const uint &N, const double &rc, const double &skin, const double (&low)[3], const double (&high)[3]);
+    bool needsRebuild(const Vectors &r) const noexcept;
+    void build(const Vectors &r);
+    void build(const Vectors &r, const uint &M, const uint *owner);
+    void build(const Vectors &r, const uint &N, const uint &M, const uint *ids);
+    void restore(const Vectors &reference, const uint &rebuilds);
+    void restore(const Vectors &reference, const uint &M, const uint *owner, const uint &rebuilds);
+
+    /// Neighbours of atom i are list()[begin(i)] ... list()[end(i) - 1]
+    uint begin(const uint &i) const noexcept { return start[i]; }
+    uint end(const uint &i) const noexcept { return start[i + 1]; }
+    const uint *neighbors() const noexcept { return list.data(); }
+    const uint *offsets() const noexcept { return start.data(); }
+
+    double span() const noexcept;
+
+    uint size() const noexcept { return list.size(); }
+    uint getRows() const noexcept { return N; }
+    uint getAtoms() const noexcept { return M; }
+    uint getRebuilds() const noexcept { return rebuilds; }
+    const Vectors &getReference() const noexcept { return r0; }
+};
+
+#endif // NEIGHBORS_H
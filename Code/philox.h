@@ -0,0 +1,87 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+#include <cmath>
+#include <cstdint>
+
+/// Counter-based pseudo-random number generator Philox4x32-10 (Salmon et al., SC'11).
+/// Every 128-bit counter is encrypted with the 64-bit key (seed) into 128 random bits,
+/// so numbers are pure functions of (seed, counter): they may be drawn in any order and
+/// on any thread with the same results, and there is no state to save except the seed.
+class Philox
+{
+private:
+    uint64_t key; ///< Seed of the generator
+
+    /// Product of 32-bit numbers split into the high and low halves
+    static void multiply(const uint32_t &a, const uint32_t &b, uint32_t &hi, uint32_t &lo) noexcept
+    {
+        const uint64_t product = static_cast<uint64_t>(a) * b;
+        hi = static_cast<uint32_t>(product >> 32);
+        lo = static_cast<uint32_t>(product);
+    }
+
+public:
+    explicit Philox(const uint64_t &seed) noexcept : key(seed) {}
+
+    /// Encrypts the counter into 4 random 32-bit words
+    void generate(const uint32_t (&counter)[4], uint32_t (&result)[4]) const noexcept
+    {
+        uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        uint32_t k0 = static_cast<uint32_t>(key), k1 = static_cast<uint32_t>(key >> 32);
+
+        for (int round = 0; round < 10; round++)
+        {
+            uint32_t hi0, lo0, hi1, lo1;
+            multiply(0xD2511F53u, c0, hi0, lo0);
+            multiply(0xCD9E8D57u, c2, hi1, lo1);
+
+            c0 = hi1 ^ c1 ^ k0;
+            c1 = lo1;
+            c2 = hi0 ^ c3 ^ k1;
+            c3 = lo0;
+
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+
+        result[0] = c0;
+        result[1] = c1;
+        result[2] = c2;
+        result[3] = c3;
+    }
+
+    /// Uniform number from (0, 1] with 53 random bits of two words
+    static double uniform(const uint32_t &hi, const uint32_t &lo) noexcept
+    {
+        const uint64_t bits = (static_cast<uint64_t>(hi) << 32 | lo) >> 11;
+        return (bits + 1.) * 0x1p-53;
+    }
+
+    /// Standard normal number (Box-Muller) for the given counter, e.g. atom, component, stream and step
+    double gaussian(const uint32_t &c0, const uint32_t &c1, const uint32_t &c2, const uint32_t &c3) const noexcept
+    {
+        uint32_t bits[4];
+        generate({c0, c1, c2, c3}, bits);
+
+        return std::sqrt(-2. * std::log(uniform(bits[0], bits[1]))) * std::cos(2. * M_PI * uniform(bits[2], bits[3]));
+    }
+
+    /// Four standard normal numbers (two Box-Muller pairs) from 32-bit uniforms of a single
+    /// counter, tails beyond 6.6 sigma are cut, e.g. for random forces of the thermostat
+    void gaussians(const uint32_t &c0, const uint32_t &c1, const uint32_t &c2, const uint32_t &c3, double (&g)[4]) const noexcept
+    {
+        uint32_t bits[4];
+        generate({c0, c1, c2, c3}, bits);
+
+        for (int j = 0; j < 4; j += 2)
+        {
+            const double radius = std::sqrt(-2. * std::log((bits[j] + 1.) * 0x1p-32));
+            const double angle = 2. * M_PI * bits[j + 1] * 0x1p-32;
+
+            g[j] = radius * std::cos(angle);
+            g[j + 1] = radius * std::sin(angle);
+        }
+    }
+};
+
+#endif // PHILOX_H
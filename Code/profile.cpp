@@ -0,0 +1,227 @@
+#include "profile.h"
+
+#ifdef ARGON_PROFILE
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace
+{
+    constexpr unsigned int Phases = static_cast<unsigned int>(Phase::Count);
+    constexpr unsigned int Counters = static_cast<unsigned int>(Counter::Count);
+    constexpr std::size_t MaxEvents = 1 << 20; ///< Limit of trace events of a single thread (24 MB)
+
+    constexpr const char *PhaseNames[Phases] = {"KickDrift", "WallForces", "NeighborBuild", "PairForces", "Kick",
+                                                "Positions", "HTP", "Info", "Checkpoint", "Histogram", "Structure",
+                                                "Correlation", "Thermostat", "Sort", "Writer"};
+
+    /// Single interval of the timeline
+    struct Event
+    {
+        unsigned int phase;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    /// Measurements of a single thread (written only by this thread)
+    struct ThreadData
+    {
+        unsigned int id;
+        uint64_t total[Phases] = {};
+        uint64_t calls[Phases] = {};
+        std::vector<Event> events;
+        uint64_t dropped = 0;
+    };
+
+    /// Measurements of all threads
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadData>> threads;
+        std::atomic<uint64_t> counters[Counters] = {};
+        uint64_t ticks0;
+        std::chrono::steady_clock::time_point time0;
+        bool trace;
+
+        Registry() : ticks0(profile::ticks()), time0(std::chrono::steady_clock::now()),
+                     trace(std::getenv("ARGON_TRACE") != nullptr)
+        {
+        }
+    };
+
+    Registry &registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    // Shares of phases are given relative to the time since the start of the program
+    const Registry &startup = registry();
+
+    ThreadData &threadData()
+    {
+        thread_local ThreadData *data = nullptr;
+
+        if (data == nullptr)
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+
+            r.threads.push_back(std::make_unique<ThreadData>());
+            data = r.threads.back().get();
+            data->id = r.threads.size();
+
+            if (r.trace)
+                data->events.reserve(1 << 16);
+        }
+
+        return *data;
+    }
+} // namespace
+
+/**************************************************************************************
+ * Current time in ticks of the time stamp counter (nanoseconds on other CPUs).
+ * @return Ticks.
+ *************************************************************************************/
+uint64_t profile::ticks() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void profile::record(const Phase &phase, const uint64_t &begin, const uint64_t &end) noexcept
+{
+    ThreadData &data = threadData();
+    const unsigned int p = static_cast<unsigned int>(phase);
+
+    data.total[p] += end - begin;
+    ++data.calls[p];
+
+    if (!registry().trace)
+        return;
+
+    if (data.events.size() < MaxEvents)
+        data.events.push_back(Event{p, begin, end});
+    else
+        ++data.dropped;
+}
+
+void profile::count(const Counter &counter, const uint64_t &value) noexcept
+{
+    registry().counters[static_cast<unsigned int>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+/**************************************************************************************
+ * Prints time of every phase summed over all threads with the share of the time since
+ * the start of the program and all counters. Saves the timeline to the file given
+ * by ARGON_TRACE.
+ * @param ostream where to print the report.
+ * @return Nothing to return.
+ *************************************************************************************/
+void profile::report(std::ostream &out)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    // Calibrate ticks with the steady clock over the whole run
+    const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - r.time0).count();
+    const double nsPerTick = elapsed / std::max<uint64_t>(1, ticks() - r.ticks0);
+
+    uint64_t total[Phases] = {};
+    uint64_t calls[Phases] = {};
+    uint64_t dropped = 0;
+
+    for (const auto &data : r.threads)
+    {
+        for (unsigned int p = 0; p < Phases; p++)
+        {
+            total[p] += data->total[p];
+            calls[p] += data->calls[p];
+        }
+
+        dropped += data->dropped;
+    }
+
+    out << "`profile` :> Phases (share of " << std::fixed << std::setprecision(3) << 1e-6 * elapsed
+        << " ms since the start, Writer runs on the background thread):\n";
+    out << std::setw(16) << "phase" << std::setw(12) << "calls" << std::setw(14) << "total (ms)" << std::setw(14)
+        << "mean (us)" << std::setw(10) << "share" << '\n';
+
+    for (unsigned int p = 0; p < Phases; p++)
+    {
+        if (calls[p] == 0)
+            continue;
+
+        const double ns = total[p] * nsPerTick;
+
+        out << std::fixed << std::setw(16) << PhaseNames[p] << std::setw(12) << calls[p] << std::setw(14) << std::setprecision(3)
+            << 1e-6 * ns << std::setw(14) << 1e-3 * ns / calls[p] << std::setw(9) << std::setprecision(2)
+            << 100. * ns / elapsed << "%\n";
+    }
+
+    const double pairs = r.counters[static_cast<unsigned int>(Counter::PairEvaluations)].load();
+    const double pairSeconds = 1e-9 * total[static_cast<unsigned int>(Phase::PairForces)] * nsPerTick;
+
+    out << "`profile` :> Pair evaluations:  " << std::setprecision(0) << pairs;
+
+    if (pairSeconds > 0.)
+        out << " (" << std::scientific << std::setprecision(3) << pairs / pairSeconds << " pairs/s)" << std::fixed;
+
+    out << '\n';
+    out << "`profile` :> Neighbor rebuilds: " << r.counters[static_cast<unsigned int>(Counter::NeighborRebuilds)].load() << '\n';
+    out << "`profile` :> Bytes written:     " << r.counters[static_cast<unsigned int>(Counter::BytesWritten)].load() << '\n';
+    out << "`profile` :> Blocked on output: " << std::setprecision(3)
+        << 1e-6 * r.counters[static_cast<unsigned int>(Counter::BlockedNs)].load() << " ms\n";
+
+    if (!r.trace)
+    {
+        out << '\n' << std::defaultfloat;
+        return;
+    }
+
+    const char *filename = std::getenv("ARGON_TRACE");
+    std::ofstream trace(filename, std::ios::out);
+
+    if (!trace)
+    {
+        out << "`profile` :> Cannot open trace file " << filename << "\n\n" << std::defaultfloat;
+        return;
+    }
+
+    // Chrome trace: complete events with microsecond timestamps
+    trace << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    bool first = true;
+
+    for (const auto &data : r.threads)
+    {
+        for (const Event &event : data->events)
+        {
+            trace << (first ? "" : ",\n") << "{\"name\": \"" << PhaseNames[event.phase] << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                  << data->id << ", \"ts\": " << 1e-3 * (event.begin - r.ticks0) * nsPerTick << ", \"dur\": "
+                  << 1e-3 * (event.end - event.begin) * nsPerTick << "}";
+            first = false;
+        }
+    }
+
+    trace << "\n]}\n";
+
+    out << "`profile` :> Trace saved to " << filename;
+
+    if (dropped > 0)
+        out << " (" << dropped << " events dropped)";
+
+    out << "\n\n" << std::defaultfloat;
+}
+#endif // ARGON_PROFILE
@@ -0,0 +1,78 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+// Instrumentation of the hot path. It is compiled in only with -DARGON_PROFILE
+// (e.g. c++ @flags.inp -DARGON_PROFILE), otherwise all macros expand to nothing.
+// Report of phases and counters is printed by ARGON_PROFILE_REPORT() and if the
+// environment variable ARGON_TRACE is set, the timeline is also saved there as
+// Chrome trace JSON (chrome://tracing or https://ui.perfetto.dev).
+
+/// Timed phases of the run
+enum class Phase : unsigned int
+{
+    KickDrift,     ///< Auxiliary momenta and positions (18a), (18b)
+    WallForces,    ///< Repulsion from the sphere walls, potential and pressure
+    NeighborBuild, ///< Rebuilds of the Verlet list
+    PairForces,    ///< Pair kernels (9), (13)
+    Kick,          ///< Momenta (18c) and kinetic energy
+    Positions,     ///< Saving positions (formatting or copying to the writer)
+    HTP,           ///< Saving H, T and P
+    Info,          ///< Printing current informations
+    Checkpoint,    ///< Saving checkpoints
+    Histogram,     ///< Statistics of momenta
+    Structure,     ///< Radial distribution function g(r)
+    Correlation,   ///< Mean squared displacement and velocity autocorrelation
+    Thermostat,    ///< Thermostat and barostat
+    Sort,          ///< Sorting atoms along the space-filling curve
+    Writer,        ///< Writing snapshots on the background thread
+    Count,
+};
+
+/// Counted events of the run
+enum class Counter : unsigned int
+{
+    PairEvaluations,  ///< Pair interactions evaluated by the kernels
+    NeighborRebuilds, ///< Rebuilds of the Verlet list
+    BytesWritten,     ///< Bytes of positions and H, T, P written to files
+    BlockedNs,        ///< Nanoseconds of the simulation thread waiting for output
+    Count,
+};
+
+#ifdef ARGON_PROFILE
+#include <cstdint>
+#include <ostream>
+
+namespace profile
+{
+    uint64_t ticks() noexcept;
+    void record(const Phase &phase, const uint64_t &begin, const uint64_t &end) noexcept;
+    void count(const Counter &counter, const uint64_t &value) noexcept;
+    void report(std::ostream &out);
+
+    /// Measures the time from construction to the end of the scope
+    class Scope
+    {
+    private:
+        Phase phase;    ///< Measured phase
+        uint64_t begin; ///< Ticks at construction
+
+    public:
+        explicit Scope(const Phase &p) noexcept : phase(p), begin(ticks()) {}
+        ~Scope() noexcept { record(phase, begin, ticks()); }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+} // namespace profile
+
+#define ARGON_PROFILE_JOIN_(a, b) a##b
+#define ARGON_PROFILE_JOIN(a, b) ARGON_PROFILE_JOIN_(a, b)
+#define ARGON_PROFILE_SCOPE(phase) profile::Scope ARGON_PROFILE_JOIN(profileScope, __LINE__)(phase)
+#define ARGON_PROFILE_COUNT(counter, value) profile::count(counter, value)
+#define ARGON_PROFILE_REPORT(out) profile::report(out)
+#else
+#define ARGON_PROFILE_SCOPE(phase)
+#define ARGON_PROFILE_COUNT(counter, value)
+#define ARGON_PROFILE_REPORT(out)
+#endif // ARGON_PROFILE
+
+#endif // PROFILE_H
@@ -0,0 +1,279 @@
+#define _USE_MATH_DEFINES
+#include "rdf.h"
+#include "profile.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+namespace
+{
+    /**************************************************************************************
+     * Fraction of pairs of points placed uniformly in the sphere of radius L which are
+     * closer than r (integral of P(r)).
+     *************************************************************************************/
+    double sphereDistanceCDF(const double &r, const double &L) noexcept
+    {
+        const double u = std::min(r / L, 2.);
+        const double u3 = u * u * u;
+
+        return u3 - 9. / 16. * u3 * u + 1. / 32. * u3 * u3;
+    }
+
+    /**************************************************************************************
+     * Fraction of pairs of nearest images in the periodic box of the given volume which
+     * are closer than r (r below half of the shortest edge).
+     *************************************************************************************/
+    double boxDistanceCDF(const double &r, const double &volume) noexcept
+    {
+        return 4. / 3. * M_PI * r * r * r / volume;
+    }
+} // namespace
+
+PairCorrelation::PairCorrelation() noexcept : N(0), rMax(0.), bins(0), L(0.), volume(0.), invWidth(0.), frames(0), nc(1),
+                                              cellSize(0.)
+{
+}
+
+/**************************************************************************************
+ * Prepares the empty histogram and the cell grid. As in `NeighborList` the grid covers
+ * the cube [-L, L]^3 with cells not smaller than rMax and atoms outside the cube are
+ * assigned to the border cells.
+ * @param uint number of atoms,
+ * @param double largest distance of the histogram,
+ * @param uint number of bins,
+ * @param double radius of the confining sphere.
+ * @return Nothing to return.
+ *************************************************************************************/
+void PairCorrelation::setup(const uint &NAtoms, const double &rLimit, const uint &nBins, const double &rSphere)
+{
+    N = NAtoms;
+    rMax = rLimit;
+    bins = nBins;
+    L = rSphere;
+    volume = 0.;
+    invWidth = bins / rMax;
+
+    counts.assign(bins, 0);
+    frames = 0;
+
+    nc = std::max(1u, static_cast<uint>(2. * L / rMax));
+
+    // Do not allow the grid to be much larger than the number of atoms (e.g. huge sphere)
+    while (nc > 1 && static_cast<double>(nc) * nc * nc > 8. * N + 27.)
+        --nc;
+
+    cellSize = 2. * L / nc;
+
+    head.assign(nc * nc * nc, N);
+    next.assign(N, N);
+}
+
+/**************************************************************************************
+ * Normalises g(r) by the periodic box instead of the sphere. Pairs have to be
+ * accumulated from the Verlet list with ghosts (the own grid does not wrap).
+ * @param double volume of the box.
+ * @return Nothing to return.
+ *************************************************************************************/
+void PairCorrelation::setPeriodic(const double &boxVolume) noexcept
+{
+    volume = boxVolume;
+}
+
+/**************************************************************************************
+ * Calculates index of the cell along single axis for the given coordinate.
+ * @param double coordinate.
+ * @return Index of the cell clamped to the grid.
+ *************************************************************************************/
+inline uint PairCorrelation::cellIndex(const double &x) const noexcept
+{
+    const double c = std::floor((x + L) / cellSize);
+
+    if (c < 0.)
+        return 0;
+    if (c >= nc)
+        return nc - 1;
+
+    return static_cast<uint>(c);
+}
+
+/**************************************************************************************
+ * Adds the frame with pairs of the Verlet list. The list holds every pair closer than
+ * the cutoff rc, so it is complete only if rMax <= rc.
+ * @param Vectors current positions of atoms,
+ * @param NeighborList list valid for current positions.
+ * @return Nothing to return.
+ *************************************************************************************/
+void PairCorrelation::accumulate(const Vectors &r, const NeighborList &list) noexcept
+{
+    ARGON_PROFILE_SCOPE(Phase::Structure);
+
+    const double rMax2 = rMax * rMax;
+    const uint *neighbors = list.neighbors();
+
+    for (uint i = 0; i < N; i++)
+    {
+        for (uint q = list.begin(i); q < list.end(i); q++)
+        {
+            const uint j = neighbors[q];
+            const double dx = r.x[i] - r.x[j];
+            const double dy = r.y[i] - r.y[j];
+            const double dz = r.z[i] - r.z[j];
+            const double r2 = dx * dx + dy * dy + dz * dz;
+
+            if (r2 < rMax2)
+                ++counts[std::min(bins - 1, static_cast<uint>(std::sqrt(r2) * invWidth))];
+        }
+    }
+
+    frames++;
+}
+
+/**************************************************************************************
+ * Adds the frame with pairs found in the linked cells (adjacent cells of every atom).
+ * The cost is O(N) for the fixed density.
+ * @param Vectors current positions of atoms.
+ * @return Nothing to return.
+ *************************************************************************************/
+void PairCorrelation::accumulate(const Vectors &r) noexcept
+{
+    ARGON_PROFILE_SCOPE(Phase::Structure);
+
+    std::fill(head.begin(), head.end(), N);
+
+    for (uint i = 0; i < N; i++)
+    {
+        const uint c = cellIndex(r.x[i]) + nc * (cellIndex(r.y[i]) + nc * cellIndex(r.z[i]));
+        next[i] = head[c];
+        head[c] = i;
+    }
+
+    const double rMax2 = rMax * rMax;
+
+    for (uint i = 0; i < N; i++)
+    {
+        const uint cx = cellIndex(r.x[i]);
+        const uint cy = cellIndex(r.y[i]);
+        const uint cz = cellIndex(r.z[i]);
+
+        for (uint z = (cz > 0 ? cz - 1 : 0); z <= std::min(cz + 1, nc - 1); z++)
+        {
+            for (uint y = (cy > 0 ? cy - 1 : 0); y <= std::min(cy + 1, nc - 1); y++)
+            {
+                for (uint x = (cx > 0 ? cx - 1 : 0); x <= std::min(cx + 1, nc - 1); x++)
+                {
+                    for (uint j = head[x + nc * (y + nc * z)]; j != N; j = next[j])
+                    {
+                        if (j <= i)
+                            continue;
+
+                        const double dx = r.x[i] - r.x[j];
+                        const double dy = r.y[i] - r.y[j];
+                        const double dz = r.z[i] - r.z[j];
+                        const double r2 = dx * dx + dy * dy + dz * dz;
+
+                        if (r2 < rMax2)
+                            ++counts[std::min(bins - 1, static_cast<uint>(std::sqrt(r2) * invWidth))];
+                    }
+                }
+            }
+        }
+    }
+
+    frames++;
+}
+
+/**************************************************************************************
+ * Restores the histogram saved in the checkpoint.
+ * @param vector<uint64_t> number of pairs in every bin,
+ * @param uint number of accumulated frames.
+ * @return Nothing to return.
+ *************************************************************************************/
+void PairCorrelation::restore(const std::vector<uint64_t> &savedCounts, const uint &savedFrames)
+{
+    counts = savedCounts;
+    frames = savedFrames;
+}
+
+/**************************************************************************************
+ * Normalises the histogram by the number of pairs expected in every bin for atoms
+ * placed uniformly in the sphere (or box): frames N (N - 1) / 2 (F(r + dr) - F(r)),
+ * where F is the integral of P(r).
+ * @return g(r) in the middle of every bin.
+ *************************************************************************************/
+std::vector<double> PairCorrelation::normalized() const
+{
+    std::vector<double> g(bins, 0.);
+    const double pairs = 0.5 * N * (N - 1.) * frames;
+
+    for (uint b = 0; b < bins && pairs > 0.; b++)
+    {
+        const double expected = (volume > 0.)
+                                    ? pairs * (boxDistanceCDF((b + 1) / invWidth, volume) - boxDistanceCDF(b / invWidth, volume))
+                                    : pairs * (sphereDistanceCDF((b + 1) / invWidth, L) - sphereDistanceCDF(b / invWidth, L));
+        g[b] = (expected > 0.) ? counts[b] / expected : 0.;
+    }
+
+    return g;
+}
+
+/**************************************************************************************
+ * Saves columns r, g(r) and the mean number of neighbours closer than r + dr / 2.
+ * @param char* filename in `Out` folder.
+ * @return True if the file is written.
+ *************************************************************************************/
+bool PairCorrelation::save(const char *filename) const
+{
+    std::ofstream ofile("../Out/" + std::string(filename), std::ios::out);
+    ofile << std::fixed << std::setprecision(5);
+
+    const std::vector<double> g = normalized();
+    const double atoms = static_cast<double>(N) * std::max(frames, 1u);
+    uint64_t cumulative = 0;
+
+    for (uint b = 0; b < bins; b++)
+    {
+        cumulative += counts[b];
+        ofile << (b + 0.5) / invWidth << '\t' << g[b] << '\t' << 2. * cumulative / atoms << '\n';
+    }
+
+    return ofile.good();
+}
+
+/**************************************************************************************
+ * Static structure factor from g(r):
+ *     S(q) = 1 + 4 pi rho int_0^rMax r^2 (g(r) - 1) sin(q r) / (q r) W(r) dr,
+ * with rho = (N - 1) / (4/3 pi L^3) (or (N - 1) / Vol of the periodic box) and the
+ * Lorch window W(r) = sin(pi r / rMax) / (pi r / rMax) which damps ripples from the
+ * truncation at rMax. Wave vectors are q = k pi / rMax for k = 1 ... bins (up to the
+ * Nyquist limit of the bin width).
+ * @param char* filename in `Out` folder.
+ * @return True if the file is written.
+ *************************************************************************************/
+bool PairCorrelation::saveStructureFactor(const char *filename) const
+{
+    std::ofstream ofile("../Out/" + std::string(filename), std::ios::out);
+    ofile << std::fixed << std::setprecision(5);
+
+    const std::vector<double> g = normalized();
+    const double rho = (volume > 0.) ? (N - 1.) / volume : (N - 1.) / (4. / 3. * M_PI * L * L * L);
+    const double dr = 1. / invWidth;
+
+    for (uint k = 1; k <= bins; k++)
+    {
+        const double q = k * M_PI / rMax;
+        double integral = 0.;
+
+        for (uint b = 0; b < bins; b++)
+        {
+            const double r = (b + 0.5) * dr;
+            const double window = std::sin(M_PI * r / rMax) / (M_PI * r / rMax);
+            integral += r * r * (g[b] - 1.) * std::sin(q * r) / (q * r) * window * dr;
+        }
+
+        ofile << q << '\t' << 1. + 4. * M_PI * rho * integral << '\n';
+    }
+
+    return ofile.good();
+}
@@ -0,0 +1,56 @@
+#ifndef RDF_H
+#define RDF_H
+#include <cstdint>
+#include <vector>
+#include "vectors.h"
+#include "neighbors.h"
+typedef unsigned int uint;
+
+/// Radial distribution function g(r) accumulated over frames of the simulation. Pairs
+/// closer than rMax are taken from the Verlet list of the force pass (if rMax <= rc) or
+/// found in the own linked-cell grid. The histogram is normalised by the distribution
+/// of distances of two points placed uniformly in the sphere of radius L
+///     P(r) = 3 r^2 / L^3 (1 - 3 r / (4 L) + r^3 / (16 L^3)), 0 <= r <= 2 L,
+/// so g(r) = 1 for the gas filling the whole container. In the periodic box pairs of
+/// the nearest images are uniform in the volume, P(r) = 4 pi r^2 / Vol (r below half of
+/// the shortest edge), and they are taken only from the Verlet list with ghosts.
+class PairCorrelation
+{
+private:
+    /// Parameters of the histogram
+    uint N;          ///< Number of atoms
+    double rMax;     ///< Largest distance of the histogram
+    uint bins;       ///< Number of bins
+    double L;        ///< Radius of the confining sphere
+    double volume;   ///< Volume of the periodic box (0 means the sphere)
+    double invWidth; ///< Inverse width of the bin
+
+    std::vector<uint64_t> counts; ///< Number of pairs in every bin
+    uint frames;                  ///< Number of accumulated frames
+
+    /// Linked-cell grid used without the Verlet list
+    uint nc;                ///< Number of cells along the grid edge
+    double cellSize;        ///< Edge of the single cell
+    std::vector<uint> head; ///< First atom in every cell (N means empty cell)
+    std::vector<uint> next; ///< Next atom in the same cell (N means end of the chain)
+
+    uint cellIndex(const double &x) const noexcept;
+
+public:
+    PairCorrelation() noexcept;
+
+    void setup(const uint &N, const double &rMax, const uint &bins, const double &L);
+    void setPeriodic(const double &volume) noexcept;
+    void accumulate(const Vectors &r, const NeighborList &list) noexcept;
+    void accumulate(const Vectors &r) noexcept;
+    void restore(const std::vector<uint64_t> &counts, const uint &frames);
+    std::vector<double> normalized() const;
+    bool save(const char *filename) const;
+    bool saveStructureFactor(const char *filename) const;
+
+    uint getBins() const noexcept { return bins; }
+    uint getFrames() const noexcept { return frames; }
+    const std::vector<uint64_t> &getCounts() const noexcept { return counts; }
+};
+
+#endif // RDF_H
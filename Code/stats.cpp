@@ -1,84 +1,205 @@
 #define _USE_MATH_DEFINES
 #include "stats.h"
+#include "profile.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <iomanip>
-#include <cmath>
 #include <sstream>
 #include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    constexpr uint DefaultBins = 25;    ///< Number of bins if the range is chosen from the first frame
+    constexpr double RangeMargin = 1.25; ///< Upper limit of the automatic range relative to the largest momentum of the first frame
+    constexpr uint64_t MaxBar = 60;     ///< Longest row of stars in the histogram file
+} // namespace
 
-Stats::Stats() noexcept : low(0.), up(0.), underflow(0), overflow(0), bins(0), maxStarsIndex(0), maxStars(0),
-                          distributionMean(0.), distributionMeanSq(0.), distributionSigma(0.), N(0), T(0.), k(0.),
-                          m(0.), pProEmp(0.), pMeanEmp(0.), pMeanSqEmp(0.), pProMB(0.), pMeanMB(0.), pMeanSqMB(0.),
-                          EkEmp(0.), EkMB(0.)
+Stats::Stats() noexcept : low(0.), up(0.), invWidth(0.), underflow(0), overflow(0), bins(0), maxStarsIndex(0),
+                          maxStars(0), samples(0), frames(0), distributionMean(0.), distributionMeanSq(0.),
+                          distributionM2(0.), distributionSigma(0.), T(0.), k(0.), m(0.), pProEmp(0.), pMeanEmp(0.),
+                          pMeanSqEmp(0.), pProMB(0.), pMeanMB(0.), pMeanSqMB(0.), EkEmp(0.), EkMB(0.)
 {
-    binRanges = new double[bins + 1]();
-    stars = new std::string[bins]();
-    pAbs = new double[N]();
+    counts = new uint64_t[bins]();
+    sums = new double[bins]();
 }
 
 Stats::~Stats() noexcept
 {
-    delete[] binRanges;
-    delete[] stars;
-    delete[] pAbs;
+    delete[] counts;
+    delete[] sums;
 }
 
-void Stats::evaluateHist(const char *histFilename)
+/**************************************************************************************
+ * Sets the fixed range of the histogram and discards accumulated frames. Without
+ * this call the range is [0, 1.25 max|p|] of the first accumulated frame.
+ * @param double minimum value of the histogram range,
+ * @param double maximum value of the histogram range,
+ * @param uint number of bins.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Stats::setStats(const double &Low, const double &Up, const uint &Bins)
+{
+    if (Bins < 1 || !(Up > Low))
+        throw std::invalid_argument("Invalid argument: histogram range. Must be Low < Up and at least one bin.");
+
+    low = Low;
+    up = Up;
+    bins = Bins;
+    invWidth = bins / (up - low);
+
+    delete[] counts;
+    delete[] sums;
+    counts = new uint64_t[bins]();
+    sums = new double[bins]();
+
+    reset();
+}
+
+/**************************************************************************************
+ * Sets constants of the Maxwell-Boltzmann distribution.
+ * @param double Boltzmann constant,
+ * @param double mass of the single particle.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Stats::setSystem(const double &K, const double &M) noexcept
 {
-    // Calculate range of histogram and its bins
-    const double histRange = std::abs(low - up);
-    const double binRange = histRange / bins;
+    k = K;
+    m = M;
+}
+
+/**************************************************************************************
+ * Discards accumulated frames, the range of the histogram stays.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Stats::reset() noexcept
+{
+    std::fill(counts, counts + bins, 0);
+    std::fill(sums, sums + bins, 0.);
+
+    underflow = overflow = samples = 0;
+    frames = 0;
+    distributionMean = distributionMeanSq = distributionM2 = 0.;
+    T = 0.;
+}
 
-    // Set bin ranges
-    binRanges[0] = low;
-    binRanges[bins] = up;
+/**************************************************************************************
+ * Adds the single frame of momenta. The bin is computed directly from the value. Mean,
+ * mean square and sum of squared deviations of the frame are merged with the previous
+ * frames by the pairwise Welford update, so the cost is O(N) and memory is fixed.
+ * @param double* absolute values of momenta,
+ * @param uint number of particles,
+ * @param double temperature of the frame.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Stats::accumulate(const double *pAbs, const uint &N, const double &TFrame)
+{
+    ARGON_PROFILE_SCOPE(Phase::Histogram);
+
+    if (N == 0)
+        return;
+
+    if (bins == 0)
+        setStats(0., std::max(1., std::ceil(RangeMargin * *std::max_element(pAbs, pAbs + N))), DefaultBins);
 
-    for (int i = 1; i < bins; i++)
-        binRanges[i] = binRanges[i - 1] + binRange;
+    double sum = 0., sumSq = 0.;
 
-    // Count how many particles are in the specific momentum range
-    for (int i = 0; i < N; i++)
+    // Bins are (low + j w; low + (j + 1) w], the value `low` itself belongs to the first one
+    for (uint i = 0; i < N; i++)
     {
-        if (pAbs[i] < low)
+        const double x = pAbs[i];
+
+        if (x < low)
         {
             ++underflow;
         }
-        else if (pAbs[i] > up)
+        else if (x > up)
         {
             ++overflow;
         }
         else
         {
-            for (int j = 0; j < bins; j++)
-            {
-                if (pAbs[i] > binRanges[j] && pAbs[i] <= binRanges[j + 1])
-                {
-                    stars[j] += '*';
-                    break;
-                }
-            }
+            const uint j = std::min(bins, std::max(1u, static_cast<uint>(std::ceil((x - low) * invWidth)))) - 1;
+            ++counts[j];
+            sums[j] += x;
         }
 
-        // Accumulate momentum to calculate distribution mean value
-        distributionMean += pAbs[i];
-        distributionMeanSq += pAbs[i] * pAbs[i];
+        sum += x;
+        sumSq += x * x;
     }
 
-    distributionMean /= N;
-    distributionMeanSq = std::sqrt(distributionMeanSq / N);
+    const double meanFrame = sum / N;
+    double M2Frame = 0.;
+
+    for (uint i = 0; i < N; i++)
+        M2Frame += (pAbs[i] - meanFrame) * (pAbs[i] - meanFrame);
+
+    // Merge of the frame with accumulated samples (Chan et al.)
+    const double na = samples, nb = N, n = na + nb;
+    const double delta = meanFrame - distributionMean;
+
+    distributionMean += delta * nb / n;
+    distributionMeanSq += (sumSq / N - distributionMeanSq) * nb / n;
+    distributionM2 += M2Frame + delta * delta * na * nb / n;
+
+    samples += N;
+    frames++;
+    T += (TFrame - T) / frames;
+}
+
+/**************************************************************************************
+ * Empirical and Maxwell-Boltzmann values from the accumulated frames. The most
+ * probable momentum is the mean of the samples in the most populated bin.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Stats::evaluate() noexcept
+{
+    maxStarsIndex = 0;
+    maxStars = 0;
+
+    for (uint j = 0; j < bins; j++)
+    {
+        if (counts[j] > maxStars)
+        {
+            maxStarsIndex = j;
+            maxStars = counts[j];
+        }
+    }
+
+    distributionSigma = std::sqrt(distributionM2 / samples);
+
+    pProMB = std::sqrt(2. * k * T * m);
+    pMeanMB = std::sqrt(8. * k * T * m / M_PI);
+    pMeanSqMB = std::sqrt(3. * k * T * m);
+    EkMB = 3. / 2. * k * T;
+
+    pProEmp = (maxStars > 0) ? sums[maxStarsIndex] / maxStars : 0.;
+    pMeanEmp = distributionMean;
+    pMeanSqEmp = std::sqrt(distributionMeanSq);
+    EkEmp = pMeanEmp * pMeanEmp / (2. * m);
+}
+
+void Stats::evaluateHist(const char *histFilename)
+{
+    ARGON_PROFILE_SCOPE(Phase::Histogram);
 
-    // Calculate standard deviation of momentum
-    for (int i = 0; i < N; i++)
-        distributionSigma += (pAbs[i] - distributionMean) * (pAbs[i] - distributionMean);
+    if (samples == 0)
+    {
+        std::cerr << "`evaluateHist()` :> No frames accumulated, histogram " << histFilename << " is not saved.\n";
+        return;
+    }
 
-    distributionSigma = std::sqrt(distributionSigma / N);
+    evaluate();
 
     std::ofstream histOfile("../Out/" + std::string(histFilename), std::ios::out);
     histOfile << std::fixed << std::setprecision(5); // << std::showpos
 
     // Print evaluated histogram with its basic statistics
     histOfile << "Momentum Distribution:\n\n";
+    histOfile << "Frames:       " << frames << '\n';
+    histOfile << "Samples:      " << samples << '\n';
     histOfile << "Bins:         " << bins << '\n';
     histOfile << "Low:          " << low << '\n';
     histOfile << "Up:           " << up << '\n';
@@ -86,50 +207,35 @@ void Stats::evaluateHist(const char *histFilename)
     histOfile << "Overflow:     " << overflow << '\n';
     histOfile << "Mean:         " << distributionMean << '\n';
     histOfile << "StdDev:       " << distributionSigma << '\n';
+    histOfile << "Temperature:  " << T << '\n';
     histOfile << '\n';
 
     // Create caption with bin range e.g (+0.123; +0.456]:
+    const double width = (up - low) / bins;
     std::stringstream binRangeS;
     binRangeS << std::fixed << std::setprecision(2); // << std::showpos
-    binRangeS << "(" << binRanges[bins - 1] << "; " << binRanges[bins] << "]: ";
+    binRangeS << "(" << up - width << "; " << up << "]: ";
     // Calculate maximum length of binRangeS string
     usint captionLen = binRangeS.str().length();
     binRangeS.str("");
 
+    // Rows of stars are scaled if the most populated bin does not fit in `MaxBar` columns
+    const int countLen = std::max<int>(3, std::to_string(maxStars).length());
+    const double scale = (maxStars > MaxBar) ? static_cast<double>(MaxBar) / maxStars : 1.;
+
     // Print histogram of particles momentum
-    for (int i = 0; i < bins; i++)
+    for (uint i = 0; i < bins; i++)
     {
-        binRangeS << "(" << binRanges[i] << "; " << binRanges[i + 1] << "]: ";
-        histOfile << std::setw(captionLen - binRangeS.str().length() + 1) << "(" << binRanges[i] << "; " << binRanges[i + 1] << "]: ";
-        histOfile << std::setw(3) << stars[i].length() << ' ' << stars[i] << '\n';
+        const double left = low + i * width;
+        const double right = (i + 1 == bins) ? up : low + (i + 1) * width;
 
-        if (stars[i].length() > maxStars)
-        {
-            maxStarsIndex = i;
-            maxStars = stars[i].length();
-        }
+        binRangeS << "(" << left << "; " << right << "]: ";
+        histOfile << std::setw(captionLen - binRangeS.str().length() + 1) << "(" << left << "; " << right << "]: ";
+        histOfile << std::setw(countLen) << counts[i] << ' ' << std::string(std::lround(counts[i] * scale), '*') << '\n';
 
         binRangeS.str("");
     }
 
-    pProMB = std::sqrt(2. * k * T * m);
-    pMeanMB = std::sqrt(8. * k * T * m / M_PI);
-    pMeanSqMB = std::sqrt(3. * k * T * m);
-    EkMB = 3. / 2. * k * T;
-
-    for (usint i = 0; i < N; i++)
-    {
-        if (pAbs[i] > binRanges[maxStarsIndex] && pAbs[i] <= binRanges[maxStarsIndex + 1])
-        {
-            pProEmp += pAbs[i];
-        }
-    }
-
-    pProEmp /= maxStars;
-    pMeanEmp = distributionMean;
-    pMeanSqEmp = distributionMeanSq;
-    EkEmp = pMeanEmp * pMeanEmp / (2. * m);
-
     histOfile << std::fixed << std::setprecision(5);
     histOfile << '\n';
     histOfile << "pProMB:       " << pProMB << '\t' << "Most probable momentum obtained analytically.\n";
@@ -152,39 +258,92 @@ void Stats::evaluateHist(const char *histFilename)
     histOfile.close();
 }
 
-void Stats::setInputFromArgon(const double *pAbsArgon, const usint &NArgon, const double &TArgon, const double &KArgon, const double &MArgon)
+/**************************************************************************************
+ * Statistics of the single snapshot of momenta. The range of the histogram spans
+ * the momenta rounded to integers.
+ * @param double* absolute values of momenta,
+ * @param uint number of particles,
+ * @param double temperature,
+ * @param double Boltzmann constant,
+ * @param double mass of the single particle.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Stats::setInputFromArgon(const double *pAbsArgon, const uint &NArgon, const double &TArgon, const double &KArgon, const double &MArgon)
 {
-    N = NArgon;
-    T = TArgon;
-    k = KArgon;
-    m = MArgon;
+    const auto range = std::minmax_element(pAbsArgon, pAbsArgon + NArgon);
 
-    delete[] pAbs;
-    pAbs = new double[N];
+    setStats(std::floor(*range.first), std::max(std::ceil(*range.second), std::floor(*range.first) + 1.), DefaultBins);
+    setSystem(KArgon, MArgon);
+    accumulate(pAbsArgon, NArgon, TArgon);
+}
 
-    low = pAbsArgon[0];
+/**************************************************************************************
+ * Errors of the empirical values from the last `evaluate()` (or histogram) with
+ * respect to the Maxwell-Boltzmann distribution (the same as in the histogram file).
+ * @return std::tuple<double, double, double, double> - errors (%) of the most probable
+ * momentum, mean momentum, mean square momentum and mean kinetic energy.
+ *************************************************************************************/
+std::tuple<double, double, double, double> Stats::getErrors() const noexcept
+{
+    return std::make_tuple(std::abs(pProEmp - pProMB) / pProMB * 100., std::abs(pMeanEmp - pMeanMB) / pMeanMB * 100.,
+                           std::abs(pMeanSqEmp - pMeanSqMB) / pMeanSqMB * 100., std::abs(EkEmp - EkMB) / EkMB * 100.);
+}
 
-    for (usint i = 0; i < N; i++)
-    {
-        pAbs[i] = pAbsArgon[i];
+/**************************************************************************************
+ * Saves the range of the histogram and all accumulated frames to the checkpoint.
+ * @param Checkpoint opened checkpoint.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Stats::write(Checkpoint &chk) const noexcept
+{
+    chk.write(low);
+    chk.write(up);
+    chk.write(bins);
 
-        if (pAbs[i] > up)
-        {
-            up = pAbs[i];
-        }
-        else if (pAbs[i] < low)
-        {
-            low = pAbs[i];
-        }
-    }
+    for (uint j = 0; j < bins; j++)
+        chk.write(counts[j]);
 
-    low = floor(low);
-    up = ceil(up);
-    bins = 25; // static_cast<usint>(up - low);
+    chk.write(sums, bins);
+    chk.write(underflow);
+    chk.write(overflow);
+    chk.write(samples);
+    chk.write(frames);
+    chk.write(distributionMean);
+    chk.write(distributionMeanSq);
+    chk.write(distributionM2);
+    chk.write(T);
+}
 
-    delete[] binRanges;
-    binRanges = new double[bins + 1]();
+/**************************************************************************************
+ * Restores the state saved by `write()`, including the range chosen from the first
+ * frame, so frames after the restart go to the same bins.
+ * @param Checkpoint opened checkpoint.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Stats::read(Checkpoint &chk)
+{
+    double Low = 0., Up = 0.;
+    uint Bins = 0;
 
-    delete[] stars;
-    stars = new std::string[bins]();
-}
\ No newline at end of file
+    chk.read(Low);
+    chk.read(Up);
+    chk.read(Bins);
+
+    if (chk.ok() && Bins > 0 && Up > Low)
+        setStats(Low, Up, Bins);
+    else
+        reset();
+
+    for (uint j = 0; j < Bins && j < bins; j++)
+        chk.read(counts[j]);
+
+    chk.read(sums, std::min(Bins, bins));
+    chk.read(underflow);
+    chk.read(overflow);
+    chk.read(samples);
+    chk.read(frames);
+    chk.read(distributionMean);
+    chk.read(distributionMeanSq);
+    chk.read(distributionM2);
+    chk.read(T);
+}
@@ -1,33 +1,42 @@
 #ifndef STATS_H
 #define STATS_H
-#include <string>
+#include <cstdint>
+#include <tuple>
+#include "checkpoint.h"
 typedef unsigned short int usint;
+typedef unsigned int uint;
 
+/// Momentum statistics accumulated online over many frames of the simulation. Every frame
+/// updates the histogram (constant time per sample) and the moments merged by Welford's
+/// method, so memory does not depend on the number of frames and trajectories are neither
+/// stored nor read again.
 class Stats
 {
 private:
     /// Variables related to histogram printing
     double low;          ///< Minimum value of the histogram range
     double up;           ///< Maximum value of the histogram range
-    usint underflow;     ///< Number of samples under minimum value `low`
-    usint overflow;      ///< Number of samples overmaximum value `up`
-    usint bins;          ///< Number of bins in the histogram
-    usint maxStarsIndex; ///< Index of `binRanges` where is the most counts
-    usint maxStars;      ///< Number of max counts in the `binRanges`
-    double *binRanges;   ///< 1D array with ranges of the histogram
-    std::string *stars;  ///< 1D array with the stars '*' to visualise histogram
+    double invWidth;     ///< Inverse width of the bin
+    uint64_t underflow;  ///< Number of samples under minimum value `low`
+    uint64_t overflow;   ///< Number of samples over maximum value `up`
+    uint bins;           ///< Number of bins in the histogram
+    uint maxStarsIndex;  ///< Index of the bin where is the most counts
+    uint64_t maxStars;   ///< Number of max counts in the bins
+    uint64_t *counts;    ///< 1D array with counts of samples in every bin
+    double *sums;        ///< 1D array with sums of samples in every bin (most probable momentum)
 
     /// Variables related to histogram statistics
+    uint64_t samples;          ///< Number of accumulated samples
+    uint frames;               ///< Number of accumulated frames
     double distributionMean;   ///< Mean value of the distribution
     double distributionMeanSq; ///< Mean squared value of the distribution
+    double distributionM2;     ///< Sum of squared deviations from the mean (Welford)
     double distributionSigma;  ///< Standard deviation of the distribution
 
     /// Variables related to the system
-    double *pAbs; ///< Absolute value of the particles momentum evaluated by Argon library
-    usint N;      ///< Number of particles
-    double T;     ///< Temperature evaluated by Argon library
-    double k;     ///< Boltzmann constant
-    double m;     ///< Mass of the single particle
+    double T; ///< Mean temperature of the accumulated frames
+    double k; ///< Boltzmann constant
+    double m; ///< Mass of the single particle
 
     /// Variables related to Maxwell-Boltzmann statistics
     double pProEmp;    ///< Most probable momentum obtained empirically from argon library
@@ -39,13 +48,22 @@ private:
     double EkEmp;      ///< Kinetic energy from ordinary Newton formula
     double EkMB;       ///< Kinetic energy from kinetic theory of gases
 
+    void reset() noexcept;
+
 public:
     Stats() noexcept;
     ~Stats() noexcept;
 
-    void setStats(const double &Low, const double &Up, const usint &Bins);
+    void setStats(const double &Low, const double &Up, const uint &Bins);
+    void setSystem(const double &K, const double &M) noexcept;
+    void accumulate(const double *pAbs, const uint &N, const double &T);
+    void evaluate() noexcept;
     void evaluateHist(const char *histFilename);
-    void setInputFromArgon(const double *pAbs, const usint &N, const double &T, const double &K, const double &M);
+    void setInputFromArgon(const double *pAbs, const uint &N, const double &T, const double &K, const double &M);
+    uint getFrames() const noexcept { return frames; }
+    std::tuple<double, double, double, double> getErrors() const noexcept;
+    void write(Checkpoint &chk) const noexcept;
+    void read(Checkpoint &chk);
 };
 
-#endif // STATS_H
\ No newline at end of file
+#endif // STATS_H
@@ -0,0 +1,108 @@
+#include "table.h"
+#include <algorithm>
+#include <cmath>
+
+PairTable::PairTable() noexcept : s0(0.), s1(0.), invDs(0.), size(0), core{}
+{
+}
+
+/**************************************************************************************
+ * Tabulates the potential on `size` intervals of s = r^2 from s0 to s1. On the interval
+ * [s_k, s_k + h] with t = (s - s_k) / h the Hermite polynomial matching V and h dV/ds
+ * at both ends is
+ *     V = V0 + h d0 t + (3 (V1 - V0) - h (2 d0 + d1)) t^2 + (2 (V0 - V1) + h (d0 + d1)) t^3.
+ * @param PairPotential potential V(s) with the derivative dV/ds,
+ * @param double lowest r^2 of the table,
+ * @param double cutoff r^2,
+ * @param uint number of intervals.
+ * @return Nothing to return.
+ *************************************************************************************/
+void PairTable::build(const PairPotential &potential, const double &sMin, const double &sMax, const uint &intervals)
+{
+    s0 = sMin;
+    s1 = sMax;
+    size = intervals;
+
+    const double h = (s1 - s0) / size;
+    invDs = 1. / h;
+
+    // One more interval, so rounding of s just below s1 never reads past the table
+    coeff.assign(4 * (size + 1), 0.);
+
+    double d0;
+    double V0 = potential(s0, d0);
+
+    for (uint k = 0; k < size; k++)
+    {
+        double d1;
+        const double V1 = potential(s0 + (k + 1) * h, d1);
+        double *c = coeff.data() + 4 * k;
+
+        c[0] = V0;
+        c[1] = h * d0;
+        c[2] = 3. * (V1 - V0) - h * (2. * d0 + d1);
+        c[3] = 2. * (V0 - V1) + h * (d0 + d1);
+
+        V0 = V1;
+        d0 = d1;
+    }
+
+    std::copy(coeff.end() - 8, coeff.end() - 4, coeff.end() - 4);
+}
+
+/**************************************************************************************
+ * Compares the table with the potential at 16 points inside every interval. Errors
+ * are relative, but near zeros of V and F they are related to the natural scales
+ * e and e / R.
+ * @param PairPotential tabulated potential,
+ * @param double minimum of the potential,
+ * @param double distance of the minimum.
+ * @return TableError with the largest errors of the potential and force.
+ *************************************************************************************/
+TableError PairTable::error(const PairPotential &potential, const double &e, const double &R) const
+{
+    TableError error{0., 0.};
+    const uint samples = 16 * size;
+    const double h = (s1 - s0) / samples;
+
+    for (uint q = 0; q < samples; q++)
+    {
+        const double s = s0 + (q + 0.5) * h;
+        const double r = std::sqrt(s);
+
+        double dV, Fr;
+        const double V = potential(s, dV);
+        const double Vt = interpolate(s, Fr);
+
+        // Force along the pair is Fr r = -2 r dV/ds
+        const double F = -2. * r * dV;
+        const double Ft = Fr * r;
+
+        error.V = std::max(error.V, std::abs(Vt - V) / std::max(std::abs(V), e));
+        error.F = std::max(error.F, std::abs(Ft - F) / std::max(std::abs(F), e / R));
+    }
+
+    return error;
+}
+
+/**************************************************************************************
+ * Lennard-Jones potential (9) as a function of s = r^2 with x = (R^2 / s)^3:
+ * V = e x (x - 2) - Vc, dV/ds = -6 e x (x - 1) / s.
+ * @param double minimum of the potential,
+ * @param double distance of the minimum,
+ * @param double shift of the potential (value at the cutoff).
+ * @return PairPotential for `PairTable::build()`.
+ *************************************************************************************/
+PairPotential lennardJones(const double &e, const double &R, const double &Vc)
+{
+    const double R2 = R * R;
+
+    return [e, R2, Vc](const double &s, double &dV)
+    {
+        const double y = R2 / s;
+        const double x = y * y * y;
+
+        dV = -6. * e * x * (x - 1.) / s;
+        return e * x * (x - 2.) - Vc;
+    };
+}
@@ -0,0 +1,64 @@
+#ifndef TABLE_H
+#define TABLE_H
+#include <functional>
+#include <vector>
+#include "kernels.h"
+typedef unsigned int uint;
+
+/// Pair potential as a function of s = r^2: returns V(s) and sets `dV` to dV/ds
+typedef std::function<double(const double &s, double &dV)> PairPotential;
+
+/// Largest errors of the table with respect to the tabulated potential
+struct TableError
+{
+    double V; ///< Error of the potential relative to |V| (but at least to the well depth e)
+    double F; ///< Error of the force relative to |F| (but at least to e / R)
+};
+
+/// Pair potential tabulated on the uniform grid of s = r^2 in [s0, s1] and interpolated
+/// by cubic Hermite polynomials from values and derivatives at the nodes, so the kernels
+/// need neither sqrt nor division. Forces are derivatives of the same polynomials,
+/// F / r = -2 dV/ds, so the interpolated forces are conservative. Every interval stores
+/// 4 coefficients next to each other (a single cache line holds two intervals).
+/// Pairs closer than s0 use the analytic formula (9) with `core` parameters and pairs
+/// at s >= s1 do not interact.
+class PairTable
+{
+private:
+    double s0;                 ///< Lowest r^2 of the table
+    double s1;                 ///< Cutoff r^2 (end of the table)
+    double invDs;              ///< Inverse width of the interval
+    uint size;                 ///< Number of intervals
+    std::vector<double> coeff; ///< Coefficients c0, c1, c2, c3 of every interval (V = c0 + c1 t + c2 t^2 + c3 t^3)
+    PairParams core;           ///< Parameters of the analytic potential for r^2 < s0
+
+public:
+    PairTable() noexcept;
+
+    void build(const PairPotential &potential, const double &s0, const double &s1, const uint &size);
+    void setCore(const PairParams &pp) noexcept { core = pp; }
+    TableError error(const PairPotential &potential, const double &e, const double &R) const;
+
+    /// Potential at s = r^2 from [s0, s1), `Fr` is set to the force divided by the distance
+    double interpolate(const double &s, double &Fr) const noexcept
+    {
+        const double u = (s - s0) * invDs;
+        const uint k = static_cast<uint>(u);
+        const double t = u - k;
+        const double *c = coeff.data() + 4 * k;
+
+        Fr = -2. * invDs * ((3. * c[3] * t + 2. * c[2]) * t + c[1]);
+        return ((c[3] * t + c[2]) * t + c[1]) * t + c[0];
+    }
+
+    double getS0() const noexcept { return s0; }
+    double getS1() const noexcept { return s1; }
+    double getInvDs() const noexcept { return invDs; }
+    uint getSize() const noexcept { return size; }
+    const double *coefficients() const noexcept { return coeff.data(); }
+    const PairParams &getCore() const noexcept { return core; }
+};
+
+PairPotential lennardJones(const double &e, const double &R, const double &Vc);
+
+#endif // TABLE_H
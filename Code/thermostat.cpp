@@ -0,0 +1,279 @@
+#include "thermostat.h"
+#include "philox.h"
+#include "profile.h"
+#include <algorithm>
+#include <cmath>
+
+Thermostat::Thermostat() noexcept : kind(ThermostatKind::None), kT(0.), tauT(0.), dof(0.), m(0.), N(0), seed(0), stream(0)
+{
+}
+
+/**************************************************************************************
+ * Prepares the thermostat and the empty Nose-Hoover chain.
+ * @param ThermostatKind method of temperature control,
+ * @param double target temperature,
+ * @param double Boltzmann constant,
+ * @param double coupling time,
+ * @param uint number of thermostats of the Nose-Hoover chain,
+ * @param uint number of atoms,
+ * @param double mass of the single atom,
+ * @param uint64_t seed of the Philox generator,
+ * @param uint32_t stream of random numbers,
+ * @param uint number of threads (and of blocks of atoms).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Thermostat::setup(const ThermostatKind &method, const double &T, const double &k, const double &tauCoupling,
+                       const uint &chainLength, const uint &NAtoms, const double &mass, const uint64_t &newSeed,
+                       const uint32_t &newStream, const uint &threads)
+{
+    kind = method;
+    kT = k * T;
+    tauT = tauCoupling;
+    N = NAtoms;
+    dof = 3. * N;
+    m = mass;
+    seed = newSeed;
+    stream = newStream;
+
+    const uint M = (kind == ThermostatKind::NoseHoover) ? chainLength : 0;
+
+    Q.assign(M, kT * tauT * tauT);
+    xi.assign(M, 0.);
+    vxi.assign(M, 0.);
+
+    if (M > 0)
+        Q[0] *= dof;
+
+    kinetic.assign(std::max(threads, 1u), 0.);
+}
+
+/**************************************************************************************
+ * Thermostat over the first half of the step (Nose-Hoover chain).
+ * @param Vectors momenta of atoms,
+ * @param double integration step,
+ * @param double kinetic energy of momenta (updated).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Thermostat::before(Vectors &p, const double &dt, double &Ek) noexcept
+{
+    if (kind != ThermostatKind::NoseHoover)
+        return;
+
+    ARGON_PROFILE_SCOPE(Phase::Thermostat);
+    chain(p, 0.5 * dt, Ek);
+}
+
+/**************************************************************************************
+ * Thermostat over the second half of the step (Nose-Hoover chain), other methods over
+ * the whole step. Ek has to be the kinetic energy at the end of the step.
+ * @param Vectors momenta of atoms,
+ * @param double integration step,
+ * @param double kinetic energy of momenta (updated),
+ * @param uint64_t index of the step.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Thermostat::after(Vectors &p, const double &dt, double &Ek, const uint64_t &step) noexcept
+{
+    ARGON_PROFILE_SCOPE(Phase::Thermostat);
+
+    // Kinetic energy of the target temperature
+    const double target = 0.5 * dof * kT;
+
+    switch (kind)
+    {
+    case ThermostatKind::Rescale:
+        if (Ek > 0.)
+            scale(p, std::sqrt(target / Ek), Ek);
+        break;
+    case ThermostatKind::Berendsen:
+        // Large corrections of the first steps are limited as in common MD codes
+        if (Ek > 0.)
+            scale(p, std::clamp(std::sqrt(1. + dt / tauT * (target / Ek - 1.)), 0.8, 1.25), Ek);
+        break;
+    case ThermostatKind::NoseHoover:
+        chain(p, 0.5 * dt, Ek);
+        break;
+    case ThermostatKind::Langevin:
+        friction(p, dt, Ek, step);
+        break;
+    default:
+        break;
+    }
+}
+
+/**************************************************************************************
+ * Energy of the Nose-Hoover chain, H plus this energy is conserved by the dynamics:
+ *     sum_j Q_j vxi_j^2 / 2 + 3N kT xi_1 + kT sum_{j > 1} xi_j.
+ * @return Energy of thermostats (0 for other methods).
+ *************************************************************************************/
+double Thermostat::energy() const noexcept
+{
+    double E = 0.;
+
+    for (uint j = 0; j < Q.size(); j++)
+        E += 0.5 * Q[j] * vxi[j] * vxi[j] + ((j == 0) ? dof : 1.) * kT * xi[j];
+
+    return E;
+}
+
+/**************************************************************************************
+ * Force acting on the thermostat j of the chain. The first one is driven by the
+ * difference of the kinetic energy from its target, the next ones by the kinetic
+ * energy of the previous thermostat.
+ * @param uint index of the thermostat,
+ * @param double kinetic energy of atoms.
+ * @return Acceleration of the thermostat.
+ *************************************************************************************/
+inline double Thermostat::force(const uint &j, const double &Ek) const noexcept
+{
+    if (j == 0)
+        return (2. * Ek - dof * kT) / Q[0];
+
+    return (Q[j - 1] * vxi[j - 1] * vxi[j - 1] - kT) / Q[j];
+}
+
+/**************************************************************************************
+ * Propagates the Nose-Hoover chain over the time h (Martyna, Tuckerman, Klein 1996):
+ * velocities of thermostats are updated from the end of the chain to atoms, momenta
+ * are scaled by exp(-vxi_1 h) and the velocities are updated back. Every update of
+ * vxi_j is enclosed by scaling with exp(-vxi_{j+1} h / 4), so the step is reversible.
+ * @param Vectors momenta of atoms,
+ * @param double time of the propagation,
+ * @param double kinetic energy of momenta (updated).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Thermostat::chain(Vectors &p, const double &h, double &Ek) noexcept
+{
+    const uint M = Q.size();
+
+    vxi[M - 1] += 0.5 * h * force(M - 1, Ek);
+
+    for (uint j = M - 1; j-- > 0;)
+    {
+        const double damp = std::exp(-0.25 * h * vxi[j + 1]);
+        vxi[j] = (vxi[j] * damp + 0.5 * h * force(j, Ek)) * damp;
+    }
+
+    scale(p, std::exp(-h * vxi[0]), Ek);
+
+    for (uint j = 0; j < M; j++)
+        xi[j] += h * vxi[j];
+
+    for (uint j = 0; j + 1 < M; j++)
+    {
+        const double damp = std::exp(-0.25 * h * vxi[j + 1]);
+        vxi[j] = (vxi[j] * damp + 0.5 * h * force(j, Ek)) * damp;
+    }
+
+    vxi[M - 1] += 0.5 * h * force(M - 1, Ek);
+}
+
+/**************************************************************************************
+ * Exact solution of the Langevin friction and noise over the time h (Ornstein-Uhlenbeck
+ * process): p = c1 p + sqrt((1 - c1^2) m kT) g with c1 = exp(-h / tauT) and g normal.
+ * Kinetic energy is summed in fixed blocks of atoms as in the kick.
+ * @param Vectors momenta of atoms,
+ * @param double time of the propagation,
+ * @param double kinetic energy of momenta (updated),
+ * @param uint64_t index of the step (in the Philox counter).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Thermostat::friction(Vectors &p, const double &h, double &Ek, const uint64_t &step) noexcept
+{
+    const Philox philox(seed);
+    const double c1 = std::exp(-h / tauT);
+    const double c2 = std::sqrt((1. - c1 * c1) * m * kT);
+    const uint32_t high = static_cast<uint32_t>(step >> 32);
+    const uint32_t low = static_cast<uint32_t>(step);
+    const uint blocks = kinetic.size();
+
+#pragma omp parallel for num_threads(blocks) if (blocks > 1)
+    for (uint b = 0; b < blocks; b++)
+    {
+        const uint begin = N * b / blocks;
+        const uint end = N * (b + 1) / blocks;
+        double sum = 0.;
+
+        for (uint i = begin; i < end; i++)
+        {
+            double g[4];
+            philox.gaussians(i, high, stream, low, g);
+
+            p.x[i] = c1 * p.x[i] + c2 * g[0];
+            p.y[i] = c1 * p.y[i] + c2 * g[1];
+            p.z[i] = c1 * p.z[i] + c2 * g[2];
+            sum += p.x[i] * p.x[i] + p.y[i] * p.y[i] + p.z[i] * p.z[i];
+        }
+
+        kinetic[b] = sum;
+    }
+
+    Ek = 0.;
+
+    for (uint b = 0; b < blocks; b++)
+        Ek += kinetic[b];
+
+    Ek /= 2. * m;
+}
+
+/**************************************************************************************
+ * Multiplies all momenta by lambda.
+ * @param Vectors momenta of atoms,
+ * @param double factor,
+ * @param double kinetic energy of momenta (updated).
+ * @return Nothing to return.
+ *************************************************************************************/
+void Thermostat::scale(Vectors &p, const double &lambda, double &Ek) noexcept
+{
+    const uint blocks = kinetic.size();
+
+#pragma omp parallel for num_threads(blocks) if (blocks > 1)
+    for (uint i = 0; i < N; i++)
+    {
+        p.x[i] *= lambda;
+        p.y[i] *= lambda;
+        p.z[i] *= lambda;
+    }
+
+    Ek *= lambda * lambda;
+}
+
+/**************************************************************************************
+ * Saves the state of the Nose-Hoover chain (other methods have no state).
+ * @param Checkpoint opened checkpoint.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Thermostat::write(Checkpoint &chk) const noexcept
+{
+    chk.write(xi.data(), xi.size());
+    chk.write(vxi.data(), vxi.size());
+}
+
+/**************************************************************************************
+ * Restores the state saved by `write()`, the thermostat has to be set up with the
+ * same length of the chain.
+ * @param Checkpoint opened checkpoint.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Thermostat::read(Checkpoint &chk) noexcept
+{
+    chk.read(xi.data(), xi.size());
+    chk.read(vxi.data(), vxi.size());
+}
+
+const char *thermostatName(const ThermostatKind &kind) noexcept
+{
+    switch (kind)
+    {
+    case ThermostatKind::Rescale:
+        return "rescale";
+    case ThermostatKind::Berendsen:
+        return "berendsen";
+    case ThermostatKind::NoseHoover:
+        return "nosehoover";
+    case ThermostatKind::Langevin:
+        return "langevin";
+    default:
+        return "none";
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef THERMOSTAT_H
+#define THERMOSTAT_H
+#include <cstdint>
+#include <vector>
+#include "vectors.h"
+#include "checkpoint.h"
+typedef unsigned short int usint;
+typedef unsigned int uint;
+
+/// Available methods of temperature control
+enum class ThermostatKind : usint
+{
+    None,       ///< Microcanonical dynamics (NVE)
+    Rescale,    ///< Momenta rescaled to the target temperature after every step
+    Berendsen,  ///< Weak coupling, T relaxes to the target exponentially with the time tauT
+    NoseHoover, ///< Nose-Hoover chain, deterministic and time reversible canonical dynamics
+    Langevin,   ///< Friction 1/tauT and random kicks, stochastic canonical dynamics
+};
+
+/// Available methods of pressure control
+enum class BarostatKind : usint
+{
+    Off,       ///< Constant radius of the sphere
+    Berendsen, ///< Weak coupling of the radius to the pressure on the walls
+};
+
+/// Thermostat applied to momenta around the step of the integrator. The Nose-Hoover
+/// chain acts over half of the step before and after it (Trotter splitting), the other
+/// methods once after it: the exact Langevin friction and noise over the whole step
+/// repeated with velocity Verlet is OBABO with merged half steps, at the half cost of
+/// random numbers. Random numbers of Langevin are drawn from Philox for the counter
+/// (atom, high word of the step, stream, low word of the step), so the run does not
+/// depend on threads and restarts exactly.
+class Thermostat
+{
+private:
+    ThermostatKind kind; ///< Method of temperature control
+    double kT;           ///< Target temperature times the Boltzmann constant
+    double tauT;         ///< Coupling time (period of the chain, inverse friction of Langevin)
+    double dof;          ///< Number of degrees of freedom 3N
+    double m;            ///< Mass of the single atom
+    uint N;              ///< Number of atoms
+    uint64_t seed;       ///< Seed of the Philox generator (Langevin)
+    uint32_t stream;     ///< Stream of random numbers (third word of the Philox counter)
+
+    /// Nose-Hoover chain
+    std::vector<double> Q;   ///< Masses of thermostats, Q_1 = 3N kT tauT^2 and Q_j = kT tauT^2
+    std::vector<double> xi;  ///< Positions of thermostats
+    std::vector<double> vxi; ///< Velocities of thermostats
+
+    std::vector<double> kinetic; ///< Doubled kinetic energy of the blocks of atoms (Langevin)
+
+    double force(const uint &j, const double &Ek) const noexcept;
+    void chain(Vectors &p, const double &h, double &Ek) noexcept;
+    void friction(Vectors &p, const double &h, double &Ek, const uint64_t &step) noexcept;
+    void scale(Vectors &p, const double &lambda, double &Ek) noexcept;
+
+public:
+    Thermostat() noexcept;
+
+    void setup(const ThermostatKind &kind, const double &T, const double &k, const double &tauT, const uint &chainLength,
+               const uint &N, const double &m, const uint64_t &seed, const uint32_t &stream, const uint &threads);
+    void before(Vectors &p, const double &dt, double &Ek) noexcept;
+    void after(Vectors &p, const double &dt, double &Ek, const uint64_t &step) noexcept;
+    double energy() const noexcept;
+
+    void write(Checkpoint &chk) const noexcept;
+    void read(Checkpoint &chk) noexcept;
+
+    bool active() const noexcept { return kind != ThermostatKind::None; }
+    ThermostatKind getKind() const noexcept { return kind; }
+};
+
+const char *thermostatName(const ThermostatKind &kind) noexcept;
+
+#endif // THERMOSTAT_H
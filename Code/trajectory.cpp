@@ -0,0 +1,309 @@
+#include "trajectory.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    constexpr char Magic[8] = {'A', 'R', 'G', 'O', 'N', 'T', 'R', 'J'};
+    constexpr uint32_t Version = 1;
+    constexpr std::size_t StreamBuffer = 1 << 22; ///< 4 MB buffer of the output stream
+} // namespace
+
+TrajectoryWriter::TrajectoryWriter() noexcept : file(nullptr), header{}
+{
+}
+
+TrajectoryWriter::~TrajectoryWriter() noexcept
+{
+    close();
+}
+
+/**************************************************************************************
+ * Creates the binary trajectory file and writes its header.
+ * @param char* filename,
+ * @param TrajectoryFormat Float32 or Int16,
+ * @param uint number of atoms,
+ * @param double time between frames,
+ * @param double radius of the confining sphere.
+ * @return True if the file is ready to write.
+ *************************************************************************************/
+bool TrajectoryWriter::open(const char *filename, const TrajectoryFormat &format, const uint &N, const double &dt,
+                            const double &L)
+{
+    close();
+
+    file = std::fopen(filename, "wb");
+
+    if (file == nullptr)
+        return false;
+
+    fileBuffer.resize(StreamBuffer);
+    std::setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+
+    const std::size_t component = (format == TrajectoryFormat::Int16) ? sizeof(int16_t) : sizeof(float);
+
+    header = TrajectoryHeader{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.encoding = static_cast<uint32_t>(format);
+    header.N = N;
+    header.frameBytes = 3 * N * component;
+    header.frames = 0;
+    header.dt = dt;
+    header.L = L;
+    // Atoms may slightly leave the sphere, so the quantized range is [-2L, 2L]
+    header.scale = 2. * L / INT16_MAX;
+
+    frame.resize(header.frameBytes);
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    return true;
+}
+
+/**************************************************************************************
+ * Opens the existing binary trajectory to continue it after the given number of
+ * frames. Frames written after that are discarded (e.g. after restart from the
+ * checkpoint).
+ * @param char* filename,
+ * @param uint64_t number of frames to keep.
+ * @return True if the file is ready to write.
+ *************************************************************************************/
+bool TrajectoryWriter::append(const char *filename, const uint64_t &frames)
+{
+    close();
+
+    file = std::fopen(filename, "r+b");
+
+    if (file == nullptr)
+        return false;
+
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+        header.version != Version || header.frames < frames)
+    {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    fileBuffer.resize(StreamBuffer);
+    std::setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+
+    header.frames = frames;
+    frame.resize(header.frameBytes);
+    std::fseek(file, sizeof(TrajectoryHeader) + frames * header.frameBytes, SEEK_SET);
+
+    return true;
+}
+
+/**************************************************************************************
+ * Encodes positions and appends them as a new frame.
+ * @param Vectors positions of atoms.
+ * @return Nothing to return.
+ *************************************************************************************/
+void TrajectoryWriter::write(const Vectors &r) noexcept
+{
+    if (file == nullptr)
+        return;
+
+    if (header.encoding == static_cast<uint32_t>(TrajectoryFormat::Int16))
+    {
+        int16_t *out = reinterpret_cast<int16_t *>(frame.data());
+        const double inv = 1. / header.scale;
+
+        for (uint i = 0; i < header.N; i++)
+        {
+            for (uint j = 0; j < 3; j++)
+            {
+                const double q = std::round(r[j][i] * inv);
+                out[3 * i + j] = static_cast<int16_t>(std::fmax(-INT16_MAX, std::fmin(INT16_MAX, q)));
+            }
+        }
+    }
+    else
+    {
+        float *out = reinterpret_cast<float *>(frame.data());
+
+        for (uint i = 0; i < header.N; i++)
+        {
+            out[3 * i + 0] = static_cast<float>(r.x[i]);
+            out[3 * i + 1] = static_cast<float>(r.y[i]);
+            out[3 * i + 2] = static_cast<float>(r.z[i]);
+        }
+    }
+
+    std::fwrite(frame.data(), 1, frame.size(), file);
+    ++header.frames;
+}
+
+/**************************************************************************************
+ * Writes the current number of frames to the header and flushes the file, so it is
+ * complete up to this moment.
+ * @return Nothing to return.
+ *************************************************************************************/
+void TrajectoryWriter::flush() noexcept
+{
+    if (file == nullptr)
+        return;
+
+    const long end = std::ftell(file);
+
+    std::fseek(file, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, file);
+    std::fseek(file, end, SEEK_SET);
+    std::fflush(file);
+}
+
+/**************************************************************************************
+ * Writes the final number of frames to the header and closes the file.
+ * @return Nothing to return.
+ *************************************************************************************/
+void TrajectoryWriter::close() noexcept
+{
+    if (file == nullptr)
+        return;
+
+    std::fflush(file);
+    std::fseek(file, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, file);
+    std::fclose(file);
+    file = nullptr;
+}
+
+TrajectoryReader::TrajectoryReader() noexcept : file(nullptr), header{}
+{
+}
+
+TrajectoryReader::~TrajectoryReader() noexcept
+{
+    close();
+}
+
+/**************************************************************************************
+ * Opens the binary trajectory and checks its header.
+ * @param char* filename.
+ * @return True if the file is a valid trajectory.
+ *************************************************************************************/
+bool TrajectoryReader::open(const char *filename)
+{
+    close();
+
+    file = std::fopen(filename, "rb");
+
+    if (file == nullptr)
+        return false;
+
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+        header.version != Version)
+    {
+        close();
+        return false;
+    }
+
+    frame.resize(header.frameBytes);
+    return true;
+}
+
+/**************************************************************************************
+ * Reads the frame with the given index.
+ * @param uint64_t index of the frame (counted from 0),
+ * @param float* array of 3N coordinates to fill (x, y, z of every atom).
+ * @return True if the frame was read.
+ *************************************************************************************/
+bool TrajectoryReader::read(const uint64_t &index, float *xyz)
+{
+    if (file == nullptr || index >= header.frames)
+        return false;
+
+    const long offset = sizeof(TrajectoryHeader) + index * header.frameBytes;
+
+    if (std::fseek(file, offset, SEEK_SET) != 0 || std::fread(frame.data(), 1, frame.size(), file) != frame.size())
+        return false;
+
+    if (header.encoding == static_cast<uint32_t>(TrajectoryFormat::Int16))
+    {
+        const int16_t *in = reinterpret_cast<const int16_t *>(frame.data());
+
+        for (uint i = 0; i < 3 * header.N; i++)
+            xyz[i] = static_cast<float>(in[i] * header.scale);
+    }
+    else
+    {
+        std::memcpy(xyz, frame.data(), frame.size());
+    }
+
+    return true;
+}
+
+void TrajectoryReader::close() noexcept
+{
+    if (file != nullptr)
+        std::fclose(file);
+
+    file = nullptr;
+}
+
+/**************************************************************************************
+ * Writes a single frame of positions as XYZ text readable by Jmol. The precision of
+ * numbers is set by the stream.
+ * @param ostream output,
+ * @param Vectors positions of atoms.
+ * @return Nothing to return.
+ *************************************************************************************/
+void writeXYZFrame(std::ostream &out, const Vectors &r)
+{
+    // Number of atoms to read by Jmol
+    out << r.size();
+    out << "\n\n";
+
+    for (uint i = 0; i < r.size(); i++)
+    {
+        out << "AR\t";
+        out << r.x[i] << '\t' << r.y[i] << '\t' << r.z[i] << '\t';
+        out << '\n';
+    }
+
+    out << '\n';
+}
+
+/**************************************************************************************
+ * Converts the binary trajectory to the XYZ text in the same layout as the text
+ * output of Argon, so it may be viewed by Jmol.
+ * @param char* binary trajectory filename,
+ * @param char* XYZ text filename.
+ * @return True if all frames were converted.
+ *************************************************************************************/
+bool convertTrajectoryToXYZ(const char *binFilename, const char *xyzFilename)
+{
+    TrajectoryReader reader;
+
+    if (!reader.open(binFilename))
+    {
+        std::cerr << "`convertTrajectoryToXYZ()` :> Cannot read binary trajectory " << binFilename << '\n';
+        return false;
+    }
+
+    std::ofstream ofile(xyzFilename, std::ios::out);
+    ofile << std::fixed << std::setprecision(5);
+
+    const TrajectoryHeader &header = reader.getHeader();
+    std::vector<float> xyz(3 * header.N);
+
+    for (uint64_t f = 0; f < header.frames; f++)
+    {
+        if (!reader.read(f, xyz.data()))
+            return false;
+
+        ofile << header.N << "\n\n";
+
+        for (uint i = 0; i < header.N; i++)
+            ofile << "AR\t" << xyz[3 * i] << '\t' << xyz[3 * i + 1] << '\t' << xyz[3 * i + 2] << '\t' << '\n';
+
+        ofile << '\n';
+    }
+
+    std::cout << "`convertTrajectoryToXYZ()` :> Converted " << header.frames << " frames of " << header.N << " atoms.\n";
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+#include "vectors.h"
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <vector>
+typedef unsigned int uint;
+
+/// Formats of the file with positions from the whole simulation
+enum class TrajectoryFormat : unsigned short int
+{
+    Text,    ///< XYZ text readable by Jmol (reference)
+    Float32, ///< Binary frames of float coordinates
+    Int16,   ///< Binary frames of coordinates quantized to 16-bit integers
+};
+
+/// Header of the binary trajectory (64 bytes, little-endian). Frame i (counted from 0)
+/// starts at byte sizeof(TrajectoryHeader) + i * frameBytes and holds x, y, z of every
+/// atom one after another. Quantized coordinate is equal to the integer times `scale`.
+struct TrajectoryHeader
+{
+    char magic[8];       ///< "ARGONTRJ"
+    uint32_t version;    ///< Version of the format
+    uint32_t encoding;   ///< 1 - float32, 2 - int16 (values of TrajectoryFormat)
+    uint32_t N;          ///< Number of atoms
+    uint32_t frameBytes; ///< Size of the single frame
+    uint64_t frames;     ///< Number of frames
+    double dt;           ///< Time between frames
+    double L;            ///< Radius of sphere which confines atoms
+    double scale;        ///< Quantization step of int16 encoding
+    char reserved[8];    ///< Padding to 64 bytes
+};
+
+static_assert(sizeof(TrajectoryHeader) == 64, "Binary trajectory header must have 64 bytes");
+
+/// Writes binary trajectory with large buffered writes. The number of frames in the
+/// header is updated when the file is closed.
+class TrajectoryWriter
+{
+private:
+    std::FILE *file;              ///< Output file
+    TrajectoryHeader header;      ///< Header of the file
+    std::vector<char> frame;      ///< Encoded single frame
+    std::vector<char> fileBuffer; ///< Buffer of the stdio stream
+
+public:
+    TrajectoryWriter() noexcept;
+    ~TrajectoryWriter() noexcept;
+
+    TrajectoryWriter(const TrajectoryWriter &) = delete;
+    TrajectoryWriter &operator=(const TrajectoryWriter &) = delete;
+
+    bool open(const char *filename, const TrajectoryFormat &format, const uint &N, const double &dt, const double &L);
+    bool append(const char *filename, const uint64_t &frames);
+    void write(const Vectors &r) noexcept;
+    void flush() noexcept;
+    void close() noexcept;
+
+    bool isOpen() const noexcept { return file != nullptr; }
+    uint64_t getFrames() const noexcept { return header.frames; }
+};
+
+/// Random access to the frames of the binary trajectory.
+class TrajectoryReader
+{
+private:
+    std::FILE *file;         ///< Input file
+    TrajectoryHeader header; ///< Header of the file
+    std::vector<char> frame; ///< Encoded single frame
+
+public:
+    TrajectoryReader() noexcept;
+    ~TrajectoryReader() noexcept;
+
+    TrajectoryReader(const TrajectoryReader &) = delete;
+    TrajectoryReader &operator=(const TrajectoryReader &) = delete;
+
+    bool open(const char *filename);
+    bool read(const uint64_t &index, float *xyz);
+    void close() noexcept;
+
+    const TrajectoryHeader &getHeader() const noexcept { return header; }
+};
+
+void writeXYZFrame(std::ostream &out, const Vectors &r);
+bool convertTrajectoryToXYZ(const char *binFilename, const char *xyzFilename);
+
+#endif // TRAJECTORY_H
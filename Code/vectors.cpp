@@ -0,0 +1,131 @@
+#include "vectors.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+Vectors::Vectors() noexcept : N(0), stride(0), data(nullptr), x(nullptr), y(nullptr), z(nullptr)
+{
+}
+
+Vectors::Vectors(const uint &NVectors) : Vectors()
+{
+    resize(NVectors);
+}
+
+Vectors::~Vectors() noexcept
+{
+    std::free(data);
+}
+
+/**************************************************************************************
+ * Reallocates the buffer for the given number of vectors. All components, including
+ * padding, are set to zero.
+ * @param uint number of vectors.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Vectors::resize(const uint &NVectors)
+{
+    constexpr uint perLine = Alignment / sizeof(double);
+
+    std::free(data);
+
+    N = NVectors;
+    stride = (N + perLine - 1) / perLine * perLine;
+    if (stride == 0)
+        stride = perLine;
+
+    // aligned_alloc requires the size to be a multiple of the alignment which holds thanks to padding
+    data = static_cast<double *>(std::aligned_alloc(Alignment, 3 * stride * sizeof(double)));
+
+    if (data == nullptr)
+        throw std::bad_alloc();
+
+    x = data;
+    y = data + stride;
+    z = data + 2 * stride;
+
+    zero();
+}
+
+/**************************************************************************************
+ * Sets all components to zero.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Vectors::zero() noexcept
+{
+    std::memset(data, 0, 3 * stride * sizeof(double));
+}
+
+/**************************************************************************************
+ * Exchanges buffers with the other array (e.g. after gathering permuted vectors).
+ * @param Vectors other array.
+ * @return Nothing to return.
+ *************************************************************************************/
+void Vectors::swap(Vectors &other) noexcept
+{
+    std::swap(N, other.N);
+    std::swap(stride, other.stride);
+    std::swap(data, other.data);
+    std::swap(x, other.x);
+    std::swap(y, other.y);
+    std::swap(z, other.z);
+}
+
+VectorsF::VectorsF() noexcept : N(0), stride(0), data(nullptr), x(nullptr), y(nullptr), z(nullptr)
+{
+}
+
+VectorsF::VectorsF(const uint &NVectors) : VectorsF()
+{
+    resize(NVectors);
+}
+
+VectorsF::~VectorsF() noexcept
+{
+    std::free(data);
+}
+
+/**************************************************************************************
+ * Reallocates the buffer for the given number of vectors, all components (including
+ * padding) are set to zero.
+ * @param uint number of vectors.
+ * @return Nothing to return.
+ *************************************************************************************/
+void VectorsF::resize(const uint &NVectors)
+{
+    constexpr uint perLine = Vectors::Alignment / sizeof(float);
+
+    std::free(data);
+
+    N = NVectors;
+    stride = (N + perLine - 1) / perLine * perLine;
+    if (stride == 0)
+        stride = perLine;
+
+    data = static_cast<float *>(std::aligned_alloc(Vectors::Alignment, 3 * stride * sizeof(float)));
+
+    if (data == nullptr)
+        throw std::bad_alloc();
+
+    x = data;
+    y = data + stride;
+    z = data + 2 * stride;
+
+    std::memset(data, 0, 3 * stride * sizeof(float));
+}
+
+/**************************************************************************************
+ * Rounds the given vectors to single precision (sizes have to be the same).
+ * @param Vectors vectors in double precision.
+ * @return Nothing to return.
+ *************************************************************************************/
+void VectorsF::assign(const Vectors &v) noexcept
+{
+    for (uint i = 0; i < N; i++)
+    {
+        x[i] = static_cast<float>(v.x[i]);
+        y[i] = static_cast<float>(v.y[i]);
+        z[i] = static_cast<float>(v.z[i]);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef VECTORS_H
+#define VECTORS_H
+typedef unsigned int uint;
+
+/// Array of 3D vectors stored as structure of arrays. Components x, y and z are
+/// separate contiguous arrays in a single allocation, every one aligned to the cache
+/// line and padded to the multiple of `Vectors::Alignment` bytes, so loops over atoms
+/// may be vectorized and SIMD kernels may read whole registers past the last atom.
+class Vectors
+{
+private:
+    uint N;       ///< Number of vectors
+    uint stride;  ///< Distance (in doubles) between the beginnings of x, y and z arrays
+    double *data; ///< Single buffer with all components
+
+public:
+    static constexpr uint Alignment = 64; ///< Alignment of every component array in bytes
+
+    double *x; ///< First components
+    double *y; ///< Second components
+    double *z; ///< Third components
+
+    Vectors() noexcept;
+    explicit Vectors(const uint &N);
+    ~Vectors() noexcept;
+
+    Vectors(const Vectors &) = delete;
+    Vectors &operator=(const Vectors &) = delete;
+
+    void resize(const uint &N);
+    void zero() noexcept;
+    void swap(Vectors &other) noexcept;
+
+    /// Component array: 0 - x, 1 - y, 2 - z
+    double *operator[](const uint &k) const noexcept { return data + k * stride; }
+
+    uint size() const noexcept { return N; }
+    uint padded() const noexcept { return stride; }
+};
+
+/// Array of 3D vectors rounded to single precision (positions for the mixed precision
+/// pair kernels), with the same alignment and padding rules as `Vectors`.
+class VectorsF
+{
+private:
+    uint N;      ///< Number of vectors
+    uint stride; ///< Distance (in floats) between the beginnings of x, y and z arrays
+    float *data; ///< Single buffer with all components
+
+public:
+    float *x; ///< First components
+    float *y; ///< Second components
+    float *z; ///< Third components
+
+    VectorsF() noexcept;
+    explicit VectorsF(const uint &N);
+    ~VectorsF() noexcept;
+
+    VectorsF(const VectorsF &) = delete;
+    VectorsF &operator=(const VectorsF &) = delete;
+
+    void resize(const uint &N);
+    void assign(const Vectors &v) noexcept;
+
+    uint size() const noexcept { return N; }
+};
+
+#endif // VECTORS_H
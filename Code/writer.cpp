@@ -0,0 +1,169 @@
+#include "writer.h"
+#include "profile.h"
+#include <chrono>
+#include <cstring>
+
+AsyncWriter::AsyncWriter() noexcept : slots(nullptr), capacity(0), head(0), tail(0), count(0), stop(false),
+                                      rtText(nullptr), rtBinary(nullptr), htp(nullptr), blocked(0.)
+{
+}
+
+AsyncWriter::~AsyncWriter() noexcept
+{
+    finish();
+    delete[] slots;
+}
+
+/**************************************************************************************
+ * Allocates slots and starts the writer thread. Positions go to the binary writer if
+ * it is given, otherwise to the text file.
+ * @param uint number of slots,
+ * @param uint number of atoms,
+ * @param ofstream* text positions output,
+ * @param TrajectoryWriter* binary positions output,
+ * @param ofstream* H, T and P output.
+ * @return Nothing to return.
+ *************************************************************************************/
+void AsyncWriter::start(const uint &nSlots, const uint &N, std::ofstream *rtTextOut, TrajectoryWriter *rtBinaryOut,
+                        std::ofstream *htpOut)
+{
+    finish();
+
+    delete[] slots;
+    capacity = (nSlots < 2) ? 2 : nSlots;
+    slots = new Slot[capacity];
+
+    for (uint q = 0; q < capacity; q++)
+        slots[q].r.resize(N);
+
+    head = tail = count = 0;
+    stop = false;
+    blocked = 0.;
+    rtText = rtTextOut;
+    rtBinary = rtBinaryOut;
+    htp = htpOut;
+
+    worker = std::thread(&AsyncWriter::run, this);
+}
+
+/**************************************************************************************
+ * Waits for a free slot. Only the simulation thread writes to the slot at `tail`
+ * until it is published, so copying does not hold the lock.
+ * @return Free slot.
+ *************************************************************************************/
+AsyncWriter::Slot &AsyncWriter::acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (count == capacity)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        notFull.wait(lock, [this]
+                     { return count < capacity; });
+        blocked += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    return slots[tail];
+}
+
+void AsyncWriter::publish()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tail = (tail + 1) % capacity;
+        ++count;
+    }
+
+    notEmpty.notify_one();
+}
+
+void AsyncWriter::pushPositions(const Vectors &r)
+{
+    Slot &slot = acquire();
+
+    slot.positions = true;
+    for (uint j = 0; j < 3; j++)
+        std::memcpy(slot.r[j], r[j], r.size() * sizeof(double));
+
+    publish();
+}
+
+void AsyncWriter::pushHTP(const double &time, const double &H, const double &T, const double &P)
+{
+    Slot &slot = acquire();
+
+    slot.positions = false;
+    slot.time = time;
+    slot.H = H;
+    slot.T = T;
+    slot.P = P;
+
+    publish();
+}
+
+/**************************************************************************************
+ * Body of the writer thread: writes snapshots in the order of pushing until
+ * `finish()` is called and all snapshots are written.
+ * @return Nothing to return.
+ *************************************************************************************/
+void AsyncWriter::run()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this]
+                          { return count > 0 || stop; });
+
+            if (count == 0)
+                break;
+        }
+
+        const Slot &slot = slots[head];
+        ARGON_PROFILE_SCOPE(Phase::Writer);
+
+        if (!slot.positions)
+            *htp << slot.time << '\t' << slot.H << '\t' << slot.T << '\t' << slot.P << '\n';
+        else if (rtBinary != nullptr)
+            rtBinary->write(slot.r);
+        else if (rtText != nullptr)
+            writeXYZFrame(*rtText, slot.r);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            head = (head + 1) % capacity;
+            --count;
+        }
+
+        notFull.notify_one();
+    }
+}
+
+/**************************************************************************************
+ * Waits until all pushed snapshots are written (the writer thread keeps running).
+ * @return Nothing to return.
+ *************************************************************************************/
+void AsyncWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [this]
+                 { return count == 0; });
+}
+
+/**************************************************************************************
+ * Writes all remaining snapshots and stops the writer thread.
+ * @return Nothing to return.
+ *************************************************************************************/
+void AsyncWriter::finish() noexcept
+{
+    if (!worker.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+
+    notEmpty.notify_one();
+    worker.join();
+}
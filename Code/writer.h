@@ -0,0 +1,67 @@
+#ifndef WRITER_H
+#define WRITER_H
+#include "vectors.h"
+#include "trajectory.h"
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+typedef unsigned int uint;
+
+/// Background output stage. The simulation thread copies positions or H, T and P into
+/// a ring of preallocated slots and continues, while the writer thread formats and
+/// writes them. Memory is bounded by the number of slots; when all slots are full
+/// the simulation thread waits (backpressure) and the waiting time is measured.
+class AsyncWriter
+{
+private:
+    /// Single snapshot of the system
+    struct Slot
+    {
+        bool positions; ///< True for positions, false for H, T and P
+        Vectors r;      ///< Positions of atoms
+        double time;    ///< Time of H, T and P
+        double H;       ///< Hamiltonian
+        double T;       ///< Temperature
+        double P;       ///< Pressure
+    };
+
+    Slot *slots;   ///< Ring of snapshots
+    uint capacity; ///< Number of slots
+    uint head;     ///< Oldest snapshot to write
+    uint tail;     ///< First free slot
+    uint count;    ///< Number of snapshots waiting to write
+    bool stop;     ///< No more snapshots will come
+
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::thread worker;
+
+    std::ofstream *rtText;       ///< Text positions output (may be null)
+    TrajectoryWriter *rtBinary;  ///< Binary positions output (may be null)
+    std::ofstream *htp;          ///< H, T and P output
+    double blocked;              ///< Seconds which simulation thread spent waiting for a free slot
+
+    Slot &acquire();
+    void publish();
+    void run();
+
+public:
+    AsyncWriter() noexcept;
+    ~AsyncWriter() noexcept;
+
+    AsyncWriter(const AsyncWriter &) = delete;
+    AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+    void start(const uint &capacity, const uint &N, std::ofstream *rtText, TrajectoryWriter *rtBinary, std::ofstream *htp);
+    void pushPositions(const Vectors &r);
+    void pushHTP(const double &time, const double &H, const double &T, const double &P);
+    void flush();
+    void finish() noexcept;
+
+    bool running() const noexcept { return worker.joinable(); }
+    double getBlocked() const noexcept { return blocked; }
+};
+
+#endif // WRITER_H